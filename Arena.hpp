@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "common.h"
+
+// Bump allocator for objects that are all dropped at once, such as the syntax tree of a statement. Objects
+// are never destroyed, so they must not own memory of their own. reset() keeps the blocks for the next use,
+// so the memory held is that of the largest use so far.
+class Arena {
+   private:
+    static const size_t blockBytes = 64 * 1024;
+
+    MemorySubsystem subsystem;
+    vector<char*> blocks;
+    vector<size_t> blockSizes;
+    size_t current = 0;  // block being filled
+    size_t used = 0;     // bytes of it handed out
+
+    void* allocate(size_t bytes, size_t alignment) {
+        while (current < blocks.size()) {
+            size_t start = (used + alignment - 1) / alignment * alignment;
+            if (start + bytes <= blockSizes[current]) {
+                used = start + bytes;
+                return blocks[current] + start;
+            }
+            current++;
+            used = 0;
+        }
+        // malloc aligns for every fundamental type, an object larger than a block gets a block of its own
+        size_t size = bytes > blockBytes ? bytes : blockBytes;
+        PROFILE_ALLOCATION(subsystem, size);
+        blocks.push_back((char*)malloc(size));
+        blockSizes.push_back(size);
+        used = bytes;
+        return blocks.back();
+    }
+
+   public:
+    explicit Arena(MemorySubsystem subsystem) : subsystem(subsystem) {}
+    Arena(const Arena&) = delete;
+    void operator=(const Arena&) = delete;
+
+    template <typename T, typename... Arguments>
+    T* make(Arguments&&... arguments) {
+        return new (allocate(sizeof(T), alignof(T))) T(forward<Arguments>(arguments)...);
+    }
+
+    template <typename T>
+    T* makeArray(size_t count) {
+        T* array = (T*)allocate(sizeof(T) * (count > 0 ? count : 1), alignof(T));
+        for (size_t i = 0; i < count; i++) {
+            new (array + i) T();
+        }
+        return array;
+    }
+
+    char* copyText(const char* text) {
+        size_t bytes = strlen(text) + 1;
+        return (char*)memcpy(allocate(bytes, 1), text, bytes);
+    }
+
+    void reset() {
+        current = 0;
+        used = 0;
+    }
+};
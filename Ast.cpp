@@ -0,0 +1,199 @@
+#include "Ast.hpp"
+
+#include "Arena.hpp"
+#include "Profiler.hpp"
+
+// Line the lexer is on; nodes are built while their rule is reduced, so they get its line
+extern "C" int yylineno;
+
+// Hold the nodes, the semantic values and the token text of the top level statement being parsed, reset once it
+// is lowered
+static Arena astArena(MEMORY_AST);
+static Arena valueArena(MEMORY_PARSER_VALUES);
+static Arena tokenTextArena(MEMORY_LEXER);
+
+// Statements of a top level statement are collected in the block of their scope; the top level block only
+// ever holds the statement that was just parsed
+static AstBlock topLevelBlock;
+static vector<AstBlock*> openBlocks = {&topLevelBlock};
+
+template <typename T, typename... Arguments>
+static T* makeNode(Arguments&&... arguments) {
+    T* node = astArena.make<T>(forward<Arguments>(arguments)...);
+    node->line = yylineno;
+    return node;
+}
+
+static void appendStatement(AstBlock* block, AstNode* statement) {
+    if (block->last == nullptr) {
+        block->first = statement;
+    } else {
+        block->last->next = statement;
+    }
+    block->last = statement;
+}
+
+bool lowerTopLevelStatements() {
+    if (openBlocks.size() != 1) {
+        return false;
+    }
+    PROFILE_SCOPE(PHASE_IR);
+    for (const AstNode* statement = topLevelBlock.first; statement != nullptr; statement = statement->next) {
+        // --emit-interface compiles a module, whose functions are all there is to link
+        if (compilerOptions.emitInterface && statement->kind != AST_FUNCTION) {
+            exitOnError("A module can only define functions", statement->line);
+        }
+        lowerStatement(statement);
+    }
+    topLevelBlock.first = topLevelBlock.last = nullptr;
+    astArena.reset();
+    valueArena.reset();
+    tokenTextArena.reset();
+    return true;
+}
+
+extern "C" {
+
+ExprValue* allocateExprValue() {
+    return valueArena.make<ExprValue>();
+}
+
+char* copyParserText(const char* text) {
+    return valueArena.copyText(text);
+}
+
+char* copyLexerText(const char* text) {
+    return tokenTextArena.copyText(text);
+}
+
+void* createNameNode(const char* name) {
+    AstName* node = makeNode<AstName>();
+    node->name = name;
+    return node;
+}
+
+void* createBinaryNode(const char* op, void* left, void* right) {
+    AstBinary* node = makeNode<AstBinary>();
+    node->op = op;
+    node->left = (AstNode*)left;
+    node->right = (AstNode*)right;
+    return node;
+}
+
+void* createLogicalNode(const char* op, void* left, void* right) {
+    AstBinary* node = (AstBinary*)createBinaryNode(op, left, right);
+    node->kind = AST_LOGICAL;
+    return node;
+}
+
+void* createNegateNode(void* operand) {
+    AstNegate* node = makeNode<AstNegate>();
+    node->operand = (AstNode*)operand;
+    return node;
+}
+
+void* createCallNode(void* function, void* paramList) {
+    vector<Parameter>* params = (vector<Parameter>*)paramList;
+    AstCall* node = makeNode<AstCall>();
+    node->function = (Function*)function;
+    node->argumentCount = params->size();
+    node->arguments = astArena.makeArray<AstNode*>(params->size());
+    for (size_t i = 0; i < params->size(); i++) {
+        node->arguments[i] = (AstNode*)(*params)[i].node;
+    }
+    delete params;
+    return node;
+}
+
+void* createAssignNode(const char* variable, void* value) {
+    AstAssign* node = makeNode<AstAssign>();
+    node->variable = variable;
+    node->value = (AstNode*)value;
+    return node;
+}
+
+void* createIfNode(void* condition, void* body, void* elseBody) {
+    AstConditional* node = makeNode<AstConditional>(AST_IF);
+    node->condition = (AstNode*)condition;
+    node->body = (AstNode*)body;
+    node->elseBody = (AstNode*)elseBody;
+    return node;
+}
+
+void* createWhileNode(void* condition, void* body) {
+    AstConditional* node = makeNode<AstConditional>(AST_WHILE);
+    node->condition = (AstNode*)condition;
+    node->body = (AstNode*)body;
+    return node;
+}
+
+void* createRepeatNode(void* body, void* condition) {
+    AstConditional* node = makeNode<AstConditional>(AST_REPEAT);
+    node->condition = (AstNode*)condition;
+    node->body = (AstNode*)body;
+    return node;
+}
+
+void* createForNode(void* initialization, void* condition, void* step, void* body) {
+    AstConditional* node = makeNode<AstConditional>(AST_FOR);
+    node->initialization = (AstNode*)initialization;
+    node->condition = (AstNode*)condition;
+    node->step = (AstNode*)step;
+    node->body = (AstNode*)body;
+    return node;
+}
+
+void* createSwitchNode(void* value, void* switchCaseList) {
+    vector<SwitchCaseMetadata>* switchCases = (vector<SwitchCaseMetadata>*)switchCaseList;
+    AstSwitch* node = makeNode<AstSwitch>();
+    node->value = (AstNode*)value;
+    node->armCount = switchCases->size();
+    node->arms = astArena.makeArray<AstSwitchArm>(switchCases->size());
+    for (size_t i = 0; i < switchCases->size(); i++) {
+        const SwitchCaseMetadata& switchCase = (*switchCases)[i];
+        node->arms[i].type = switchCase.type;
+        node->arms[i].value = astArena.copyText(switchCase.value.c_str());
+        node->arms[i].line = switchCase.line;
+        node->arms[i].body = (AstNode*)switchCase.body;
+    }
+    delete switchCases;
+    node->function = FunctionContextSingleton::getCurrentFunction();
+    return node;
+}
+
+void* createFunctionNode(void* function, void* body) {
+    AstFunction* node = makeNode<AstFunction>();
+    node->function = (Function*)function;
+    node->body = (AstNode*)body;
+    return node;
+}
+
+void* createReturnNode(void* value) {
+    AstReturn* node = makeNode<AstReturn>();
+    node->value = (AstNode*)value;
+    return node;
+}
+
+void* createImportNode(void* module) {
+    AstImport* node = makeNode<AstImport>();
+    node->module = (ImportedModule*)module;
+    return node;
+}
+
+void openBlock() {
+    openBlocks.push_back(makeNode<AstBlock>());
+}
+
+void* closeBlock() {
+    AstBlock* block = openBlocks.back();
+    openBlocks.pop_back();
+    return block;
+}
+
+void addStatementToCurrentBlock(void* statement) {
+    // declarations without a value have nothing to lower
+    if (statement != nullptr) {
+        appendStatement(openBlocks.back(), (AstNode*)statement);
+    }
+}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "SymbolTable.hpp"
+
+struct ImportedModule;
+
+// Syntax tree built by the parser actions once the semantic checks of a rule passed. Nodes live in an arena
+// that is reset after every top level statement is lowered, so they only point to memory that lives as long as
+// them, the names and literals of the statement, and to the symbols of the symbol table.
+enum AstKind {
+    AST_NAME,     // a variable or a literal, used as is by the quadruples
+    AST_BINARY,   // arithmetic and comparison operators
+    AST_NEGATE,
+    AST_LOGICAL,  // AND / OR, jumping code when used as a condition
+    AST_CALL,
+    AST_ASSIGN,
+    AST_BLOCK,
+    AST_IF,
+    AST_WHILE,
+    AST_REPEAT,
+    AST_FOR,
+    AST_SWITCH,
+    AST_FUNCTION,
+    AST_RETURN,
+    AST_IMPORT    // links the quadruples of a module into the program
+};
+
+struct AstNode {
+    AstKind kind;
+    int line = 0;             // line the parser was on when the node was built, which its quadruples are tagged with
+    AstNode* next = nullptr;  // next statement of the same block
+
+    explicit AstNode(AstKind kind) : kind(kind) {}
+};
+
+struct AstName : AstNode {
+    const char* name = nullptr;
+    AstName() : AstNode(AST_NAME) {}
+};
+
+// Also AND / OR, which keep their operator name
+struct AstBinary : AstNode {
+    const char* op = nullptr;  // quadruple operator
+    AstNode* left = nullptr;
+    AstNode* right = nullptr;
+    AstBinary() : AstNode(AST_BINARY) {}
+};
+
+struct AstNegate : AstNode {
+    AstNode* operand = nullptr;
+    AstNegate() : AstNode(AST_NEGATE) {}
+};
+
+struct AstCall : AstNode {
+    Function* function = nullptr;
+    AstNode** arguments = nullptr;
+    int argumentCount = 0;
+    AstCall() : AstNode(AST_CALL) {}
+};
+
+struct AstAssign : AstNode {
+    const char* variable = nullptr;
+    AstNode* value = nullptr;
+    AstAssign() : AstNode(AST_ASSIGN) {}
+};
+
+struct AstBlock : AstNode {
+    AstNode* first = nullptr;
+    AstNode* last = nullptr;
+    AstBlock() : AstNode(AST_BLOCK) {}
+};
+
+// Also WHILE and REPEAT, which have no initialization, step or else branch
+struct AstConditional : AstNode {
+    AstNode* condition = nullptr;
+    AstNode* body = nullptr;
+    AstNode* elseBody = nullptr;        // IF only, null without an else
+    AstNode* initialization = nullptr;  // FOR only, null when it is empty
+    AstNode* step = nullptr;            // FOR only
+    explicit AstConditional(AstKind kind) : AstNode(kind) {}
+};
+
+struct AstSwitchArm {
+    Type type = INTEGER_T;
+    const char* value = nullptr;  // case value as written in the quadruples
+    int line = 0;                 // line of the case value
+    AstNode* body = nullptr;
+};
+
+struct AstSwitch : AstNode {
+    AstNode* value = nullptr;
+    AstSwitchArm* arms = nullptr;  // in source order
+    int armCount = 0;
+    Function* function = nullptr;  // function the switch is in, the -fprofile-use counts are keyed by it
+    AstSwitch() : AstNode(AST_SWITCH) {}
+};
+
+struct AstFunction : AstNode {
+    Function* function = nullptr;
+    AstNode* body = nullptr;
+    AstFunction() : AstNode(AST_FUNCTION) {}
+};
+
+struct AstReturn : AstNode {
+    AstNode* value = nullptr;  // null for a return without a value
+    AstReturn() : AstNode(AST_RETURN) {}
+};
+
+struct AstImport : AstNode {
+    ImportedModule* module = nullptr;
+    AstImport() : AstNode(AST_IMPORT) {}
+};
+
+// Emits the quadruples of a top level statement at the end of the main quadruple manager, in their final order
+void lowerStatement(const AstNode* statement);
+// Lowers the statement the parser just finished and drops its nodes, false while it is nested in a scope
+bool lowerTopLevelStatements();
@@ -0,0 +1,276 @@
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "ThreadPool.hpp"
+#include "Vendor/VariadicTable.h"
+#include "common.h"
+
+// The parser and the scanner generated by bison and flex, the symbol tables, the quadruples and the syntax tree
+// arenas are global to the process and a semantic error exits it, so programs cannot be compiled on threads of one
+// process. Every program is compiled by a fork of the batch process instead: it starts from the compiler state as
+// it was before anything was compiled, gets a heap of its own and can be killed when it runs out of time. The batch
+// process never starts a thread, so a fork cannot copy a lock another thread held; the children run side by side
+// and the parent waits on all of their pipes at once.
+enum BatchStatus {
+    BATCH_PASSED,
+    BATCH_COMPILE_ERROR,
+    BATCH_RUNTIME_ERROR,
+    BATCH_OVER_BUDGET,
+    BATCH_TIMED_OUT,
+    BATCH_CRASHED,
+    BATCH_STATUS_COUNT
+};
+
+static const char* const statusNames[BATCH_STATUS_COUNT] = {"passed",      "compile error", "runtime error",
+                                                            "over budget", "timed out",     "crashed"};
+
+struct BatchResult {
+    string path;
+    BatchStatus status = BATCH_PASSED;
+    int exitCode = 0;
+    double milliseconds = 0;  // from the fork until the child was reaped
+    string output;            // what the child wrote to stdout and stderr
+};
+
+// A program whose child has not been reaped yet
+struct RunningChild {
+    BatchResult* result;
+    pid_t pid;
+    int output;  // read end of the pipe the child writes to
+    chrono::steady_clock::time_point start;
+};
+
+// Output kept per program; the rest is still read, so the child never blocks on a full pipe
+static const size_t maxOutput = 64 * 1024;
+
+// Paths are relative to the directory of the list; empty lines and lines starting with # are skipped
+static bool readProgramList(const string& listFileName, vector<string>& programs) {
+    ifstream list(listFileName);
+    if (!list) {
+        return false;
+    }
+    size_t slash = listFileName.find_last_of("/\\");
+    string directory = slash == string::npos ? "" : listFileName.substr(0, slash + 1);
+    for (string line; getline(list, line);) {
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        line.erase(0, line.find_first_not_of(" \t"));
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        programs.push_back(line[0] == '/' ? line : directory + line);
+    }
+    return true;
+}
+
+static double millisecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// False when no child could be started, the result then says why
+static bool startChild(BatchResult& result, int (*compileFile)(const char* fileName), RunningChild& child) {
+    int pipeEnds[2];
+    if (pipe(pipeEnds) != 0) {
+        result.status = BATCH_CRASHED;
+        result.output = "Error: Unable to create a pipe\n";
+        return false;
+    }
+    child.start = chrono::steady_clock::now();
+    child.pid = fork();
+    if (child.pid == 0) {
+        dup2(pipeEnds[1], STDOUT_FILENO);
+        dup2(pipeEnds[1], STDERR_FILENO);
+        close(pipeEnds[0]);
+        close(pipeEnds[1]);
+        exitCompiler(compileFile(result.path.c_str()));
+    }
+    close(pipeEnds[1]);
+    if (child.pid < 0) {
+        close(pipeEnds[0]);
+        result.status = BATCH_CRASHED;
+        result.output = "Error: Unable to fork\n";
+        return false;
+    }
+    child.result = &result;
+    child.output = pipeEnds[0];
+    return true;
+}
+
+// Reaps a child whose pipe was closed, or which is killed when it timed out
+static void finishChild(const RunningChild& child, bool timedOut) {
+    BatchResult& result = *child.result;
+    close(child.output);
+    if (timedOut) {
+        kill(child.pid, SIGKILL);
+    }
+    int status = 0;
+    while (waitpid(child.pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    result.milliseconds = millisecondsSince(child.start);
+
+    if (timedOut) {
+        result.status = BATCH_TIMED_OUT;
+        result.exitCode = -1;
+    } else if (WIFSIGNALED(status)) {
+        result.status = BATCH_CRASHED;
+        result.exitCode = 128 + WTERMSIG(status);
+    } else {
+        result.exitCode = WEXITSTATUS(status);
+        // the interpreter reports every runtime error as "Line <n> Runtime Error: <reason>"
+        if (result.exitCode == 0) {
+            result.status = BATCH_PASSED;
+        } else if (result.output.find("Runtime Error: instruction budget") != string::npos) {
+            result.status = BATCH_OVER_BUDGET;
+        } else if (result.output.find("Runtime Error: ") != string::npos) {
+            result.status = BATCH_RUNTIME_ERROR;
+        } else {
+            result.status = BATCH_COMPILE_ERROR;
+        }
+    }
+}
+
+// Keeps up to jobs children running until every program finished
+static void runChildren(vector<BatchResult>& results, unsigned jobs, int (*compileFile)(const char* fileName)) {
+    vector<RunningChild> running;
+    size_t next = 0;
+    char buffer[4096];
+    while (next < results.size() || !running.empty()) {
+        while (running.size() < jobs && next < results.size()) {
+            RunningChild child;
+            if (startChild(results[next++], compileFile, child)) {
+                running.push_back(child);
+            }
+        }
+        if (running.empty()) {
+            continue;
+        }
+
+        // wake up for output, or for the first deadline
+        vector<struct pollfd> readable;
+        int wait = -1;
+        for (const RunningChild& child : running) {
+            readable.push_back({child.output, POLLIN, 0});
+            if (compilerOptions.timeoutMs > 0) {
+                int left = (int)ceil(compilerOptions.timeoutMs - millisecondsSince(child.start));
+                wait = wait < 0 ? max(left, 0) : min(wait, max(left, 0));
+            }
+        }
+        if (poll(readable.data(), readable.size(), wait) < 0 && errno != EINTR) {
+            break;
+        }
+
+        vector<RunningChild> stillRunning;
+        for (size_t i = 0; i < running.size(); i++) {
+            RunningChild& child = running[i];
+            bool closed = false;
+            if (readable[i].revents != 0) {
+                ssize_t count = read(child.output, buffer, sizeof(buffer));
+                if (count > 0) {
+                    string& output = child.result->output;
+                    if (output.size() < maxOutput) {
+                        output.append(buffer, min<size_t>(count, maxOutput - output.size()));
+                    }
+                } else if (count == 0 || errno != EINTR) {
+                    closed = true;
+                }
+            }
+            bool timedOut = !closed && compilerOptions.timeoutMs > 0 && millisecondsSince(child.start) >= compilerOptions.timeoutMs;
+            if (closed || timedOut) {
+                finishChild(child, timedOut);
+            } else {
+                stillRunning.push_back(child);
+            }
+        }
+        running.swap(stillRunning);
+    }
+}
+
+static string formatMilliseconds(double milliseconds) {
+    ostringstream text;
+    text << fixed << setprecision(2) << milliseconds;
+    return text.str();
+}
+
+// Nearest rank percentile of sorted latencies
+static double percentile(const vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = (size_t)ceil(fraction * sorted.size());
+    return sorted[max<size_t>(rank, 1) - 1];
+}
+
+static void writeBatchReport(ostream& out, const vector<BatchResult>& results) {
+    VariadicTable<string, string, int, string> table({"Program", "Status", "Exit", "Time (ms)"});
+    for (const BatchResult& result : results) {
+        table.addRow(result.path, statusNames[result.status], result.exitCode, formatMilliseconds(result.milliseconds));
+    }
+    table.print(out);
+    for (const BatchResult& result : results) {
+        out << "\n--- " << result.path << " (" << statusNames[result.status] << ")\n" << result.output;
+        if (!result.output.empty() && result.output.back() != '\n') {
+            out << "\n";
+        }
+    }
+}
+
+extern "C" {
+
+int runBatch(const char* listFileName, int (*compileFile)(const char* fileName)) {
+    vector<string> programs;
+    if (!readProgramList(listFileName, programs)) {
+        printf("Error: Unable to open program list %s\n", listFileName);
+        return 1;
+    }
+    vector<BatchResult> results(programs.size());
+    for (size_t i = 0; i < programs.size(); i++) {
+        results[i].path = programs[i];
+    }
+
+    unsigned jobs = compilerOptions.jobs > 0 ? (unsigned)compilerOptions.jobs : ThreadPool::defaultThreadCount();
+    jobs = max<size_t>(1, min<size_t>(jobs, programs.size()));
+    // -j is spent on running programs side by side, each one compiles on a single thread
+    compilerOptions.jobs = 1;
+    // a child inherits what is still buffered and would write it again
+    fflush(NULL);
+
+    auto start = chrono::steady_clock::now();
+    runChildren(results, jobs, compileFile);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    char* reportFileName = getOutputFileName(listFileName, "_batch.txt");
+    ofstream report(reportFileName);
+    writeBatchReport(report, results);
+
+    size_t counts[BATCH_STATUS_COUNT] = {};
+    vector<double> latencies;
+    for (const BatchResult& result : results) {
+        counts[result.status]++;
+        latencies.push_back(result.milliseconds);
+    }
+    sort(latencies.begin(), latencies.end());
+    printf("Ran %zu programs, %u at a time, in %.3f s", results.size(), jobs, seconds);
+    for (int status = 0; status < BATCH_STATUS_COUNT; status++) {
+        if (counts[status] > 0 || status == BATCH_PASSED) {
+            printf("%s %s: %zu", status == BATCH_PASSED ? "," : ";", statusNames[status], counts[status]);
+        }
+    }
+    printf("\n%.1f programs/s, latency p50 %s ms, p99 %s ms\n", seconds > 0 ? results.size() / seconds : 0.0,
+           formatMilliseconds(percentile(latencies, 0.5)).c_str(), formatMilliseconds(percentile(latencies, 0.99)).c_str());
+    printf("Results and outputs written to %s\n", reportFileName);
+    free(reportFileName);
+    return counts[BATCH_PASSED] == results.size() ? 0 : 1;
+}
+}
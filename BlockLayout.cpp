@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+#include "BranchProfile.hpp"
+#include "OptimizationPasses.hpp"
+
+// Weight of an edge that needs no jump at all, kept before any counted one
+static const long long fallThroughOnly = numeric_limits<long long>::max();
+
+struct LayoutBlock {
+    size_t begin = 0;  // quadruples [begin, end) of the unit
+    size_t end = 0;
+    string label;          // empty when the block starts without one
+    int taken = -1;        // block the last quadruple jumps to, -1 for none
+    int fallThrough = -1;  // block reached when it does not jump, the exit block after the last block
+    long long takenWeight = 0;
+    long long fallThroughWeight = 0;
+};
+
+struct LayoutEdge {
+    long long weight;
+    int from;
+    int to;
+};
+
+// A nested function is found by the position of its label and ENTER, which layout would break apart
+static bool canLayOut(const FunctionUnit& unit) {
+    if (unit.hasExternalJumps) {
+        return false;
+    }
+    for (size_t i = 0; i < unit.quadruples.size(); i++) {
+        if (unit.quadruples[i].getOp() == "ENTER" && !(unit.isFunction() && i == 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isBranch(const Quadruple& quad) {
+    return quad.getOp() == "JF" || quad.getOp() == "JT";
+}
+
+// Blocks start at labels and after jumps; a SWITCH ends its block after the JTAB entries that follow it
+static vector<LayoutBlock> splitIntoBlocks(const vector<Quadruple>& quads) {
+    vector<LayoutBlock> blocks;
+    size_t i = 0;
+    while (i < quads.size()) {
+        LayoutBlock block;
+        block.begin = i;
+        if (quads[i].isLabel()) {
+            block.label = quads[i].getOp();
+        }
+        while (i < quads.size()) {
+            const Quadruple& quad = quads[i];
+            if (i > block.begin && quad.isLabel()) {
+                break;
+            }
+            i++;
+            if (quad.getOp() == "SWITCH") {
+                while (i < quads.size() && quads[i].getOp() == "JTAB") {
+                    i++;
+                }
+                break;
+            }
+            if (quad.isJump()) {
+                break;
+            }
+        }
+        block.end = i;
+        blocks.push_back(block);
+    }
+    return blocks;
+}
+
+string ProfileGuidedLayoutPass::getName() const {
+    return "profile-guided-layout";
+}
+
+bool ProfileGuidedLayoutPass::run(FunctionUnit& unit) {
+    const BranchProfile& profile = getBranchProfile();
+    vector<Quadruple>& quads = unit.quadruples;
+    if (profile.isEmpty() || !canLayOut(unit)) {
+        return false;
+    }
+    vector<LayoutBlock> blocks = splitIntoBlocks(quads);
+    const int exitBlock = blocks.size();  // the end of the unit, always placed last
+    unordered_map<string, int> blockOf;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        if (!blocks[b].label.empty()) {
+            blockOf[blocks[b].label] = b;
+        }
+    }
+
+    // jumps are matched with the profile by their function, line and order on the line
+    Function* function = unit.isFunction() ? getFunctionByLabel(unit.label) : nullptr;
+    vector<string> lineKeys(quads.size());
+    unordered_map<string, size_t> jumpsOnLine;
+    for (size_t i = 0; i < quads.size(); i++) {
+        if (quads[i].getOp() == "JMP" || isBranch(quads[i])) {
+            lineKeys[i] = BranchProfile::getLineKey(function, quads[i].getLine());
+            jumpsOnLine[lineKeys[i]]++;
+        }
+    }
+    unordered_map<string, size_t> jumpIndex;
+    bool hasCounts = false;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        LayoutBlock& block = blocks[b];
+        const Quadruple& last = quads[block.end - 1];
+        bool jumps = last.getOp() == "JMP" || isBranch(last);
+        if (jumps) {
+            auto target = blockOf.find(last.getJumpTarget());
+            block.taken = target == blockOf.end() ? -1 : target->second;
+            const JumpCounts* counts = profile.getJump(lineKeys[block.end - 1], jumpIndex[lineKeys[block.end - 1]]++,
+                                                       jumpsOnLine[lineKeys[block.end - 1]]);
+            if (counts != nullptr) {
+                block.takenWeight = counts->taken;
+                block.fallThroughWeight = counts->fallThrough;
+                hasCounts = true;
+            }
+        }
+        if (!last.isJump() && last.getOp() != "JTAB") {
+            block.fallThrough = b + 1;
+            block.fallThroughWeight = fallThroughOnly;
+        } else if (isBranch(last)) {
+            block.fallThrough = b + 1;
+        }
+    }
+    if (!hasCounts) {
+        return false;
+    }
+
+    // chains grow along the heaviest edges from the tail of one chain to the head of another
+    vector<LayoutEdge> edges;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        if (blocks[b].taken >= 0 && blocks[b].takenWeight > 0) {
+            edges.push_back({blocks[b].takenWeight, (int)b, blocks[b].taken});
+        }
+        if (blocks[b].fallThrough >= 0 && blocks[b].fallThrough != exitBlock && blocks[b].fallThroughWeight > 0) {
+            edges.push_back({blocks[b].fallThroughWeight, (int)b, blocks[b].fallThrough});
+        }
+    }
+    stable_sort(edges.begin(), edges.end(), [](const LayoutEdge& a, const LayoutEdge& b) { return a.weight > b.weight; });
+    // then the edges that never ran keep their original fall through, so cold code stays in one piece
+    for (size_t b = 0; b + 1 < blocks.size(); b++) {
+        if (blocks[b].fallThrough == (int)b + 1 && blocks[b].fallThroughWeight == 0) {
+            edges.push_back({0, (int)b, (int)b + 1});
+        }
+    }
+
+    vector<vector<int>> chains(blocks.size());
+    vector<int> chainOf(blocks.size());
+    for (size_t b = 0; b < blocks.size(); b++) {
+        chains[b] = {(int)b};
+        chainOf[b] = b;
+    }
+    for (const LayoutEdge& edge : edges) {
+        int from = chainOf[edge.from];
+        int to = chainOf[edge.to];
+        // the entry block stays the first block of the unit, so chain 0 is the one that starts with it
+        if (from == to || edge.to == 0 || chains[from].back() != edge.from || chains[to].front() != edge.to) {
+            continue;
+        }
+        for (int block : chains[to]) {
+            chains[from].push_back(block);
+            chainOf[block] = from;
+        }
+        chains[to].clear();
+    }
+
+    // the entry chain first, then the other chains by how often they are entered, the chain that falls off the
+    // end of the unit last
+    vector<long long> heat(blocks.size(), 0);
+    for (size_t b = 0; b < blocks.size(); b++) {
+        if (blocks[b].taken >= 0) {
+            heat[chainOf[blocks[b].taken]] = max(heat[chainOf[blocks[b].taken]], blocks[b].takenWeight);
+        }
+        if (blocks[b].fallThrough >= 0 && blocks[b].fallThrough != exitBlock && blocks[b].fallThroughWeight != fallThroughOnly) {
+            heat[chainOf[blocks[b].fallThrough]] = max(heat[chainOf[blocks[b].fallThrough]], blocks[b].fallThroughWeight);
+        }
+    }
+    vector<int> order;
+    for (size_t c = 1; c < chains.size(); c++) {
+        if (!chains[c].empty()) {
+            order.push_back(c);
+        }
+    }
+    auto fallsOffEnd = [&](int chain) { return blocks[chains[chain].back()].fallThrough == exitBlock; };
+    stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        if (fallsOffEnd(a) != fallsOffEnd(b)) {
+            return fallsOffEnd(b);
+        }
+        return heat[a] > heat[b];
+    });
+    order.insert(order.begin(), 0);
+    vector<int> layout;
+    for (int chain : order) {
+        layout.insert(layout.end(), chains[chain].begin(), chains[chain].end());
+    }
+
+    // labels for the blocks that become jump targets, named after the first label of the unit
+    string labelPrefix = "L";
+    for (const LayoutBlock& block : blocks) {
+        if (!block.label.empty()) {
+            labelPrefix = block.label.substr(0, block.label.size() - 1);
+            break;
+        }
+    }
+    vector<string> labels(blocks.size() + 1);
+    for (size_t b = 0; b < blocks.size(); b++) {
+        labels[b] = blocks[b].label;
+    }
+    int freshLabels = 0;
+    auto labelOf = [&](int block) {
+        if (labels[block].empty()) {
+            labels[block] = labelPrefix + "_" + to_string(freshLabels++) + ":";
+        }
+        return labels[block];
+    };
+
+    vector<vector<Quadruple>> code(blocks.size());
+    long long inverted = 0;
+    long long moved = 0;
+    for (size_t position = 0; position < layout.size(); position++) {
+        int b = layout[position];
+        const LayoutBlock& block = blocks[b];
+        int next = position + 1 < layout.size() ? layout[position + 1] : exitBlock;
+        moved += b != (int)position;
+        vector<Quadruple>& out = code[b];
+        out.assign(quads.begin() + block.begin, quads.begin() + block.end);
+        Quadruple& last = out.back();
+        int line = last.getLine();
+        if (last.getOp() == "JMP") {
+            if (block.taken == next) {
+                out.pop_back();
+            }
+        } else if (isBranch(last)) {
+            if (block.fallThrough != next && block.taken == next) {
+                last = Quadruple(last.getOp() == "JF" ? "JT" : "JF", last.getArg1(), "", labelOf(block.fallThrough), line);
+                inverted++;
+            } else if (block.fallThrough != next) {
+                out.push_back(Quadruple("JMP", "", "", labelOf(block.fallThrough), line));
+            }
+        } else if (block.fallThrough >= 0 && block.fallThrough != next) {
+            out.push_back(Quadruple("JMP", "", "", labelOf(block.fallThrough), line));
+        }
+    }
+
+    vector<Quadruple> laidOut;
+    for (int b : layout) {
+        if (blocks[b].label.empty() && !labels[b].empty()) {
+            laidOut.push_back(Quadruple(labels[b], "", "", "", quads[blocks[b].begin].getLine()));
+        }
+        laidOut.insert(laidOut.end(), code[b].begin(), code[b].end());
+    }
+    if (!labels[exitBlock].empty()) {
+        laidOut.push_back(Quadruple(labels[exitBlock], "", "", "", quads.back().getLine()));
+    }
+    if (moved == 0 && inverted == 0 && laidOut.size() == quads.size()) {
+        return false;
+    }
+    movedBlocks += moved;
+    invertedJumps += inverted;
+    quads = laidOut;
+    return true;
+}
+
+string ProfileGuidedLayoutPass::getSummary() const {
+    return to_string(movedBlocks) + " blocks moved, " + to_string(invertedJumps) + " conditional jumps inverted";
+}
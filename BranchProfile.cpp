@@ -0,0 +1,112 @@
+#include "BranchProfile.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "common.h"
+
+string BranchProfile::getLineKey(Function* function, int line) {
+    if (function == nullptr) {
+        return "global " + to_string(line);
+    }
+    return function->getName() + " " + to_string(line - function->getLine());
+}
+
+void BranchProfile::addJump(const string& lineKey, const JumpCounts& counts) {
+    lines[lineKey].jumps.push_back(counts);
+}
+
+void BranchProfile::setLabelEntries(const string& lineKey, long long entries) {
+    LineCounts& counts = lines[lineKey];
+    counts.labelEntries = entries;
+    counts.hasLabel = true;
+}
+
+bool BranchProfile::isEmpty() const {
+    return lines.empty();
+}
+
+const JumpCounts* BranchProfile::getJump(const string& lineKey, size_t index, size_t jumpsOnLine) const {
+    auto it = lines.find(lineKey);
+    if (it == lines.end() || it->second.jumps.size() != jumpsOnLine || index >= jumpsOnLine) {
+        return nullptr;
+    }
+    return &it->second.jumps[index];
+}
+
+long long BranchProfile::getLabelEntries(const string& lineKey) const {
+    auto it = lines.find(lineKey);
+    return it == lines.end() ? 0 : it->second.labelEntries;
+}
+
+// One record per line:
+//     jump <function> <line> <taken> <fall through>
+//     label <function> <line> <entries>
+bool BranchProfile::read(istream& in) {
+    for (string text; getline(in, text);) {
+        if (text.empty() || text[0] == '#') {
+            continue;
+        }
+        istringstream record(text);
+        string kind, function;
+        int line;
+        if (!(record >> kind >> function >> line)) {
+            return false;
+        }
+        string lineKey = function + " " + to_string(line);
+        if (kind == "jump") {
+            JumpCounts counts;
+            if (!(record >> counts.taken >> counts.fallThrough)) {
+                return false;
+            }
+            addJump(lineKey, counts);
+        } else if (kind == "label") {
+            long long entries;
+            if (!(record >> entries)) {
+                return false;
+            }
+            setLabelEntries(lineKey, entries);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BranchProfile::write(ostream& out) const {
+    vector<string> keys;
+    for (const auto& line : lines) {
+        keys.push_back(line.first);
+    }
+    sort(keys.begin(), keys.end());
+    out << "# jump <function> <line> <taken> <fall through>, label <function> <line> <entries>\n";
+    for (const string& key : keys) {
+        const LineCounts& counts = lines.at(key);
+        for (const JumpCounts& jump : counts.jumps) {
+            out << "jump " << key << " " << jump.taken << " " << jump.fallThrough << "\n";
+        }
+        if (counts.hasLabel) {
+            out << "label " << key << " " << counts.labelEntries << "\n";
+        }
+    }
+}
+
+static BranchProfile* loadBranchProfile() {
+    BranchProfile* profile = new BranchProfile();
+    const char* path = compilerOptions.profileUsePath;
+    if (path != nullptr) {
+        ifstream in(path);
+        if (!in || !profile->read(in)) {
+            fprintf(stderr, "Warning: Unable to read profile file %s, compiling without it\n", path);
+            *profile = BranchProfile();
+        }
+    }
+    return profile;
+}
+
+// The layout pass asks for it from the worker threads, a function static is initialized only once
+const BranchProfile& getBranchProfile() {
+    static BranchProfile* profile = loadBranchProfile();
+    return *profile;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include "SymbolTable.hpp"
+
+struct JumpCounts {
+    long long taken = 0;
+    long long fallThrough = 0;
+};
+
+// Counts of an instrumented run (-fprofile-generate), read back by -fprofile-use. Records are keyed by
+// function name and source line, counted from the line the function is declared on (the global code uses
+// the line itself), so an edit inside one function leaves the records of the others valid. The jumps of a
+// line are told apart by their order; a line whose number of jumps changed since the run is ignored.
+class BranchProfile {
+   private:
+    struct LineCounts {
+        vector<JumpCounts> jumps;  // JMP, JF and JT in quadruple order
+        long long labelEntries = 0;  // times control reached the first label of the line
+        bool hasLabel = false;
+    };
+    unordered_map<string, LineCounts> lines;
+
+   public:
+    static string getLineKey(Function* function, int line);
+
+    void addJump(const string& lineKey, const JumpCounts& counts);
+    void setLabelEntries(const string& lineKey, long long entries);
+
+    bool isEmpty() const;
+    // Null when the line has no record or no longer has jumpsOnLine jumps
+    const JumpCounts* getJump(const string& lineKey, size_t index, size_t jumpsOnLine) const;
+    long long getLabelEntries(const string& lineKey) const;
+
+    // Returns false on a malformed file
+    bool read(istream& in);
+    void write(ostream& out) const;
+};
+
+// The profile named by -fprofile-use, read on first use. Empty without the option.
+const BranchProfile& getBranchProfile();
@@ -0,0 +1,645 @@
+#include "CBackend.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#include "QuadrupleManager.hpp"
+#include "common.h"
+
+static const char* runtimeSupport =
+    "#include <math.h>\n"
+    "#include <stdio.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "/* integer ^ integer, wrapping like the other integer operations; a negative exponent gives 0 */\n"
+    "static int cmm_pow(int base, int exponent) {\n"
+    "    unsigned result = 1;\n"
+    "    if (exponent < 0) {\n"
+    "        return base == 1 ? 1 : base == -1 ? (exponent % 2 ? -1 : 1) : 0;\n"
+    "    }\n"
+    "    while (exponent-- > 0) {\n"
+    "        result *= (unsigned)base;\n"
+    "    }\n"
+    "    return (int)result;\n"
+    "}\n";
+
+static string getCType(Type type) {
+    switch (type) {
+        case FLOAT_T:
+            return "float";
+        case CHAR_T:
+            return "char";
+        case STRING_T:
+            return "const char*";
+        case VOID_T:
+            return "void";
+        default:
+            return "int";
+    }
+}
+
+// Type as part of a C identifier
+static string getTypeName(Type type) {
+    switch (type) {
+        case FLOAT_T:
+            return "float";
+        case CHAR_T:
+            return "char";
+        case STRING_T:
+            return "string";
+        case BOOLEAN_T:
+            return "bool";
+        case VOID_T:
+            return "void";
+        default:
+            return "int";
+    }
+}
+
+static string getZeroValue(Type type) {
+    return type == STRING_T ? "\"\"" : "0";
+}
+
+static string getLabelName(const string& label) {
+    return label.substr(0, label.size() - 1);
+}
+
+static bool isComparison(const string& op) {
+    return op == "LT" || op == "GT" || op == "LTE" || op == "GTE" || op == "EQ" || op == "NEQ";
+}
+
+static string getCOperator(const string& op) {
+    static const unordered_map<string, string> operators = {
+        {"ADD", "+"}, {"SUB", "-"}, {"MUL", "*"}, {"DIV", "/"}, {"AND", "&&"}, {"OR", "||"},
+        {"LT", "<"},  {"GT", ">"},  {"LTE", "<="}, {"GTE", ">="}, {"EQ", "=="}, {"NEQ", "!="}};
+    auto it = operators.find(op);
+    return it == operators.end() ? "" : it->second;
+}
+
+// Operands a quadruple reads or writes as values
+static vector<string> getValueOperands(const Quadruple& quad) {
+    vector<string> operands = quad.getUsedOperands();
+    if ((quad.isPureOperation() || quad.isCall()) && !quad.getResult().empty()) {
+        operands.push_back(quad.getResult());
+    }
+    return operands;
+}
+
+CBackend::CBackend(const vector<Quadruple>& quadruples) {
+    for (Variable* variable : getAllVariables()) {
+        variableTypes.insert({variable->getName(), variable->getType()});
+    }
+    splitIntoFunctions(quadruples);
+    inferTemporaryTypes();
+    collectCapturedVariables();
+    collectTailCalls();
+    collectGlobals();
+}
+
+void CBackend::splitIntoFunctions(const vector<Quadruple>& quadruples) {
+    functions.push_back(CFunction());
+    // index of every function whose body is still open, with the label that ends it
+    vector<pair<size_t, string>> open;
+
+    for (size_t i = 0; i < quadruples.size(); i++) {
+        const Quadruple& quad = quadruples[i];
+        if (!open.empty() && quad.getOp() == open.back().second) {
+            open.pop_back();
+        }
+        bool isEntry = quad.isLabel() && i > 0 && i + 1 < quadruples.size() && quadruples[i + 1].getOp() == "ENTER" &&
+                       quadruples[i - 1].getOp() == "JMP" && !quadruples[i - 1].getResult().empty();
+        if (isEntry) {
+            CFunction function;
+            function.label = quad.getOp();
+            function.function = getFunctionByLabel(function.label);
+            function.parent = open.empty() ? 0 : open.back().first;
+            functions[function.parent].hasNested = true;
+            functionOf[function.label] = functions.size();
+            open.push_back({functions.size(), quadruples[i - 1].getResult()});
+            functions.push_back(function);
+            if (function.function == nullptr) {
+                error = "no function has the entry label " + function.label;
+            }
+        }
+        functions[open.empty() ? 0 : open.back().first].body.push_back(quad);
+    }
+}
+
+void CBackend::inferTemporaryTypes() {
+    // a temporary can be read before the quadruple that defines it (loop rotation copies conditions), so
+    // repeat until every type is known
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const CFunction& function : functions) {
+            for (const Quadruple& quad : function.body) {
+                const string& result = quad.getResult();
+                if (!(quad.isPureOperation() || quad.isCall()) || result.empty() || variableTypes.count(result) ||
+                    temporaryTypes.count(result)) {
+                    continue;
+                }
+                Type type;
+                const string& op = quad.getOp();
+                if (quad.isCall()) {
+                    Function* callee = getFunctionByLabel(quad.getArg1());
+                    type = callee != nullptr ? callee->getType() : INTEGER_T;
+                } else if (isComparison(op) || op == "AND" || op == "OR") {
+                    type = BOOLEAN_T;
+                } else {
+                    // arithmetic keeps the type of its left operand, like the parser does
+                    const string& operand = op == "NEG" ? quad.getArg2() : quad.getArg1();
+                    if (!Quadruple::isNumericLiteral(operand) && !Quadruple::isCharLiteral(operand) && !variableTypes.count(operand) &&
+                        !temporaryTypes.count(operand) && operand[0] != '"') {
+                        continue;
+                    }
+                    type = getOperandType(operand, function);
+                }
+                temporaryTypes[result] = type;
+                changed = true;
+            }
+        }
+    }
+}
+
+void CBackend::collectCapturedVariables() {
+    // every function between the one using the name and the one holding it follows its access link
+    auto markLinks = [this](size_t function, size_t enclosing) {
+        for (; function != 0 && function != enclosing; function = functions[function].parent) {
+            functions[function].usesLink = true;
+        }
+    };
+    for (size_t f = 0; f < functions.size(); f++) {
+        for (const Quadruple& quad : functions[f].body) {
+            for (const string& operand : getValueOperands(quad)) {
+                int hops;
+                size_t enclosing = findEnclosingFunction(operand, functions[f], hops);
+                if (enclosing != 0) {
+                    functions[enclosing].captured.insert(operand);
+                    markLinks(f, enclosing);
+                }
+            }
+            auto callee = quad.isCall() ? functionOf.find(quad.getArg1()) : functionOf.end();
+            if (callee != functionOf.end() && functions[callee->second].parent != 0) {
+                markLinks(f, functions[callee->second].parent);
+            }
+        }
+    }
+}
+
+void CBackend::collectTailCalls() {
+    for (CFunction& function : functions) {
+        for (size_t i = 0; i < function.body.size(); i++) {
+            if (!isTailCall(function, i)) {
+                continue;
+            }
+            function.hasTailCalls = true;
+            if (tailCallIdOf.insert({function.body[i].getArg1(), tailCallTargets.size() + 1}).second) {
+                tailCallTargets.push_back(functionOf.at(function.body[i].getArg1()));
+            }
+        }
+    }
+}
+
+void CBackend::collectGlobals() {
+    for (Variable* variable : getGlobalVariables()) {
+        if (isGlobal.insert(variable->getName()).second) {
+            globals.push_back(variable->getName());
+        }
+    }
+    for (const CFunction& function : functions) {
+        for (const Quadruple& quad : function.body) {
+            for (const string& operand : getValueOperands(quad)) {
+                int hops;
+                bool inFrame = function.function != nullptr && function.function->getFrameSlot(operand) >= 0;
+                bool isEnclosing = findEnclosingFunction(operand, function, hops) != 0;
+                if (variableTypes.count(operand) && !inFrame && !isEnclosing && isGlobal.insert(operand).second) {
+                    globals.push_back(operand);
+                }
+            }
+        }
+    }
+}
+
+// Function whose frame holds a name used by a function nested in it, 0 when no enclosing frame has it
+size_t CBackend::findEnclosingFunction(const string& name, const CFunction& function, int& hops) const {
+    if (function.function == nullptr || function.function->getFrameSlot(name) >= 0) {
+        return 0;
+    }
+    hops = 1;
+    for (size_t enclosing = function.parent; enclosing != 0; enclosing = functions[enclosing].parent, hops++) {
+        if (functions[enclosing].function->getFrameSlot(name) >= 0) {
+            return enclosing;
+        }
+    }
+    return 0;
+}
+
+// Only declared when it has members, nested functions called from a function without one get a null link
+bool CBackend::hasFrameStruct(const CFunction& function) const {
+    return function.hasNested && (function.parent != 0 || !function.captured.empty());
+}
+
+string CBackend::getFrameStructName(const CFunction& function) const {
+    return "struct frame" + getFunctionName(function.label).substr(1);
+}
+
+// Frame struct of the innermost active call of the function the callee is nested in
+string CBackend::getLink(const CFunction& caller, size_t calleeParent) const {
+    if (&functions[calleeParent] == &caller) {
+        return hasFrameStruct(caller) ? "&frame" : "0";
+    }
+    string link = "link";
+    for (size_t enclosing = caller.parent; enclosing != calleeParent && enclosing != 0; enclosing = functions[enclosing].parent) {
+        link += "->link";
+    }
+    return link;
+}
+
+// A TAILCALL right before the RET of its result, of a function with the same return type that does not reach the
+// frame of the caller through its access link; any other TAILCALL is translated as a call
+bool CBackend::isTailCall(const CFunction& function, size_t i) const {
+    const Quadruple& call = function.body[i];
+    auto callee = functionOf.find(call.getArg1());
+    if (!call.isTailCall() || function.function == nullptr || i + 1 >= function.body.size() || callee == functionOf.end()) {
+        return false;
+    }
+    const Quadruple& ret = function.body[i + 1];
+    const CFunction& calleeCode = functions[callee->second];
+    return ret.getOp() == "RET" && ret.getArg1() == call.getResult() && calleeCode.function->getType() == function.function->getType() &&
+           (&functions[calleeCode.parent] != &function || !calleeCode.usesLink);
+}
+
+// The access link of a nested callee, then the arguments the PARAMs before the call pass
+string CBackend::getArgumentList(const CFunction& caller, const string& label, const vector<string>& arguments) const {
+    string list;
+    auto callee = functionOf.find(label);
+    if (callee != functionOf.end() && functions[callee->second].parent != 0) {
+        list = getLink(caller, functions[callee->second].parent);
+    }
+    for (const string& argument : arguments) {
+        list += (list.empty() ? "" : ", ") + formatOperand(argument, caller);
+    }
+    return list;
+}
+
+bool CBackend::isVariable(const string& name, const CFunction& function) const {
+    if (variableTypes.count(name) || temporaryTypes.count(name)) {
+        return true;
+    }
+    return function.function != nullptr && function.function->getFrameSlot(name) >= 0;
+}
+
+Type CBackend::getOperandType(const string& operand, const CFunction& function) const {
+    if (Quadruple::isNumericLiteral(operand)) {
+        return operand.find('.') != string::npos ? FLOAT_T : INTEGER_T;
+    }
+    if (Quadruple::isCharLiteral(operand)) {
+        return CHAR_T;
+    }
+    if (!operand.empty() && operand[0] == '"') {
+        return STRING_T;
+    }
+    auto variable = variableTypes.find(operand);
+    if (variable != variableTypes.end()) {
+        return variable->second;
+    }
+    auto temporary = temporaryTypes.find(operand);
+    if (temporary != temporaryTypes.end()) {
+        return temporary->second;
+    }
+    return INTEGER_T;
+}
+
+// C expression of an operand
+string CBackend::formatOperand(const string& operand, const CFunction& function) const {
+    if (Quadruple::isCharLiteral(operand)) {
+        char c = Quadruple::getCharLiteralValue(operand);
+        if (c == '\0') {
+            return "'\\0'";
+        }
+        if (c == '\\') {
+            return "'\\\\'";
+        }
+        return operand;
+    }
+    if (Quadruple::isNumericLiteral(operand) || operand[0] == '"') {
+        return operand;
+    }
+    if (Quadruple::isTemporary(operand) && !variableTypes.count(operand)) {
+        return operand;
+    }
+    int hops;
+    if (findEnclosingFunction(operand, function, hops) != 0) {
+        string link = "link";
+        while (--hops > 0) {
+            link += "->link";
+        }
+        return link + "->v_" + operand;
+    }
+    if (function.captured.count(operand)) {
+        return "frame.v_" + operand;
+    }
+    return "v_" + operand;
+}
+
+string CBackend::getFunctionName(const string& label) const {
+    Function* function = getFunctionByLabel(label);
+    return "f_" + (function != nullptr ? function->getName() + "_" : "") + getLabelName(label);
+}
+
+string CBackend::getSignature(const CFunction& function) const {
+    string signature = "static " + getCType(function.function->getType()) + " " + getFunctionName(function.label) + "(";
+    vector<Variable*>* arguments = function.function->getArguments();
+    const vector<string>& slots = function.function->getFrameSlots();
+    string separator = "";
+    if (function.parent != 0) {
+        signature += getFrameStructName(functions[function.parent]) + "* link";
+        separator = ", ";
+    }
+    // captured arguments are copied into the frame struct when the function starts
+    for (size_t i = 0; i < arguments->size(); i++) {
+        signature += separator + getCType((*arguments)[i]->getType()) + " v_" + slots[i];
+        separator = ", ";
+    }
+    return signature + (separator.empty() ? "void)" : ")");
+}
+
+bool CBackend::writeBody(const CFunction& function, ostream& out) {
+    // locals: the frame (minus the arguments) and every temporary the code uses
+    vector<string> locals;
+    unordered_set<string> isLocal;
+    size_t argumentCount = 0;
+    if (function.function != nullptr) {
+        argumentCount = function.function->getArguments()->size();
+        const vector<string>& slots = function.function->getFrameSlots();
+        for (size_t slot = 0; slot < slots.size(); slot++) {
+            isLocal.insert(slots[slot]);
+            if (slot >= argumentCount && !function.captured.count(slots[slot])) {
+                locals.push_back(slots[slot]);
+            }
+        }
+    }
+    unordered_set<string> labels;
+    for (const Quadruple& quad : function.body) {
+        for (const string& operand : getValueOperands(quad)) {
+            int hops;
+            if (!isGlobal.count(operand) && isVariable(operand, function) && findEnclosingFunction(operand, function, hops) == 0 &&
+                isLocal.insert(operand).second) {
+                locals.push_back(operand);
+            }
+        }
+        if (!quad.getJumpTarget().empty()) {
+            labels.insert(quad.getJumpTarget());
+        }
+    }
+    if (hasFrameStruct(function)) {
+        out << "    " << getFrameStructName(function) << " frame;\n";
+        if (function.parent != 0) {
+            out << "    frame.link = link;\n";
+        }
+        const vector<string>& slots = function.function->getFrameSlots();
+        for (size_t slot = 0; slot < slots.size(); slot++) {
+            if (function.captured.count(slots[slot])) {
+                Type type = getOperandType(slots[slot], function);
+                out << "    frame.v_" << slots[slot] << " = " << (slot < argumentCount ? "v_" + slots[slot] : getZeroValue(type)) << ";\n";
+            }
+        }
+    }
+    for (const string& local : locals) {
+        Type type = getOperandType(local, function);
+        out << "    " << getCType(type) << " " << formatOperand(local, function) << " = " << getZeroValue(type) << ";\n";
+    }
+
+    Type returnType = function.function != nullptr ? function.function->getType() : VOID_T;
+    vector<string> parameters;
+    for (size_t i = 0; i < function.body.size(); i++) {
+        const Quadruple& quad = function.body[i];
+        const string& op = quad.getOp();
+        const string& arg1 = quad.getArg1();
+        const string& arg2 = quad.getArg2();
+        const string& result = quad.getResult();
+        Type resultType = result.empty() ? VOID_T : getOperandType(result, function);
+
+        if (quad.isLabel()) {
+            if (labels.count(op)) {
+                out << getLabelName(op) << ":;\n";
+            }
+        } else if (op == "ENTER") {
+            continue;
+        } else if (op == "ASSIGN") {
+            out << "    " << formatOperand(result, function) << " = " << formatOperand(arg1, function) << ";\n";
+        } else if (op == "NEG") {
+            out << "    " << formatOperand(result, function) << " = -" << formatOperand(arg2, function) << ";\n";
+        } else if (op == "POW") {
+            bool isFloat = resultType == FLOAT_T || getOperandType(arg1, function) == FLOAT_T || getOperandType(arg2, function) == FLOAT_T;
+            out << "    " << formatOperand(result, function) << " = " << (isFloat ? "powf(" : "cmm_pow(")
+                << formatOperand(arg1, function) << ", " << formatOperand(arg2, function) << ");\n";
+        } else if (isComparison(op)) {
+            Type type1 = getOperandType(arg1, function);
+            Type type2 = getOperandType(arg2, function);
+            string left = formatOperand(arg1, function);
+            string right = formatOperand(arg2, function);
+            if (type1 == STRING_T || type2 == STRING_T) {
+                out << "    " << formatOperand(result, function) << " = strcmp(" << left << ", " << right << ") "
+                    << getCOperator(op) << " 0;\n";
+            } else {
+                out << "    " << formatOperand(result, function) << " = " << left << " " << getCOperator(op) << " " << right << ";\n";
+            }
+        } else if (!getCOperator(op).empty()) {
+            out << "    " << formatOperand(result, function) << " = " << formatOperand(arg1, function) << " "
+                << getCOperator(op) << " " << formatOperand(arg2, function) << ";\n";
+        } else if (op == "JMP" || op == "JF" || op == "JT") {
+            string target = quad.getJumpTarget();
+            if (labels.count(target) == 0 || target.empty()) {
+                error = op + " to " + target + ", which is not in the same function";
+                return false;
+            }
+            string condition = formatOperand(arg1, function);
+            if (op == "JF") {
+                out << "    if (!" << condition << ") ";
+            } else if (op == "JT") {
+                out << "    if (" << condition << ") ";
+            } else {
+                out << "    ";
+            }
+            out << "goto " << getLabelName(target) << ";\n";
+        } else if (op == "SWITCH") {
+            out << "    switch (" << formatOperand(arg1, function) << " - " << formatOperand(arg2, function) << ") {\n";
+            for (int index = 0; i + 1 < function.body.size() && function.body[i + 1].getOp() == "JTAB"; index++) {
+                i++;
+                out << "        case " << index << ": goto " << getLabelName(function.body[i].getResult()) << ";\n";
+            }
+            out << "        default: goto " << getLabelName(result) << ";\n    }\n";
+        } else if (op == "PARAM") {
+            parameters.push_back(arg1);
+        } else if (quad.isCall()) {
+            Function* callee = getFunctionByLabel(arg1);
+            size_t count = stoul(arg2);
+            if (callee == nullptr || count > parameters.size() || count != callee->getArguments()->size()) {
+                error = "CALL " + arg1 + " does not match a function and its PARAMs";
+                return false;
+            }
+            vector<string> arguments(parameters.end() - count, parameters.end());
+            parameters.resize(parameters.size() - count);
+            if (isTailCall(function, i)) {
+                // the arguments and the callee are left to the caller, which runs the call once this function returned
+                const CFunction& tailCallee = functions[functionOf.at(arg1)];
+                string name = getFunctionName(arg1);
+                if (tailCallee.parent != 0) {
+                    // the frame of this function is gone when the callee runs, and one nested in it does not use it
+                    bool ownFrame = &functions[tailCallee.parent] == &function;
+                    out << "    " << name << "_link = " << (ownFrame ? "0" : getLink(function, tailCallee.parent)) << ";\n";
+                }
+                for (size_t argument = 0; argument < count; argument++) {
+                    out << "    " << name << "_arg" << argument << " = " << formatOperand(arguments[argument], function) << ";\n";
+                }
+                out << "    cmm_tail_call = " << tailCallIdOf.at(arg1) << ";\n";
+                out << "    return" << (returnType == VOID_T ? "" : " " + getZeroValue(returnType)) << ";\n";
+                i++;
+                continue;
+            }
+            string target = result.empty() ? "" : formatOperand(result, function) + " = ";
+            out << "    " << target << getFunctionName(arg1) << "(" << getArgumentList(function, arg1, arguments) << ");\n";
+            auto calleeCode = functionOf.find(arg1);
+            if (calleeCode != functionOf.end() && functions[calleeCode->second].hasTailCalls) {
+                out << "    if (cmm_tail_call != 0) " << target << "cmm_tail_calls_" << getTypeName(callee->getType()) << "();\n";
+            }
+        } else if (op == "RET") {
+            if (function.function == nullptr) {
+                error = "RET outside of a function";
+                return false;
+            }
+            if (returnType == VOID_T) {
+                out << "    return;\n";
+            } else {
+                out << "    return " << (arg1.empty() ? getZeroValue(returnType) : formatOperand(arg1, function)) << ";\n";
+            }
+        } else {
+            error = "no C translation for " + op;
+            return false;
+        }
+    }
+    return true;
+}
+
+// One loop per return type, which runs the tail calls left behind by a call until one of them returns its result
+void CBackend::writeTailCallLoops(ostream& out) const {
+    vector<Type> types;
+    for (size_t target : tailCallTargets) {
+        Type type = functions[target].function->getType();
+        if (find(types.begin(), types.end(), type) == types.end()) {
+            types.push_back(type);
+        }
+    }
+    for (Type type : types) {
+        out << "\nstatic " << getCType(type) << " cmm_tail_calls_" << getTypeName(type) << "(void) {\n";
+        if (type != VOID_T) {
+            out << "    " << getCType(type) << " result = " << getZeroValue(type) << ";\n";
+        }
+        out << "    while (cmm_tail_call != 0) {\n"
+            << "        int next = cmm_tail_call;\n"
+            << "        cmm_tail_call = 0;\n"
+            << "        switch (next) {\n";
+        for (size_t id = 1; id <= tailCallTargets.size(); id++) {
+            const CFunction& callee = functions[tailCallTargets[id - 1]];
+            if (callee.function->getType() != type) {
+                continue;
+            }
+            string name = getFunctionName(callee.label);
+            string arguments = callee.parent != 0 ? name + "_link" : "";
+            for (size_t argument = 0; argument < callee.function->getArguments()->size(); argument++) {
+                arguments += (arguments.empty() ? "" : ", ") + name + "_arg" + to_string(argument);
+            }
+            out << "            case " << id << ":\n"
+                << "                " << (type == VOID_T ? "" : "result = ") << name << "(" << arguments << ");\n"
+                << "                break;\n";
+        }
+        out << "        }\n    }\n" << (type == VOID_T ? "" : "    return result;\n") << "}\n";
+    }
+}
+
+bool CBackend::write(ostream& out, const string& sourceName) {
+    if (!error.empty()) {
+        return false;
+    }
+    out << "/* Generated by the C-- compiler from " << sourceName << " */\n" << runtimeSupport << "\n";
+
+    for (const string& global : globals) {
+        Type type = variableTypes.at(global);
+        out << "static " << getCType(type) << " v_" << global << " = " << getZeroValue(type) << ";\n";
+    }
+    out << "\n";
+    for (size_t f = 1; f < functions.size(); f++) {
+        if (!functions[f].hasNested) {
+            continue;
+        }
+        if (!hasFrameStruct(functions[f])) {
+            out << getFrameStructName(functions[f]) << ";\n";
+            continue;
+        }
+        out << getFrameStructName(functions[f]) << " {\n";
+        if (functions[f].parent != 0) {
+            out << "    " << getFrameStructName(functions[functions[f].parent]) << "* link;\n";
+        }
+        for (const string& slot : functions[f].function->getFrameSlots()) {
+            if (functions[f].captured.count(slot)) {
+                out << "    " << getCType(getOperandType(slot, functions[f])) << " v_" << slot << ";\n";
+            }
+        }
+        out << "};\n";
+    }
+    if (!tailCallTargets.empty()) {
+        out << "static int cmm_tail_call = 0; /* function a tail call left to run, 0 for none */\n";
+    }
+    for (size_t target : tailCallTargets) {
+        const CFunction& callee = functions[target];
+        string name = getFunctionName(callee.label);
+        if (callee.parent != 0) {
+            out << "static " << getFrameStructName(functions[callee.parent]) << "* " << name << "_link;\n";
+        }
+        vector<Variable*>* arguments = callee.function->getArguments();
+        for (size_t argument = 0; argument < arguments->size(); argument++) {
+            Type type = (*arguments)[argument]->getType();
+            out << "static " << getCType(type) << " " << name << "_arg" << argument << " = " << getZeroValue(type) << ";\n";
+        }
+    }
+    for (size_t f = 1; f < functions.size(); f++) {
+        out << getSignature(functions[f]) << ";\n";
+    }
+    writeTailCallLoops(out);
+
+    for (size_t f = 1; f < functions.size(); f++) {
+        out << "\n" << getSignature(functions[f]) << " {\n";
+        if (!writeBody(functions[f], out)) {
+            return false;
+        }
+        out << "}\n";
+    }
+
+    out << "\nint main(void) {\n";
+    if (!writeBody(functions[0], out)) {
+        return false;
+    }
+    for (Variable* variable : getGlobalVariables()) {
+        static const char* formats[] = {"%d", "%g", "%c", "%s", "%d", ""};
+        out << "    printf(\"" << variable->getName() << " = " << formats[variable->getType()] << "\\n\", v_" << variable->getName() << ");\n";
+    }
+    out << "    return 0;\n}\n";
+    return true;
+}
+
+const string& CBackend::getError() const {
+    return error;
+}
+
+extern "C" {
+
+void writeCProgram(const char* inputFileName) {
+    const char* outputFileName = getOutputFileName(inputFileName, ".c");
+    ofstream out(outputFileName);
+    CBackend backend(getMainQuadrupleManager().getQuadruples());
+    if (!out || !backend.write(out, inputFileName)) {
+        fprintf(stderr, "Cannot write the C program %s: %s\n", outputFileName, out ? backend.getError().c_str() : "cannot open the file");
+    }
+}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+#include "Quadruple.hpp"
+#include "SymbolTable.hpp"
+
+// Code of one C function: a C-- function, or main for the global code. Nested functions are taken out
+// of the body around them, which keeps the jump over them and their skip label.
+struct CFunction {
+    Function* function = nullptr;  // null for main
+    string label;
+    vector<Quadruple> body;
+    size_t parent = 0;  // function the body is nested in, 0 for the functions of the global code
+    bool hasNested = false;
+    bool hasTailCalls = false;
+    bool usesLink = false;  // the access link is followed, by the body or by the functions nested in it
+    unordered_set<string> captured;  // frame slots used by nested functions, which live in the frame struct
+};
+
+// Translates the final quadruples into a single C file that runs the program natively. Variables and
+// temporaries become typed C variables (variables use the type of their symbol, temporaries the type the
+// parser gives the expression that computes them), labels and jumps become goto, and functions become C
+// functions taking their arguments as parameters. A function with nested functions keeps the variables they
+// use in a frame struct, and a nested function takes a pointer to the frame struct of the function it is
+// nested in as its access link, which names further out are reached through. Any other name that is not in
+// the frame of the function using it is a global, as in the quadruples. main prints every global variable
+// of the program when it ends. A tail call leaves its arguments and the callee to the caller of the
+// function making it, which runs such calls in a loop, so a chain of tail calls does not grow the C stack.
+class CBackend {
+   private:
+    vector<CFunction> functions;
+    unordered_map<string, size_t> functionOf;  // by entry label
+    vector<size_t> tailCallTargets;            // functions a tail call can leave to the caller, numbered from 1
+    unordered_map<string, int> tailCallIdOf;
+    unordered_map<string, Type> variableTypes;  // every declared variable by name
+    unordered_map<string, Type> temporaryTypes;
+    vector<string> globals;  // names used outside of any frame, in order of first use
+    unordered_set<string> isGlobal;
+    string error;
+
+    void splitIntoFunctions(const vector<Quadruple>& quadruples);
+    void inferTemporaryTypes();
+    void collectCapturedVariables();
+    void collectTailCalls();
+    void collectGlobals();
+
+    bool isVariable(const string& name, const CFunction& function) const;
+    Type getOperandType(const string& operand, const CFunction& function) const;
+    string formatOperand(const string& operand, const CFunction& function) const;
+    size_t findEnclosingFunction(const string& name, const CFunction& function, int& hops) const;
+    bool hasFrameStruct(const CFunction& function) const;
+    string getFrameStructName(const CFunction& function) const;
+    string getLink(const CFunction& caller, size_t calleeParent) const;
+    bool isTailCall(const CFunction& function, size_t i) const;
+    string getArgumentList(const CFunction& caller, const string& label, const vector<string>& arguments) const;
+    string getFunctionName(const string& label) const;
+    string getSignature(const CFunction& function) const;
+    bool writeBody(const CFunction& function, ostream& out);
+    void writeTailCallLoops(ostream& out) const;
+
+   public:
+    explicit CBackend(const vector<Quadruple>& quadruples);
+
+    // Returns false and leaves the reason in getError() when the quadruples cannot be translated
+    bool write(ostream& out, const string& sourceName);
+    const string& getError() const;
+};
@@ -0,0 +1,140 @@
+#include "CallGraph.hpp"
+
+#include <fstream>
+
+#include "QuadrupleManager.hpp"
+#include "SymbolTable.hpp"
+#include "common.h"
+
+bool CallGraphNode::isLeaf() const {
+    return callees.empty();
+}
+
+CallGraph::CallGraph(const vector<FunctionUnit>& units) {
+    CallGraphNode global;
+    global.name = "global";
+    nodes.push_back(global);
+    nodeOf[""] = 0;
+
+    for (const FunctionUnit& unit : units) {
+        if (unit.isFunction() && nodeOf.find(unit.label) == nodeOf.end()) {
+            CallGraphNode node;
+            node.label = unit.label;
+            Function* function = getFunctionByLabel(unit.label);
+            node.name = function != nullptr ? function->getName() : unit.label;
+            nodeOf[unit.label] = nodes.size();
+            nodes.push_back(node);
+        }
+    }
+
+    for (const FunctionUnit& unit : units) {
+        CallGraphNode& caller = nodes[nodeOf[unit.label]];
+        for (const Quadruple& quad : unit.quadruples) {
+            // calls of nested functions stay inside the unit, they are not nodes of their own
+            if (quad.isCall() && nodeOf.find(quad.getArg1()) != nodeOf.end()) {
+                caller.callees[quad.getArg1()]++;
+            }
+        }
+    }
+
+    markReachable();
+    markRecursive();
+}
+
+void CallGraph::markReachable() {
+    vector<size_t> pending = {0};
+    nodes[0].isReachable = true;
+    while (!pending.empty()) {
+        size_t node = pending.back();
+        pending.pop_back();
+        for (const auto& callee : nodes[node].callees) {
+            CallGraphNode& next = nodes[nodeOf[callee.first]];
+            if (!next.isReachable) {
+                next.isReachable = true;
+                pending.push_back(nodeOf[callee.first]);
+            }
+        }
+    }
+}
+
+void CallGraph::markRecursive() {
+    // a function is recursive when it can be reached again from one of its callees
+    for (size_t start = 1; start < nodes.size(); start++) {
+        vector<bool> visited(nodes.size(), false);
+        vector<size_t> pending = {start};
+        while (!pending.empty() && !nodes[start].isRecursive) {
+            size_t node = pending.back();
+            pending.pop_back();
+            for (const auto& callee : nodes[node].callees) {
+                size_t next = nodeOf[callee.first];
+                if (next == start) {
+                    nodes[start].isRecursive = true;
+                    break;
+                }
+                if (!visited[next]) {
+                    visited[next] = true;
+                    pending.push_back(next);
+                }
+            }
+        }
+    }
+}
+
+const vector<CallGraphNode>& CallGraph::getNodes() const {
+    return nodes;
+}
+
+const CallGraphNode* CallGraph::getNode(const string& label) const {
+    auto it = nodeOf.find(label);
+    return it == nodeOf.end() ? nullptr : &nodes[it->second];
+}
+
+// Labels end with ':', which DOT does not accept in a bare identifier
+static string getDotId(const CallGraphNode& node) {
+    return node.label.empty() ? "global" : node.label.substr(0, node.label.size() - 1);
+}
+
+void CallGraph::writeDot(ostream& out) const {
+    out << "digraph calls {\n";
+    out << "    node [shape=ellipse];\n";
+    for (const CallGraphNode& node : nodes) {
+        out << "    " << getDotId(node) << " [label=\"" << node.name;
+        if (!node.label.empty()) {
+            out << "\\n" << node.label;
+        }
+        out << "\"";
+        if (node.label.empty()) {
+            out << ", shape=box";
+        } else if (!node.isReachable) {
+            out << ", style=dashed, color=gray";
+        } else if (node.isRecursive) {
+            out << ", color=red";
+        } else if (node.isLeaf()) {
+            out << ", peripheries=2";
+        }
+        out << "];\n";
+    }
+    for (const CallGraphNode& node : nodes) {
+        for (const auto& callee : node.callees) {
+            out << "    " << getDotId(node) << " -> " << getDotId(*getNode(callee.first));
+            if (callee.second > 1) {
+                out << " [label=\"" << callee.second << "\"]";
+            }
+            out << ";\n";
+        }
+    }
+    out << "}\n";
+}
+
+extern "C" {
+
+void writeCallGraph(const char* path) {
+    ofstream file(path);
+    if (!file) {
+        fprintf(stderr, "Error: Unable to open call graph file %s\n", path);
+        return;
+    }
+    CallGraph callGraph(PassManager::splitIntoUnits(getMainQuadrupleManager().getQuadruples()));
+    callGraph.writeDot(file);
+}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include "PassManager.hpp"
+
+struct CallGraphNode {
+    string label;               // entry label of the function, empty for the global code
+    string name;                // function name, "global" for the global code
+    map<string, int> callees;   // label of every called function and the number of call sites
+    bool isReachable = false;   // called directly or indirectly from the global code
+    bool isRecursive = false;   // part of a cycle of calls
+    bool isLeaf() const;
+};
+
+// Calls between the top level functions of the final quadruples (CALL Lf:). The global code is the entry
+// node; calls made inside a nested function are attributed to the top level function around it.
+class CallGraph {
+   private:
+    vector<CallGraphNode> nodes;
+    unordered_map<string, size_t> nodeOf;
+
+    void markReachable();
+    void markRecursive();
+
+   public:
+    explicit CallGraph(const vector<FunctionUnit>& units);
+
+    // The global code is always the first node
+    const vector<CallGraphNode>& getNodes() const;
+    // Null for labels that are not top level functions
+    const CallGraphNode* getNode(const string& label) const;
+    void writeDot(ostream& out) const;
+};
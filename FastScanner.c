@@ -0,0 +1,435 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FastScanner.h"
+#include "common.h"
+#include "y.tab.h"
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+extern FILE* yyin;
+extern int yylineno;
+extern char* yytext;
+void yyerror(char*);
+
+// Zero bytes after the input, so a vector load that starts before the end stays inside the buffer and the
+// scans for whitespace and identifiers stop at the end without a bounds check
+#define INPUT_PADDING 64
+
+// The loops a vector kernel replaces. Each one adds the newlines it steps over to *lines.
+typedef struct {
+    const char* name;
+    // First byte at or after pos that is not a space, tab or newline
+    size_t (*skipWhitespace)(const char* text, size_t pos, long long* lines);
+    // First byte at or after pos equal to byte, end when there is none
+    size_t (*findByte)(const char* text, size_t pos, size_t end, char byte, long long* lines);
+    // First byte at or after pos that cannot continue an identifier
+    size_t (*skipIdentifier)(const char* text, size_t pos);
+} ScanKernel;
+
+static int isIdentifierByte(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static size_t skipWhitespaceScalar(const char* text, size_t pos, long long* lines) {
+    for (;; pos++) {
+        if (text[pos] == '\n') {
+            (*lines)++;
+        } else if (text[pos] != ' ' && text[pos] != '\t') {
+            return pos;
+        }
+    }
+}
+
+static size_t findByteScalar(const char* text, size_t pos, size_t end, char byte, long long* lines) {
+    for (; pos < end && text[pos] != byte; pos++) {
+        *lines += text[pos] == '\n';
+    }
+    return pos;
+}
+
+static size_t skipIdentifierScalar(const char* text, size_t pos) {
+    while (isIdentifierByte(text[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+static const ScanKernel scalarKernel = {"scalar", skipWhitespaceScalar, findByteScalar, skipIdentifierScalar};
+
+#ifdef HAVE_X86_KERNELS
+// A vector kernel compares a whole block at once and turns the result into a bit mask, one bit per byte.
+// The first set bit of the stop mask ends the scan, the newlines below it are counted with one popcount.
+static size_t stopAt(size_t pos, unsigned stops, unsigned newlines, long long* lines) {
+    unsigned offset = __builtin_ctz(stops);
+    *lines += __builtin_popcount(newlines & ((1u << offset) - 1));
+    return pos + offset;
+}
+
+static size_t skipWhitespaceSse2(const char* text, size_t pos, long long* lines) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (;; pos += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(text + pos));
+        __m128i isNewline = _mm_cmpeq_epi8(block, newline);
+        __m128i isBlank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)), isNewline);
+        unsigned stops = ~(unsigned)_mm_movemask_epi8(isBlank) & 0xFFFF;
+        unsigned newlines = _mm_movemask_epi8(isNewline);
+        if (stops) {
+            return stopAt(pos, stops, newlines, lines);
+        }
+        *lines += __builtin_popcount(newlines);
+    }
+}
+
+static size_t findByteSse2(const char* text, size_t pos, size_t end, char byte, long long* lines) {
+    const __m128i wanted = _mm_set1_epi8(byte);
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; pos < end; pos += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(text + pos));
+        unsigned stops = _mm_movemask_epi8(_mm_cmpeq_epi8(block, wanted));
+        unsigned newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        if (stops) {
+            return stopAt(pos, stops, newlines, lines);
+        }
+        *lines += __builtin_popcount(newlines);
+    }
+    return end;
+}
+
+// Signed compares, so bytes above 127 are outside of every range
+static __m128i inRangeSse2(__m128i block, char low, char high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8(high + 1)));
+}
+
+static size_t skipIdentifierSse2(const char* text, size_t pos) {
+    for (;; pos += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(text + pos));
+        __m128i letter = inRangeSse2(_mm_or_si128(block, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i digit = inRangeSse2(block, '0', '9');
+        __m128i underscore = _mm_cmpeq_epi8(block, _mm_set1_epi8('_'));
+        __m128i isIdentifier = _mm_or_si128(_mm_or_si128(letter, digit), underscore);
+        unsigned stops = ~(unsigned)_mm_movemask_epi8(isIdentifier) & 0xFFFF;
+        if (stops) {
+            return pos + __builtin_ctz(stops);
+        }
+    }
+}
+
+static const ScanKernel sse2Kernel = {"sse2", skipWhitespaceSse2, findByteSse2, skipIdentifierSse2};
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static size_t skipWhitespaceAvx2(const char* text, size_t pos, long long* lines) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (;; pos += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(text + pos));
+        __m256i isNewline = _mm256_cmpeq_epi8(block, newline);
+        __m256i isBlank = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)), isNewline);
+        unsigned stops = ~(unsigned)_mm256_movemask_epi8(isBlank);
+        unsigned newlines = _mm256_movemask_epi8(isNewline);
+        if (stops) {
+            return stopAt(pos, stops, newlines, lines);
+        }
+        *lines += __builtin_popcount(newlines);
+    }
+}
+
+AVX2 static size_t findByteAvx2(const char* text, size_t pos, size_t end, char byte, long long* lines) {
+    const __m256i wanted = _mm256_set1_epi8(byte);
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; pos < end; pos += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(text + pos));
+        unsigned stops = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, wanted));
+        unsigned newlines = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline));
+        if (stops) {
+            return stopAt(pos, stops, newlines, lines);
+        }
+        *lines += __builtin_popcount(newlines);
+    }
+    return end;
+}
+
+AVX2 static __m256i inRangeAvx2(__m256i block, char low, char high) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8(low - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), block));
+}
+
+AVX2 static size_t skipIdentifierAvx2(const char* text, size_t pos) {
+    for (;; pos += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(text + pos));
+        __m256i letter = inRangeAvx2(_mm256_or_si256(block, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i digit = inRangeAvx2(block, '0', '9');
+        __m256i underscore = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('_'));
+        __m256i isIdentifier = _mm256_or_si256(_mm256_or_si256(letter, digit), underscore);
+        unsigned stops = ~(unsigned)_mm256_movemask_epi8(isIdentifier);
+        if (stops) {
+            return pos + __builtin_ctz(stops);
+        }
+    }
+}
+
+static const ScanKernel avx2Kernel = {"avx2", skipWhitespaceAvx2, findByteAvx2, skipIdentifierAvx2};
+#endif
+
+static const ScanKernel* selectKernel(FastScanKernel requested) {
+    const ScanKernel* best = &scalarKernel;
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    best = __builtin_cpu_supports("avx2") ? &avx2Kernel : &sse2Kernel;
+    if (requested == FAST_SCAN_SSE2 || (requested == FAST_SCAN_AVX2 && best == &avx2Kernel)) {
+        return requested == FAST_SCAN_SSE2 ? &sse2Kernel : &avx2Kernel;
+    }
+#endif
+    if (requested == FAST_SCAN_SSE2 || requested == FAST_SCAN_AVX2) {
+        fprintf(stderr, "Warning: the %s scanner kernel is not supported here, using %s\n",
+                requested == FAST_SCAN_SSE2 ? "sse2" : "avx2", best->name);
+        return best;
+    }
+    return requested == FAST_SCAN_SCALAR ? &scalarKernel : best;
+}
+
+static const ScanKernel* kernel;
+static char* input;
+static size_t inputLength;
+
+const char* readScannerInput(size_t* length) {
+    if (input == NULL) {
+        kernel = selectKernel((FastScanKernel)compilerOptions.fastScan);
+        size_t capacity = 1 << 16;
+        input = (char*)malloc(capacity + INPUT_PADDING);
+        size_t count;
+        while ((count = fread(input + inputLength, 1, capacity - inputLength, yyin)) > 0) {
+            inputLength += count;
+            if (inputLength == capacity) {
+                capacity *= 2;
+                input = (char*)realloc(input, capacity + INPUT_PADDING);
+            }
+        }
+        memset(input + inputLength, 0, INPUT_PADDING);
+        PROFILE_ALLOCATION(MEMORY_LEXER, capacity + INPUT_PADDING);
+    }
+    *length = inputLength;
+    return input;
+}
+
+void startScan(ScanCursor* cursor, const char* text, size_t length, size_t position) {
+    cursor->kernel = kernel;
+    cursor->input = text;
+    cursor->length = length;
+    cursor->position = position;
+    cursor->lines = 0;
+}
+
+static const struct {
+    const char* text;
+    size_t length;
+    int token;
+} keywords[] = {
+    {"while", 5, WHILE},   {"repeat", 6, REPEAT},     {"until", 5, UNTIL},   {"for", 3, FOR},
+    {"switch", 6, SWITCH}, {"case", 4, CASE},         {"if", 2, IF},         {"then", 4, THEN},
+    {"else", 4, ELSE},     {"function", 8, FUNCTION}, {"return", 6, RETURN}, {"int", 3, INT},
+    {"float", 5, FLOAT},   {"bool", 4, BOOL},         {"char", 4, CHAR},     {"string", 6, STRING},
+    {"const", 5, CONST},   {"void", 4, VOID},         {"import", 6, IMPORT},
+};
+
+static int wordToken(const char* text, size_t length) {
+    if ((length == 4 && memcmp(text, "True", 4) == 0) || (length == 5 && memcmp(text, "False", 5) == 0)) {
+        return BOOLEAN;
+    }
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+        if (keywords[i].length == length && memcmp(keywords[i].text, text, length) == 0) {
+            return keywords[i].token;
+        }
+    }
+    return VARIABLE;
+}
+
+static int isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static size_t numberEnd(const char* text, size_t start, int* token) {
+    size_t end = start + 1;
+    if (text[start] != '0') {
+        while (isDigit(text[end])) {
+            end++;
+        }
+    }
+    *token = INTEGER;
+    if (text[end] == '.' && isDigit(text[end + 1])) {
+        for (end += 2; isDigit(text[end]); end++) {
+        }
+        *token = FLOATING;
+    }
+    return end;
+}
+
+// The operators of lexer.l, 0 when the byte starts no token
+static size_t operatorEnd(const char* text, size_t start, int* token) {
+    char c = text[start];
+    char next = text[start + 1];
+    if (next == '=' && (c == '>' || c == '<' || c == '=' || c == '!')) {
+        *token = c == '>' ? GE : c == '<' ? LE : c == '=' ? EQ : NE;
+        return start + 2;
+    }
+    *token = c;
+    if ((c == '&' && next == '&') || (c == '|' && next == '|')) {
+        return start + 2;
+    }
+    if (c == '\0' || strchr("-+/*(){}^.=;><?:,", c) == NULL) {
+        *token = 0;
+    }
+    return start + 1;
+}
+
+static int finishToken(ScanCursor* cursor, ScannedToken* token, int code, size_t start, size_t end, long long linesInside) {
+    token->token = code;
+    token->error = SCAN_ERROR_NONE;
+    token->start = start;
+    token->end = end;
+    token->linesBefore = cursor->lines;
+    token->linesInside = (int)linesInside;
+    if (code == 0) {
+        token->error = SCAN_ERROR_INVALID_CHARACTER;
+    }
+    cursor->position = end;
+    cursor->lines += linesInside;
+    return 1;
+}
+
+// Longest match first, with the rule order of lexer.l deciding between keywords and identifiers. Whitespace,
+// comments, strings and identifiers are scanned by the kernel of --fast-scan, everything else byte by byte.
+int scanNextToken(ScanCursor* cursor, size_t limit, ScannedToken* token) {
+    const ScanKernel* scanKernel = (const ScanKernel*)cursor->kernel;
+    const char* text = cursor->input;
+    size_t length = cursor->length;
+    for (;;) {
+        size_t start = cursor->position;
+        if (start >= limit || start >= length) {
+            return 0;
+        }
+        char c = text[start];
+        if (c == ' ' || c == '\t' || c == '\n') {
+            cursor->position = scanKernel->skipWhitespace(text, start, &cursor->lines);
+        } else if (c == '/' && text[start + 1] == '/') {
+            cursor->position = scanKernel->findByte(text, start + 2, length, '\n', &cursor->lines);
+        } else if (c == '/' && text[start + 1] == '*') {
+            long long lines = 0;
+            size_t pos = start + 2;
+            while ((pos = scanKernel->findByte(text, pos, length, '*', &lines)) < length) {
+                while (text[pos] == '*') {
+                    pos++;
+                }
+                if (text[pos] == '/') {
+                    break;
+                }
+            }
+            if (pos < length) {
+                cursor->position = pos + 1;
+                cursor->lines += lines;
+                continue;
+            }
+            // unterminated, flex matches it up to the first star
+            lines = 0;
+            size_t end = scanKernel->findByte(text, start + 2, length, '*', &lines);
+            finishToken(cursor, token, 0, start, end, lines);
+            token->error = SCAN_ERROR_UNTERMINATED_COMMENT;
+            return 1;
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+            size_t end = scanKernel->skipIdentifier(text, start + 1);
+            return finishToken(cursor, token, wordToken(text + start, end - start), start, end, 0);
+        } else if (isDigit(c)) {
+            int code;
+            size_t end = numberEnd(text, start, &code);
+            return finishToken(cursor, token, code, start, end, 0);
+        } else if (c == '"') {
+            long long lines = 0;
+            size_t end = scanKernel->findByte(text, start + 1, length, '"', &lines);
+            return end < length ? finishToken(cursor, token, CHARARRAY, start, end + 1, lines)
+                                : finishToken(cursor, token, 0, start, start + 1, 0);
+        } else if (c == '\'' && text[start + 1] == '\'') {
+            return finishToken(cursor, token, CHARACTER, start, start + 2, 0);
+        } else if (c == '\'' && start + 2 < length && text[start + 2] == '\'') {
+            return finishToken(cursor, token, CHARACTER, start, start + 3, text[start + 1] == '\n');
+        } else {
+            int code;
+            size_t end = operatorEnd(text, start, &code);
+            return finishToken(cursor, token, code, start, end, 0);
+        }
+    }
+}
+
+int emitScannedToken(const ScannedToken* token, char* text, long long firstLine) {
+    yylineno = (int)(firstLine + token->linesBefore + token->linesInside);
+    yytext = text;
+    switch (token->error) {
+        case SCAN_ERROR_INVALID_CHARACTER:
+            yyerror("Invalid character");
+            break;
+        case SCAN_ERROR_UNTERMINATED_COMMENT:
+            yyerror("Unterminated comment");
+            break;
+        case SCAN_ERROR_NONE:
+            break;
+    }
+    switch (token->token) {
+        case INTEGER:
+            yylval.integer = atoi(text);
+            break;
+        case FLOATING:
+            yylval.floating = atof(text);
+            break;
+        case CHARACTER:
+            yylval.character = text[1];
+            break;
+        case BOOLEAN:
+            yylval.integer = text[0] == 'T';
+            break;
+        case VARIABLE:
+        case CHARARRAY:
+            yylval.string = copyTokenText(text);
+            break;
+        default:
+            // operators are returned as their character and keep their text too, keywords have no value
+            if (token->token > 0 && token->token < 256) {
+                yylval.string = copyTokenText(text);
+            }
+            break;
+    }
+    return token->token;
+}
+
+static ScanCursor cursor;
+// Like flex, the byte after the current token is replaced by the terminator of yytext until the next call
+static size_t heldPosition;
+static char heldByte;
+
+// The scanner of --fast-scan: same tokens, semantic values, yytext and yylineno as the flex rules of lexer.l
+int fastScanToken(void) {
+    if (cursor.input == NULL) {
+        size_t length;
+        const char* text = readScannerInput(&length);
+        startScan(&cursor, text, length, 0);
+        heldPosition = length;
+    }
+    input[heldPosition] = heldByte;
+    ScannedToken token;
+    if (!scanNextToken(&cursor, inputLength, &token)) {
+        token.token = 0;
+        token.error = SCAN_ERROR_NONE;
+        token.start = token.end = inputLength;
+        token.linesBefore = cursor.lines;
+        token.linesInside = 0;
+    }
+    heldPosition = token.end;
+    heldByte = input[token.end];
+    input[token.end] = '\0';
+    return emitScannedToken(&token, input + token.start, 1);
+}
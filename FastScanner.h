@@ -0,0 +1,52 @@
+#ifndef FAST_SCANNER_H
+#define FAST_SCANNER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SCAN_ERROR_NONE,
+    SCAN_ERROR_INVALID_CHARACTER,
+    SCAN_ERROR_UNTERMINATED_COMMENT
+} ScanError;
+
+// A token found by the fast scanner, before its semantic value is computed. Line counts are relative to the
+// position the scan started at.
+typedef struct {
+    int token;      // token code, 0 for the end of the input and for a lexical error
+    ScanError error;
+    size_t start;   // yytext is input[start, end)
+    size_t end;
+    long long linesBefore;  // newlines between the start of the scan and start
+    int linesInside;        // newlines inside the token text
+} ScannedToken;
+
+// Scans the input from any position, without touching the flex globals, so the chunks of --parallel-lex can
+// be scanned by several threads at once. The scanner is stateless between tokens: two scans that find a
+// token at the same position find the same tokens from there on.
+typedef struct {
+    const void* kernel;
+    const char* input;
+    size_t length;
+    size_t position;
+    long long lines;  // newlines stepped over since the scan started
+} ScanCursor;
+
+// The whole of yyin, followed by zero padding; read at the first call
+const char* readScannerInput(size_t* length);
+void startScan(ScanCursor* cursor, const char* input, size_t length, size_t position);
+// Skips whitespace and comments, then returns 0 with the cursor there when it reached limit, otherwise scans
+// the next token. A lexical error is returned as a token and the scan continues after the text flex matched.
+int scanNextToken(ScanCursor* cursor, size_t limit, ScannedToken* token);
+// Sets yylineno (firstLine plus the lines before and inside the token), yytext and yylval like the flex rule
+// would and returns the token code, or reports the lexical error through yyerror. text is the token text.
+int emitScannedToken(const ScannedToken* token, char* text, long long firstLine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
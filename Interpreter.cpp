@@ -0,0 +1,1216 @@
+#include "Interpreter.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "QuadrupleManager.hpp"
+#include "Vendor/VariadicTable.h"
+#include "common.h"
+
+static_assert(sizeof(RuntimeValue) == 8, "values are a 32 bit payload and its tag");
+
+// Deeper recursion is reported as an error instead of exhausting memory
+static const size_t maxCallDepth = 100000;
+
+static const unordered_map<string, Opcode> opcodeOf = {
+    {"ASSIGN", OPCODE_ASSIGN}, {"ADD", OPCODE_ADD}, {"SUB", OPCODE_SUB}, {"MUL", OPCODE_MUL}, {"DIV", OPCODE_DIV},
+    {"POW", OPCODE_POW},       {"NEG", OPCODE_NEG}, {"LT", OPCODE_LT},   {"GT", OPCODE_GT},   {"LTE", OPCODE_LTE},
+    {"GTE", OPCODE_GTE},       {"EQ", OPCODE_EQ},   {"NEQ", OPCODE_NEQ}, {"AND", OPCODE_AND}, {"OR", OPCODE_OR},
+    {"JMP", OPCODE_JMP},       {"JF", OPCODE_JF},   {"JT", OPCODE_JT},   {"SWITCH", OPCODE_SWITCH},
+    {"PARAM", OPCODE_PARAM},   {"CALL", OPCODE_CALL}, {"TAILCALL", OPCODE_TAILCALL}, {"RET", OPCODE_RET},
+    {"ENTER", OPCODE_NOP},     {"JTAB", OPCODE_NOP}};
+
+static RuntimeValue zeroValue(Type type) {
+    RuntimeValue value;
+    value.type = type == VOID_T ? INTEGER_T : type;
+    return value;
+}
+
+static RuntimeValue integerValue(Type type, int integer) {
+    RuntimeValue value;
+    value.type = type;
+    value.integer = type == CHAR_T ? (signed char)integer : integer;
+    return value;
+}
+
+static RuntimeValue floatValue(float floating) {
+    RuntimeValue value;
+    value.type = FLOAT_T;
+    value.floating = floating;
+    return value;
+}
+
+// Float to int as the x86 conversion instruction does it: out of range values give INT_MIN
+static int truncateFloat(float floating) {
+    if (!(floating >= -2147483648.0f && floating < 2147483648.0f)) {
+        return INT32_MIN;
+    }
+    return (int)floating;
+}
+
+static float toFloat(const RuntimeValue& value) {
+    return value.type == FLOAT_T ? value.floating : (float)value.integer;
+}
+
+static bool isTrue(const RuntimeValue& value) {
+    if (value.type == FLOAT_T) {
+        return value.floating != 0;
+    }
+    return value.type == STRING_T || value.integer != 0;
+}
+
+static bool isIntegerType(Type type) {
+    return type == INTEGER_T || type == CHAR_T || type == BOOLEAN_T;
+}
+
+// Value as stored into a variable of the given type, VOID_T keeps it as it is
+static RuntimeValue convertValue(const RuntimeValue& value, Type type) {
+    if (type == VOID_T || type == value.type) {
+        return value;
+    }
+    if (type == FLOAT_T) {
+        return floatValue(toFloat(value));
+    }
+    // the semantic checks only let strings into strings, anything else is converted to "" or 0
+    if (type == STRING_T || value.type == STRING_T) {
+        RuntimeValue converted;
+        converted.type = type;
+        return converted;
+    }
+    return integerValue(type, value.type == FLOAT_T ? truncateFloat(value.floating) : value.integer);
+}
+
+template <typename T>
+static bool compare(Opcode opcode, T a, T b) {
+    switch (opcode) {
+        case OPCODE_LT:
+            return a < b;
+        case OPCODE_GT:
+            return a > b;
+        case OPCODE_LTE:
+            return a <= b;
+        case OPCODE_GTE:
+            return a >= b;
+        case OPCODE_EQ:
+            return a == b;
+        default:
+            return a != b;
+    }
+}
+
+static int wrappingPower(int base, int exponent) {
+    if (exponent < 0) {
+        return base == 1 ? 1 : base == -1 ? (exponent % 2 ? -1 : 1) : 0;
+    }
+    unsigned result = 1;
+    while (exponent-- > 0) {
+        result *= (unsigned)base;
+    }
+    return (int)result;
+}
+
+Interpreter::Interpreter(const vector<Quadruple>& quadruples) {
+    load(quadruples);
+}
+
+int Interpreter::internString(const string& text) {
+    auto it = stringOf.find(text);
+    if (it == stringOf.end()) {
+        it = stringOf.insert({text, (int)strings.size()}).first;
+        strings.push_back(text);
+    }
+    return it->second;
+}
+
+void Interpreter::load(const vector<Quadruple>& quadruples) {
+    internString("");
+    unordered_map<string, Type> variableTypes;
+    for (Variable* variable : getAllVariables()) {
+        variableTypes.insert({variable->getName(), variable->getType()});
+    }
+
+    // functions and labels first, calls and jumps may come before what they refer to
+    RuntimeFunction globalCode;
+    globalCode.name = "global";
+    functions.push_back(globalCode);
+    vector<Function*> symbols = {nullptr};
+    unordered_map<string, int> labelPositions;
+    vector<int> functionOf(quadruples.size(), 0);
+    vector<pair<int, string>> open;  // functions whose body is still open, with the label that ends it
+    for (size_t i = 0; i < quadruples.size(); i++) {
+        const Quadruple& quad = quadruples[i];
+        if (!open.empty() && quad.getOp() == open.back().second) {
+            open.pop_back();
+        }
+        bool isEntry = quad.isLabel() && i > 0 && i + 1 < quadruples.size() && quadruples[i + 1].getOp() == "ENTER" &&
+                       quadruples[i - 1].getOp() == "JMP" && !quadruples[i - 1].getResult().empty();
+        if (isEntry) {
+            Function* symbol = getFunctionByLabel(quad.getOp());
+            RuntimeFunction function;
+            function.name = symbol != nullptr ? symbol->getName() : quad.getOp();
+            function.symbol = symbol;
+            function.entry = i;
+            function.parent = open.empty() ? 0 : open.back().first;
+            if (symbol != nullptr) {
+                function.returnType = symbol->getType();
+                function.argumentCount = symbol->getArguments()->size();
+                for (const string& slot : symbol->getFrameSlots()) {
+                    auto type = variableTypes.find(slot);
+                    function.slotTypes.push_back(type == variableTypes.end() ? VOID_T : type->second);
+                }
+                for (int argument = 0; argument < function.argumentCount; argument++) {
+                    function.slotTypes[argument] = (*symbol->getArguments())[argument]->getType();
+                }
+            }
+            functionOfLabel[quad.getOp()] = functions.size();
+            open.push_back({(int)functions.size(), quadruples[i - 1].getResult()});
+            functions.push_back(function);
+            symbols.push_back(symbol);
+        }
+        functionOf[i] = open.empty() ? 0 : open.back().first;
+        if (quad.isLabel()) {
+            labelPositions[quad.getOp()] = i;
+        }
+    }
+    calls.assign(functions.size(), 0);
+
+    unordered_map<string, int> literalOf;
+    auto resolve = [&](const string& name, int function) {
+        Operand operand;
+        if (name.empty()) {
+            return operand;
+        }
+        Function* symbol = symbols[function];
+        int slot = symbol != nullptr ? symbol->getFrameSlot(name) : -1;
+        if (slot >= 0) {
+            operand.kind = OPERAND_LOCAL;
+            operand.index = slot;
+            return operand;
+        }
+        for (int enclosing = functions[function].parent, hops = 1; enclosing != 0; enclosing = functions[enclosing].parent, hops++) {
+            slot = symbols[enclosing] != nullptr ? symbols[enclosing]->getFrameSlot(name) : -1;
+            if (slot >= 0) {
+                EnclosingSlot enclosingSlot;
+                enclosingSlot.hops = hops;
+                enclosingSlot.function = enclosing;
+                enclosingSlot.slot = slot;
+                operand.kind = OPERAND_ENCLOSING;
+                operand.index = enclosingSlots.size();
+                enclosingSlots.push_back(enclosingSlot);
+                return operand;
+            }
+        }
+        if (Quadruple::isNumericLiteral(name) || Quadruple::isCharLiteral(name) || name[0] == '"') {
+            auto it = literalOf.find(name);
+            if (it == literalOf.end()) {
+                RuntimeValue literal;
+                if (Quadruple::isCharLiteral(name)) {
+                    literal = integerValue(CHAR_T, Quadruple::getCharLiteralValue(name));
+                } else if (Quadruple::isNumericLiteral(name)) {
+                    literal = name.find('.') != string::npos ? floatValue(stof(name)) : integerValue(INTEGER_T, (int)(unsigned)stoll(name));
+                } else {
+                    literal.type = STRING_T;
+                    literal.string = internString(name.substr(1, name.size() - 2));
+                }
+                it = literalOf.insert({name, (int)literals.size()}).first;
+                literals.push_back(literal);
+            }
+            operand.kind = OPERAND_LITERAL;
+            operand.index = it->second;
+            return operand;
+        }
+        auto it = globalOf.find(name);
+        if (it == globalOf.end()) {
+            auto type = variableTypes.find(name);
+            it = globalOf.insert({name, (int)globalNames.size()}).first;
+            globalNames.push_back(name);
+            globalTypes.push_back(type == variableTypes.end() ? VOID_T : type->second);
+        }
+        operand.kind = OPERAND_GLOBAL;
+        operand.index = it->second;
+        return operand;
+    };
+    auto position = [&](const string& label) {
+        auto it = labelPositions.find(label);
+        if (it == labelPositions.end()) {
+            error = "jump to the undefined label " + label;
+            return (int)quadruples.size();
+        }
+        return it->second;
+    };
+
+    unordered_map<long long, int> rowOf;
+    instructions.resize(quadruples.size());
+    for (size_t i = 0; i < quadruples.size(); i++) {
+        const Quadruple& quad = quadruples[i];
+        Instruction& instruction = instructions[i];
+        instruction.function = functionOf[i];
+        instruction.line = quad.getLine();
+        long long rowKey = ((long long)instruction.function << 32) | (unsigned)instruction.line;
+        auto row = rowOf.find(rowKey);
+        if (row == rowOf.end()) {
+            ProfileRow profileRow;
+            profileRow.function = instruction.function;
+            profileRow.line = instruction.line;
+            row = rowOf.insert({rowKey, (int)profileRows.size()}).first;
+            profileRows.push_back(profileRow);
+        }
+        instruction.profileRow = row->second;
+
+        if (quad.isLabel()) {
+            instruction.opcode = OPCODE_LABEL;
+            continue;
+        }
+        auto opcode = opcodeOf.find(quad.getOp());
+        if (opcode == opcodeOf.end()) {
+            error = "unknown operator " + quad.getOp();
+            continue;
+        }
+        instruction.opcode = opcode->second;
+        int function = instruction.function;
+        switch (instruction.opcode) {
+            case OPCODE_NOP:
+                break;
+            case OPCODE_JMP:
+                instruction.target = position(quad.getJumpTarget());
+                break;
+            case OPCODE_JF:
+            case OPCODE_JT:
+                instruction.arg1 = resolve(quad.getArg1(), function);
+                instruction.target = position(quad.getResult());
+                break;
+            case OPCODE_SWITCH: {
+                instruction.arg1 = resolve(quad.getArg1(), function);
+                instruction.arg2 = resolve(quad.getArg2(), function);
+                instruction.target = position(quad.getResult());
+                instruction.extra = jumpTables.size();
+                jumpTables.emplace_back();
+                for (size_t entry = i + 1; entry < quadruples.size() && quadruples[entry].getOp() == "JTAB"; entry++) {
+                    jumpTables.back().push_back(position(quadruples[entry].getResult()));
+                }
+                break;
+            }
+            case OPCODE_PARAM:
+                instruction.arg1 = resolve(quad.getArg1(), function);
+                break;
+            case OPCODE_CALL:
+            case OPCODE_TAILCALL: {
+                auto callee = functionOfLabel.find(quad.getArg1());
+                if (callee == functionOfLabel.end()) {
+                    error = "call of the unknown function " + quad.getArg1();
+                    break;
+                }
+                instruction.target = callee->second;
+                instruction.extra = stoi(quad.getArg2());
+                instruction.result = resolve(quad.getResult(), function);
+                break;
+            }
+            case OPCODE_RET:
+                instruction.arg1 = resolve(quad.getArg1(), function);
+                break;
+            default:
+                instruction.arg1 = resolve(quad.getArg1(), function);
+                instruction.arg2 = resolve(quad.getArg2(), function);
+                instruction.result = resolve(quad.getResult(), function);
+                break;
+        }
+    }
+    if (error.empty()) {
+        inferTemporaryTypes();
+        specializeInstructions();
+        findPureFunctions();
+    }
+}
+
+// Functions start out pure and lose it with an instruction touching a global or the frame of a function they are
+// nested in, or with a call of an impure function, which is looked at again until nothing changes so that
+// recursive functions stay pure
+void Interpreter::findPureFunctions() {
+    pure.assign(functions.size(), true);
+    pure[0] = false;  // the global code
+    auto isShared = [](const Operand& operand) { return operand.kind == OPERAND_GLOBAL || operand.kind == OPERAND_ENCLOSING; };
+    for (const Instruction& instruction : instructions) {
+        if (isShared(instruction.arg1) || isShared(instruction.arg2) || isShared(instruction.result)) {
+            pure[instruction.function] = false;
+        }
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const Instruction& instruction : instructions) {
+            bool isCall = instruction.opcode == OPCODE_CALL || instruction.opcode == OPCODE_TAILCALL;
+            if (isCall && pure[instruction.function] && !pure[instruction.target]) {
+                pure[instruction.function] = false;
+                changed = true;
+            }
+        }
+    }
+}
+
+bool Interpreter::isPureFunction(const string& label) const {
+    auto it = functionOfLabel.find(label);
+    return it != functionOfLabel.end() && it->second < (int)pure.size() && pure[it->second];
+}
+
+Type Interpreter::knownType(const Operand& operand, int function) const {
+    switch (operand.kind) {
+        case OPERAND_LITERAL:
+            return literals[operand.index].type;
+        case OPERAND_GLOBAL:
+            return knownGlobalTypes[operand.index];
+        case OPERAND_LOCAL:
+            return functions[function].knownTypes[operand.index];
+        case OPERAND_ENCLOSING: {
+            const EnclosingSlot& enclosing = enclosingSlots[operand.index];
+            return functions[enclosing.function].knownTypes[enclosing.slot];
+        }
+        default:
+            return VOID_T;
+    }
+}
+
+// Declared variables always hold their own type. A temporary gets a type when every instruction storing into it
+// stores that type, which is looked at again until no temporary changes, since temporaries are stored from one
+// another. The others, and the temporaries nothing is stored into, stay VOID_T and keep their tag checks.
+void Interpreter::inferTemporaryTypes() {
+    const int unseen = -1, varies = -2;
+    vector<int> globalStates(globalTypes.begin(), globalTypes.end());
+    vector<vector<int>> slotStates;
+    for (const RuntimeFunction& function : functions) {
+        slotStates.emplace_back(function.slotTypes.begin(), function.slotTypes.end());
+    }
+    for (int& state : globalStates) {
+        state = state == VOID_T ? unseen : state;
+    }
+    for (vector<int>& states : slotStates) {
+        for (int& state : states) {
+            state = state == VOID_T ? unseen : state;
+        }
+    }
+    auto stateOf = [&](const Operand& operand, int function) -> int {
+        switch (operand.kind) {
+            case OPERAND_LITERAL:
+                return literals[operand.index].type;
+            case OPERAND_GLOBAL:
+                return globalStates[operand.index];
+            case OPERAND_LOCAL:
+                return slotStates[function][operand.index];
+            case OPERAND_ENCLOSING: {
+                // only declared variables are used from an enclosing frame
+                const EnclosingSlot& enclosing = enclosingSlots[operand.index];
+                return slotStates[enclosing.function][enclosing.slot];
+            }
+            default:
+                return varies;
+        }
+    };
+    // type of the value an instruction stores, before it is converted to the type of a declared variable
+    auto storedState = [&](const Instruction& instruction) -> int {
+        switch (instruction.opcode) {
+            case OPCODE_ASSIGN:
+            case OPCODE_ADD:
+            case OPCODE_SUB:
+            case OPCODE_MUL:
+            case OPCODE_DIV:
+            case OPCODE_POW:
+                return stateOf(instruction.arg1, instruction.function);
+            case OPCODE_NEG:
+                return stateOf(instruction.arg2, instruction.function);
+            case OPCODE_LT:
+            case OPCODE_GT:
+            case OPCODE_LTE:
+            case OPCODE_GTE:
+            case OPCODE_EQ:
+            case OPCODE_NEQ:
+            case OPCODE_AND:
+            case OPCODE_OR:
+                return BOOLEAN_T;
+            case OPCODE_CALL:
+            case OPCODE_TAILCALL:
+                return functions[instruction.target].returnType == VOID_T ? INTEGER_T : functions[instruction.target].returnType;
+            default:
+                return unseen;
+        }
+    };
+
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const Instruction& instruction : instructions) {
+            const Operand& result = instruction.result;
+            int* state = nullptr;
+            if (result.kind == OPERAND_GLOBAL && globalTypes[result.index] == VOID_T) {
+                state = &globalStates[result.index];
+            } else if (result.kind == OPERAND_LOCAL && functions[instruction.function].slotTypes[result.index] == VOID_T) {
+                state = &slotStates[instruction.function][result.index];
+            }
+            int stored = state != nullptr ? storedState(instruction) : unseen;
+            if (stored == unseen || *state == varies || *state == stored) {
+                continue;
+            }
+            *state = *state == unseen ? stored : varies;
+            changed = true;
+        }
+    }
+
+    knownGlobalTypes.clear();
+    for (int state : globalStates) {
+        knownGlobalTypes.push_back(state >= 0 ? (Type)state : VOID_T);
+    }
+    for (size_t f = 0; f < functions.size(); f++) {
+        functions[f].knownTypes.clear();
+        for (int state : slotStates[f]) {
+            functions[f].knownTypes.push_back(state >= 0 ? (Type)state : VOID_T);
+        }
+    }
+}
+
+// A slot of a known type only ever holds values with that tag, so the typed variants write the payload alone
+void Interpreter::specializeInstructions() {
+    for (Instruction& instruction : instructions) {
+        int function = instruction.function;
+        Type left = knownType(instruction.arg1, function);
+        Type right = knownType(instruction.arg2, function);
+        Type result = knownType(instruction.result, function);
+        bool intoSlot = instruction.result.kind == OPERAND_GLOBAL || instruction.result.kind == OPERAND_LOCAL;
+        bool integers = intoSlot && left == INTEGER_T && right == INTEGER_T && result == INTEGER_T;
+        bool floats = intoSlot && left == FLOAT_T && right == FLOAT_T && result == FLOAT_T;
+        bool compared = intoSlot && isIntegerType(left) && isIntegerType(right) && result == BOOLEAN_T;
+        Opcode& opcode = instruction.opcode;
+        switch (opcode) {
+            case OPCODE_ASSIGN:
+                opcode = intoSlot && left != VOID_T && left == result ? OPCODE_COPY : opcode;
+                break;
+            case OPCODE_ADD:
+                opcode = integers ? OPCODE_ADD_INT : floats ? OPCODE_ADD_FLOAT : opcode;
+                break;
+            case OPCODE_SUB:
+                opcode = integers ? OPCODE_SUB_INT : floats ? OPCODE_SUB_FLOAT : opcode;
+                break;
+            case OPCODE_MUL:
+                opcode = integers ? OPCODE_MUL_INT : floats ? OPCODE_MUL_FLOAT : opcode;
+                break;
+            case OPCODE_DIV:
+                // integer division keeps its checks for zero
+                opcode = floats ? OPCODE_DIV_FLOAT : opcode;
+                break;
+            case OPCODE_LT:
+                opcode = compared ? OPCODE_LT_INT : opcode;
+                break;
+            case OPCODE_GT:
+                opcode = compared ? OPCODE_GT_INT : opcode;
+                break;
+            case OPCODE_LTE:
+                opcode = compared ? OPCODE_LTE_INT : opcode;
+                break;
+            case OPCODE_GTE:
+                opcode = compared ? OPCODE_GTE_INT : opcode;
+                break;
+            case OPCODE_EQ:
+                opcode = compared ? OPCODE_EQ_INT : opcode;
+                break;
+            case OPCODE_NEQ:
+                opcode = compared ? OPCODE_NEQ_INT : opcode;
+                break;
+            case OPCODE_JF:
+                opcode = left == BOOLEAN_T ? OPCODE_JF_BOOL : opcode;
+                break;
+            case OPCODE_JT:
+                opcode = left == BOOLEAN_T ? OPCODE_JT_BOOL : opcode;
+                break;
+            default:
+                break;
+        }
+    }
+    // functions whose access link is followed, by their own instructions or by the functions nested in them
+    vector<bool> usesLink(functions.size(), false);
+    auto markLinks = [&](int function, int enclosing) {
+        for (; function != 0 && function != enclosing; function = functions[function].parent) {
+            usesLink[function] = true;
+        }
+    };
+    for (const Instruction& instruction : instructions) {
+        for (const Operand* operand : {&instruction.arg1, &instruction.arg2, &instruction.result}) {
+            if (operand->kind == OPERAND_ENCLOSING) {
+                markLinks(instruction.function, enclosingSlots[operand->index].function);
+            }
+        }
+        if ((instruction.opcode == OPCODE_CALL || instruction.opcode == OPCODE_TAILCALL) && functions[instruction.target].parent != 0) {
+            markLinks(instruction.function, functions[instruction.target].parent);
+        }
+    }
+    // the callee of a TAILCALL returns straight to the caller of the function, so a chain of tail calls runs in one
+    // frame. One that no longer comes before the RET of its result, as inlining leaves it, is an ordinary CALL, and so
+    // is a call of a function nested in the caller that reaches the frame of the caller through its access link.
+    for (size_t i = 0; i < instructions.size(); i++) {
+        Instruction& call = instructions[i];
+        if (call.opcode != OPCODE_TAILCALL) {
+            continue;
+        }
+        const Instruction* ret = i + 1 < instructions.size() ? &instructions[i + 1] : nullptr;
+        bool returnsResult = ret != nullptr && ret->opcode == OPCODE_RET && ret->function == call.function &&
+                             (ret->arg1.kind == OPERAND_NONE ? call.result.kind == OPERAND_NONE
+                                                             : ret->arg1.kind == call.result.kind && ret->arg1.index == call.result.index);
+        if (!returnsResult || call.function == 0 || functions[call.target].returnType != functions[call.function].returnType ||
+            (functions[call.target].parent == call.function && usesLink[call.target])) {
+            call.opcode = OPCODE_CALL;
+        }
+    }
+}
+
+void Interpreter::enableProfiling() {
+    profiling = true;
+}
+
+void Interpreter::setInstructionBudget(long long budget) {
+    instructionBudget = budget;
+}
+
+void Interpreter::enableMemoization(size_t entries) {
+    memoEntries = 1;
+    while (memoEntries < entries) {
+        memoEntries *= 2;
+    }
+}
+
+static size_t hashArguments(const RuntimeValue* arguments, int count) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int i = 0; i < count; i++) {
+        hash = (hash ^ (unsigned)arguments[i].integer) * 1099511628211ULL;
+    }
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+void Interpreter::enableJumpRecording() {
+    recordingJumps = true;
+    executions.assign(instructions.size(), 0);
+    taken.assign(instructions.size(), 0);
+}
+
+const string& Interpreter::getError() const {
+    return error;
+}
+
+int Interpreter::getStackNode(int parent, int function) {
+    long long key = ((long long)parent << 32) | (unsigned)function;
+    auto it = stackNodeOf.find(key);
+    if (it != stackNodeOf.end()) {
+        return it->second;
+    }
+    ProfileStackNode node;
+    node.parent = parent;
+    node.function = function;
+    stackNodes.push_back(node);
+    stackNodeOf[key] = stackNodes.size() - 1;
+    return stackNodes.size() - 1;
+}
+
+bool Interpreter::fail(const Instruction& instruction, const string& message) {
+    error = "Line " + to_string(instruction.line) + " Runtime Error: " + message;
+    return false;
+}
+
+bool Interpreter::run() {
+    if (!error.empty()) {
+        return false;
+    }
+    globals.clear();
+    for (Type type : knownGlobalTypes) {
+        globals.push_back(zeroValue(type));
+    }
+
+    struct CallFrame {
+        size_t base;
+        size_t returnPosition;
+        int stackNode;
+        int function;   // called function, whose memo table gets the result even after tail calls replaced it
+        int memoEntry;  // entry the result goes into, -1 when the call is not memoized
+    };
+    memoTables.assign(functions.size(), MemoTable());
+    memoKeys.clear();
+    for (size_t f = 0; f < functions.size() && memoEntries > 0; f++) {
+        if (pure[f]) {
+            MemoTable& table = memoTables[f];
+            table.argumentCount = min<int>(functions[f].argumentCount, functions[f].slotTypes.size());
+            table.arguments.resize(memoEntries * table.argumentCount);
+            table.results.resize(memoEntries);
+            table.filled.assign(memoEntries, 0);
+        }
+    }
+    vector<RuntimeValue> stack;  // frames of the active calls, one after the other
+    vector<CallFrame> frames;
+    vector<RuntimeValue> parameters;
+    size_t base = 0;
+    static const RuntimeValue none;
+
+    // the frame of a nested function has the base of the frame of the function it is nested in right below it
+    auto enclosingSlot = [&](const Operand& operand) -> RuntimeValue& {
+        const EnclosingSlot& enclosing = enclosingSlots[operand.index];
+        size_t frame = base;
+        for (int hop = 0; hop < enclosing.hops; hop++) {
+            frame = (unsigned)stack[frame - 1].integer;
+        }
+        return stack[frame + enclosing.slot];
+    };
+    auto value = [&](const Operand& operand) -> const RuntimeValue& {
+        switch (operand.kind) {
+            case OPERAND_LITERAL:
+                return literals[operand.index];
+            case OPERAND_GLOBAL:
+                return globals[operand.index];
+            case OPERAND_LOCAL:
+                return stack[base + operand.index];
+            case OPERAND_ENCLOSING:
+                return enclosingSlot(operand);
+            default:
+                return none;
+        }
+    };
+    auto store = [&](const Instruction& instruction, const Operand& operand, const RuntimeValue& stored) {
+        if (operand.kind == OPERAND_GLOBAL) {
+            globals[operand.index] = convertValue(stored, globalTypes[operand.index]);
+        } else if (operand.kind == OPERAND_LOCAL) {
+            stack[base + operand.index] = convertValue(stored, functions[instruction.function].slotTypes[operand.index]);
+        } else if (operand.kind == OPERAND_ENCLOSING) {
+            const EnclosingSlot& enclosing = enclosingSlots[operand.index];
+            enclosingSlot(operand) = convertValue(stored, functions[enclosing.function].slotTypes[enclosing.slot]);
+        }
+    };
+    auto slot = [&](const Operand& operand) -> RuntimeValue& {
+        return operand.kind == OPERAND_GLOBAL ? globals[operand.index] : stack[base + operand.index];
+    };
+    auto textOf = [&](const RuntimeValue& value) { return value.type == STRING_T ? strings[value.string].c_str() : ""; };
+
+    int stackNode = 0;
+    int profileRow = -1;
+    auto lastSwitch = chrono::steady_clock::now();
+    auto start = lastSwitch;
+    if (profiling) {
+        stackNodes.assign(1, ProfileStackNode());
+        stackNodeOf.clear();
+    }
+    // time is charged when the running row or chain of calls changes, not on every instruction
+    auto chargeTime = [&]() {
+        auto now = chrono::steady_clock::now();
+        long long elapsed = chrono::duration_cast<chrono::nanoseconds>(now - lastSwitch).count();
+        if (profileRow >= 0) {
+            profileRows[profileRow].nanoseconds += elapsed;
+        }
+        stackNodes[stackNode].nanoseconds += elapsed;
+        lastSwitch = now;
+    };
+    size_t position = 0;
+    // returns from the frame of the running call of function, made by a CALL or by tail calls replacing it
+    auto leaveCall = [&](int function, const RuntimeValue& returned) {
+        size_t frameBase = base;
+        CallFrame frame = frames.back();
+        frames.pop_back();
+        if (frame.memoEntry >= 0) {
+            MemoTable& table = memoTables[frame.function];
+            size_t key = memoKeys.size() - table.argumentCount;
+            copy(memoKeys.begin() + key, memoKeys.end(), table.arguments.begin() + frame.memoEntry * table.argumentCount);
+            table.results[frame.memoEntry] = returned;
+            table.filled[frame.memoEntry] = 1;
+            memoKeys.resize(key);
+        }
+        stack.resize(frameBase - (functions[function].parent != 0));
+        base = frame.base;
+        position = frame.returnPosition;
+        if (profiling) {
+            chargeTime();
+            stackNode = frame.stackNode;
+        }
+        const Instruction& call = instructions[position - 1];
+        store(call, call.result, returned);
+    };
+
+    long long executed = 0;
+    while (position < instructions.size()) {
+        const Instruction& instruction = instructions[position++];
+        if (instruction.opcode == OPCODE_NOP) {
+            continue;
+        }
+        if (instruction.opcode == OPCODE_LABEL) {
+            if (recordingJumps) {
+                executions[position - 1]++;
+            }
+            continue;
+        }
+        if (++executed > instructionBudget) {
+            return fail(instruction, "instruction budget of " + to_string(instructionBudget) + " exceeded");
+        }
+        if (profiling) {
+            if (instruction.profileRow != profileRow) {
+                chargeTime();
+                profileRow = instruction.profileRow;
+            }
+            profileRows[profileRow].instructions++;
+            stackNodes[stackNode].instructions++;
+        }
+
+        switch (instruction.opcode) {
+            case OPCODE_ASSIGN:
+                store(instruction, instruction.result, value(instruction.arg1));
+                break;
+            case OPCODE_ADD:
+            case OPCODE_SUB:
+            case OPCODE_MUL:
+            case OPCODE_DIV:
+            case OPCODE_POW: {
+                const RuntimeValue& left = value(instruction.arg1);
+                const RuntimeValue& right = value(instruction.arg2);
+                RuntimeValue computed;
+                if (left.type == FLOAT_T || right.type == FLOAT_T) {
+                    float a = toFloat(left), b = toFloat(right);
+                    float floating = instruction.opcode == OPCODE_ADD   ? a + b
+                                     : instruction.opcode == OPCODE_SUB ? a - b
+                                     : instruction.opcode == OPCODE_MUL ? a * b
+                                     : instruction.opcode == OPCODE_DIV ? a / b
+                                                                        : powf(a, b);
+                    // the result has the type of the left operand
+                    computed = convertValue(floatValue(floating), left.type);
+                } else {
+                    unsigned a = left.integer, b = right.integer;
+                    int integer;
+                    if (instruction.opcode == OPCODE_DIV) {
+                        if (right.integer == 0) {
+                            return fail(instruction, "division by zero");
+                        }
+                        integer = right.integer == -1 ? (int)(0u - a) : left.integer / right.integer;
+                    } else {
+                        integer = instruction.opcode == OPCODE_ADD   ? (int)(a + b)
+                                  : instruction.opcode == OPCODE_SUB ? (int)(a - b)
+                                  : instruction.opcode == OPCODE_MUL ? (int)(a * b)
+                                                                     : wrappingPower(left.integer, right.integer);
+                    }
+                    computed = integerValue(left.type, integer);
+                }
+                store(instruction, instruction.result, computed);
+                break;
+            }
+            case OPCODE_NEG: {
+                const RuntimeValue& operand = value(instruction.arg2);
+                store(instruction, instruction.result,
+                      operand.type == FLOAT_T ? floatValue(-operand.floating) : integerValue(operand.type, (int)(0u - (unsigned)operand.integer)));
+                break;
+            }
+            case OPCODE_LT:
+            case OPCODE_GT:
+            case OPCODE_LTE:
+            case OPCODE_GTE:
+            case OPCODE_EQ:
+            case OPCODE_NEQ: {
+                const RuntimeValue& left = value(instruction.arg1);
+                const RuntimeValue& right = value(instruction.arg2);
+                bool holds;
+                if (left.type == STRING_T || right.type == STRING_T) {
+                    holds = compare(instruction.opcode, strcmp(textOf(left), textOf(right)), 0);
+                } else if (left.type == FLOAT_T || right.type == FLOAT_T) {
+                    holds = compare(instruction.opcode, toFloat(left), toFloat(right));
+                } else {
+                    holds = compare(instruction.opcode, left.integer, right.integer);
+                }
+                store(instruction, instruction.result, integerValue(BOOLEAN_T, holds));
+                break;
+            }
+            case OPCODE_AND:
+                store(instruction, instruction.result, integerValue(BOOLEAN_T, isTrue(value(instruction.arg1)) && isTrue(value(instruction.arg2))));
+                break;
+            case OPCODE_OR:
+                store(instruction, instruction.result, integerValue(BOOLEAN_T, isTrue(value(instruction.arg1)) || isTrue(value(instruction.arg2))));
+                break;
+            case OPCODE_JMP:
+                if (recordingJumps) {
+                    executions[position - 1]++;
+                    taken[position - 1]++;
+                }
+                position = instruction.target;
+                break;
+            case OPCODE_JF:
+            case OPCODE_JT: {
+                bool jumps = isTrue(value(instruction.arg1)) == (instruction.opcode == OPCODE_JT);
+                if (recordingJumps) {
+                    executions[position - 1]++;
+                    taken[position - 1] += jumps;
+                }
+                if (jumps) {
+                    position = instruction.target;
+                }
+                break;
+            }
+            case OPCODE_SWITCH: {
+                const vector<int>& table = jumpTables[instruction.extra];
+                long long index = (long long)value(instruction.arg1).integer - value(instruction.arg2).integer;
+                position = index >= 0 && index < (long long)table.size() ? table[index] : instruction.target;
+                break;
+            }
+            case OPCODE_PARAM:
+                parameters.push_back(value(instruction.arg1));
+                break;
+            case OPCODE_CALL:
+            case OPCODE_TAILCALL: {
+                const RuntimeFunction& callee = functions[instruction.target];
+                MemoTable& table = memoTables[instruction.target];
+                bool tailCall = instruction.opcode == OPCODE_TAILCALL;
+                if (!tailCall && frames.size() >= maxCallDepth) {
+                    return fail(instruction, "call stack overflow in " + callee.name);
+                }
+                if ((int)parameters.size() < instruction.extra) {
+                    return fail(instruction, "CALL of " + callee.name + " without its PARAMs");
+                }
+                // the frame of the innermost active call of the function the callee is nested in, found from the
+                // frame of the caller before a tail call drops it
+                size_t link = base;
+                for (int function = instruction.function; callee.parent != 0 && function != callee.parent; function = functions[function].parent) {
+                    if (functions[function].parent == 0) {
+                        return fail(instruction, "call of " + callee.name + " outside of the function it is nested in");
+                    }
+                    link = (unsigned)stack[link - 1].integer;
+                }
+                if (tailCall) {
+                    stack.resize(base - (functions[instruction.function].parent != 0));
+                }
+                if (callee.parent != 0) {
+                    stack.push_back(integerValue(INTEGER_T, (int)link));
+                }
+                size_t calleeBase = stack.size();
+                for (Type type : callee.knownTypes) {
+                    stack.push_back(zeroValue(type));
+                }
+                size_t first = parameters.size() - instruction.extra;
+                for (int argument = 0; argument < instruction.extra && argument < (int)callee.slotTypes.size(); argument++) {
+                    stack[calleeBase + argument] = convertValue(parameters[first + argument], callee.slotTypes[argument]);
+                }
+                parameters.resize(first);
+                int memoEntry = -1;
+                if (!table.filled.empty()) {
+                    // arguments were converted to the types of the callee, so their payloads are the whole key
+                    const RuntimeValue* arguments = &stack[calleeBase];
+                    size_t entry = hashArguments(arguments, table.argumentCount) & (memoEntries - 1);
+                    const RuntimeValue* cached = table.arguments.data() + entry * table.argumentCount;
+                    bool hit = table.filled[entry];
+                    for (int argument = 0; hit && argument < table.argumentCount; argument++) {
+                        hit = cached[argument].integer == arguments[argument].integer;
+                    }
+                    table.calls++;
+                    if (hit && tailCall) {
+                        // the cached result is the result of the function making the tail call
+                        table.hits++;
+                        leaveCall(instruction.function, table.results[entry]);
+                        break;
+                    }
+                    if (hit) {
+                        table.hits++;
+                        stack.resize(calleeBase - (callee.parent != 0));
+                        store(instruction, instruction.result, table.results[entry]);
+                        break;
+                    }
+                    // a tail call has no frame of its own to record its result in when it returns
+                    if (!tailCall) {
+                        memoEntry = entry;
+                        memoKeys.insert(memoKeys.end(), arguments, arguments + table.argumentCount);
+                    }
+                }
+                if (tailCall) {
+                    base = calleeBase;
+                    position = callee.entry;
+                    if (profiling) {
+                        calls[instruction.target]++;
+                        chargeTime();
+                        stackNode = getStackNode(frames.back().stackNode, instruction.target);
+                    }
+                    break;
+                }
+                frames.push_back({base, position, stackNode, instruction.target, memoEntry});
+                base = calleeBase;
+                position = callee.entry;
+                if (profiling) {
+                    calls[instruction.target]++;
+                    chargeTime();
+                    stackNode = getStackNode(stackNode, instruction.target);
+                }
+                break;
+            }
+            case OPCODE_RET: {
+                if (frames.empty()) {
+                    return fail(instruction, "RET outside of a function");
+                }
+                const RuntimeFunction& function = functions[instruction.function];
+                leaveCall(instruction.function, instruction.arg1.kind == OPERAND_NONE ? zeroValue(function.returnType)
+                                                                                     : convertValue(value(instruction.arg1), function.returnType));
+                break;
+            }
+            case OPCODE_COPY:
+                slot(instruction.result) = value(instruction.arg1);
+                break;
+            case OPCODE_ADD_INT:
+                slot(instruction.result).integer = (int)((unsigned)value(instruction.arg1).integer + (unsigned)value(instruction.arg2).integer);
+                break;
+            case OPCODE_SUB_INT:
+                slot(instruction.result).integer = (int)((unsigned)value(instruction.arg1).integer - (unsigned)value(instruction.arg2).integer);
+                break;
+            case OPCODE_MUL_INT:
+                slot(instruction.result).integer = (int)((unsigned)value(instruction.arg1).integer * (unsigned)value(instruction.arg2).integer);
+                break;
+            case OPCODE_ADD_FLOAT:
+                slot(instruction.result).floating = value(instruction.arg1).floating + value(instruction.arg2).floating;
+                break;
+            case OPCODE_SUB_FLOAT:
+                slot(instruction.result).floating = value(instruction.arg1).floating - value(instruction.arg2).floating;
+                break;
+            case OPCODE_MUL_FLOAT:
+                slot(instruction.result).floating = value(instruction.arg1).floating * value(instruction.arg2).floating;
+                break;
+            case OPCODE_DIV_FLOAT:
+                slot(instruction.result).floating = value(instruction.arg1).floating / value(instruction.arg2).floating;
+                break;
+            case OPCODE_LT_INT:
+                slot(instruction.result).integer = value(instruction.arg1).integer < value(instruction.arg2).integer;
+                break;
+            case OPCODE_GT_INT:
+                slot(instruction.result).integer = value(instruction.arg1).integer > value(instruction.arg2).integer;
+                break;
+            case OPCODE_LTE_INT:
+                slot(instruction.result).integer = value(instruction.arg1).integer <= value(instruction.arg2).integer;
+                break;
+            case OPCODE_GTE_INT:
+                slot(instruction.result).integer = value(instruction.arg1).integer >= value(instruction.arg2).integer;
+                break;
+            case OPCODE_EQ_INT:
+                slot(instruction.result).integer = value(instruction.arg1).integer == value(instruction.arg2).integer;
+                break;
+            case OPCODE_NEQ_INT:
+                slot(instruction.result).integer = value(instruction.arg1).integer != value(instruction.arg2).integer;
+                break;
+            case OPCODE_JF_BOOL:
+            case OPCODE_JT_BOOL: {
+                bool jumps = (value(instruction.arg1).integer != 0) == (instruction.opcode == OPCODE_JT_BOOL);
+                if (recordingJumps) {
+                    executions[position - 1]++;
+                    taken[position - 1] += jumps;
+                }
+                if (jumps) {
+                    position = instruction.target;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    if (profiling) {
+        chargeTime();
+        totalNanoseconds = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
+
+string Interpreter::formatValue(const RuntimeValue& value, Type type) const {
+    char buffer[64];
+    switch (type) {
+        case FLOAT_T:
+            snprintf(buffer, sizeof(buffer), "%g", toFloat(value));
+            return buffer;
+        case CHAR_T:
+            return string(1, (char)value.integer);
+        case STRING_T:
+            return value.type == STRING_T ? strings[value.string] : "";
+        default:
+            return to_string(value.integer);
+    }
+}
+
+bool Interpreter::getGlobalValue(const string& name, RuntimeValue& value) const {
+    auto it = globalOf.find(name);
+    if (it == globalOf.end() || it->second >= (int)globals.size()) {
+        return false;
+    }
+    value = globals[it->second];
+    return true;
+}
+
+void Interpreter::printGlobals(ostream& out) const {
+    for (Variable* variable : getGlobalVariables()) {
+        auto it = globalOf.find(variable->getName());
+        RuntimeValue stored = it != globalOf.end() && it->second < (int)globals.size() ? globals[it->second] : zeroValue(variable->getType());
+        out << variable->getName() << " = " << formatValue(stored, variable->getType()) << "\n";
+    }
+}
+
+static string formatMilliseconds(long long nanoseconds) {
+    ostringstream text;
+    text << fixed << setprecision(3) << nanoseconds / 1e6;
+    return text.str();
+}
+
+static string formatPercent(long long part, long long total) {
+    ostringstream text;
+    text << fixed << setprecision(1) << (total > 0 ? 100.0 * part / total : 0.0);
+    return text.str();
+}
+
+void Interpreter::writeProfileReport(ostream& out, const vector<string>& sourceLines) const {
+    long long totalInstructions = 0;
+    for (const ProfileRow& row : profileRows) {
+        totalInstructions += row.instructions;
+    }
+    out << "Executed " << totalInstructions << " instructions in " << formatMilliseconds(totalNanoseconds) << " ms\n\n";
+
+    vector<const ProfileRow*> rows;
+    for (const ProfileRow& row : profileRows) {
+        if (row.instructions > 0) {
+            rows.push_back(&row);
+        }
+    }
+    stable_sort(rows.begin(), rows.end(), [](const ProfileRow* a, const ProfileRow* b) {
+        return a->nanoseconds != b->nanoseconds ? a->nanoseconds > b->nanoseconds : a->instructions > b->instructions;
+    });
+    VariadicTable<string, string, string, string, string, string> lines({"Line", "Function", "Instructions", "%", "Time (ms)", "Source"});
+    for (const ProfileRow* row : rows) {
+        string source;
+        if (row->line > 0 && row->line <= (int)sourceLines.size()) {
+            source = sourceLines[row->line - 1];
+            source.erase(0, source.find_first_not_of(" \t"));
+            source.erase(source.find_last_not_of(" \t\r") + 1);
+            if (source.size() > 60) {
+                source = source.substr(0, 57) + "...";
+            }
+        }
+        lines.addRow(row->line > 0 ? to_string(row->line) : "-", functions[row->function].name, to_string(row->instructions),
+                     formatPercent(row->instructions, totalInstructions), formatMilliseconds(row->nanoseconds), source);
+    }
+    lines.print(out);
+
+    // self counts: what ran in the function itself, not in the functions it called
+    vector<long long> instructionsOf(functions.size(), 0), nanosecondsOf(functions.size(), 0);
+    for (const ProfileStackNode& node : stackNodes) {
+        instructionsOf[node.function] += node.instructions;
+        nanosecondsOf[node.function] += node.nanoseconds;
+    }
+    vector<size_t> order;
+    for (size_t f = 0; f < functions.size(); f++) {
+        if (instructionsOf[f] > 0) {
+            order.push_back(f);
+        }
+    }
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return nanosecondsOf[a] > nanosecondsOf[b]; });
+    out << "\n";
+    VariadicTable<string, string, string, string, string> table({"Function", "Calls", "Self Instructions", "%", "Self Time (ms)"});
+    for (size_t f : order) {
+        table.addRow(functions[f].name, f == 0 ? "-" : to_string(calls[f]), to_string(instructionsOf[f]),
+                     formatPercent(instructionsOf[f], totalInstructions), formatMilliseconds(nanosecondsOf[f]));
+    }
+    table.print(out);
+}
+
+void Interpreter::writeCollapsedStacks(ostream& out) const {
+    for (const ProfileStackNode& node : stackNodes) {
+        if (node.instructions == 0) {
+            continue;
+        }
+        vector<const string*> names;
+        for (const ProfileStackNode* current = &node;; current = &stackNodes[current->parent]) {
+            names.push_back(&functions[current->function].name);
+            if (current->parent < 0) {
+                break;
+            }
+        }
+        for (size_t i = names.size(); i-- > 0;) {
+            out << *names[i] << (i > 0 ? ";" : "");
+        }
+        out << " " << node.instructions << "\n";
+    }
+}
+
+void Interpreter::writeMemoizationReport(ostream& out) const {
+    out << "Memoized pure functions, " << memoEntries << " entries each\n";
+    VariadicTable<string, string, string, string> table({"Function", "Calls", "Hits", "Hit Rate (%)"});
+    for (size_t f = 0; f < memoTables.size(); f++) {
+        const MemoTable& memo = memoTables[f];
+        if (memo.calls > 0) {
+            table.addRow(functions[f].name, to_string(memo.calls), to_string(memo.hits), formatPercent(memo.hits, memo.calls));
+        }
+    }
+    table.print(out);
+}
+
+void Interpreter::recordBranchProfile(BranchProfile& profile) const {
+    if (!recordingJumps) {
+        return;
+    }
+    unordered_map<string, bool> hasLabel;
+    for (size_t i = 0; i < instructions.size(); i++) {
+        const Instruction& instruction = instructions[i];
+        bool isJump = instruction.opcode == OPCODE_JMP || instruction.opcode == OPCODE_JF || instruction.opcode == OPCODE_JT ||
+                      instruction.opcode == OPCODE_JF_BOOL || instruction.opcode == OPCODE_JT_BOOL;
+        if (!isJump && instruction.opcode != OPCODE_LABEL) {
+            continue;
+        }
+        string lineKey = BranchProfile::getLineKey(functions[instruction.function].symbol, instruction.line);
+        if (isJump) {
+            JumpCounts counts;
+            counts.taken = taken[i];
+            counts.fallThrough = executions[i] - taken[i];
+            profile.addJump(lineKey, counts);
+        } else if (!hasLabel[lineKey]) {
+            hasLabel[lineKey] = true;
+            profile.setLabelEntries(lineKey, executions[i]);
+        }
+    }
+}
+
+extern "C" {
+
+int runProgram(const char* inputFileName) {
+    Interpreter interpreter(getMainQuadrupleManager().getQuadruples());
+    if (compilerOptions.profileLines) {
+        interpreter.enableProfiling();
+    }
+    if (compilerOptions.profileGeneratePath != nullptr) {
+        interpreter.enableJumpRecording();
+    }
+    if (compilerOptions.maxInstructions > 0) {
+        interpreter.setInstructionBudget(compilerOptions.maxInstructions);
+    }
+    if (compilerOptions.memoize > 0) {
+        interpreter.enableMemoization(compilerOptions.memoize);
+    }
+    bool succeeded = interpreter.run();
+    ostringstream globals;
+    if (succeeded) {
+        interpreter.printGlobals(globals);
+        printf("%s", globals.str().c_str());
+        if (compilerOptions.memoize > 0) {
+            ostringstream report;
+            interpreter.writeMemoizationReport(report);
+            printf("%s", report.str().c_str());
+        }
+    } else {
+        fprintf(stderr, "%s\n", interpreter.getError().c_str());
+    }
+
+    if (compilerOptions.profileLines) {
+        vector<string> sourceLines;
+        ifstream source(inputFileName);
+        for (string line; getline(source, line);) {
+            sourceLines.push_back(line);
+        }
+        ofstream report(getOutputFileName(inputFileName, "_profile.txt"));
+        interpreter.writeProfileReport(report, sourceLines);
+        ofstream stacks(getOutputFileName(inputFileName, "_profile.folded"));
+        interpreter.writeCollapsedStacks(stacks);
+    }
+    if (compilerOptions.profileGeneratePath != nullptr && succeeded) {
+        BranchProfile profile;
+        interpreter.recordBranchProfile(profile);
+        ofstream out(compilerOptions.profileGeneratePath);
+        if (!out) {
+            fprintf(stderr, "Error: Unable to open profile file %s\n", compilerOptions.profileGeneratePath);
+        }
+        profile.write(out);
+    }
+    return succeeded ? 0 : 1;
+}
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include "BranchProfile.hpp"
+#include "Quadruple.hpp"
+#include "SymbolTable.hpp"
+
+// Value of a variable or temporary at run time, a 32 bit payload tagged with its type in 8 bytes. Integers, chars
+// and booleans use integer, strings are the index of their text in the interned strings of the interpreter.
+struct RuntimeValue {
+    union {
+        int integer;
+        float floating;
+        int string;
+    };
+    Type type;
+
+    RuntimeValue() : integer(0), type(INTEGER_T) {}
+};
+
+enum Opcode {
+    OPCODE_NOP,  // ENTER and the JTAB entries read by their SWITCH
+    OPCODE_LABEL,
+    OPCODE_ASSIGN,
+    OPCODE_ADD,
+    OPCODE_SUB,
+    OPCODE_MUL,
+    OPCODE_DIV,
+    OPCODE_POW,
+    OPCODE_NEG,
+    OPCODE_LT,
+    OPCODE_GT,
+    OPCODE_LTE,
+    OPCODE_GTE,
+    OPCODE_EQ,
+    OPCODE_NEQ,
+    OPCODE_AND,
+    OPCODE_OR,
+    OPCODE_JMP,
+    OPCODE_JF,
+    OPCODE_JT,
+    OPCODE_SWITCH,
+    OPCODE_PARAM,
+    OPCODE_CALL,
+    OPCODE_RET,
+    // variants for operands whose type is known before running, which neither check nor convert it
+    OPCODE_COPY,  // ASSIGN to a slot of the same type
+    OPCODE_ADD_INT,
+    OPCODE_SUB_INT,
+    OPCODE_MUL_INT,
+    OPCODE_ADD_FLOAT,
+    OPCODE_SUB_FLOAT,
+    OPCODE_MUL_FLOAT,
+    OPCODE_DIV_FLOAT,
+    OPCODE_LT_INT,  // integers, chars and booleans, into a boolean
+    OPCODE_GT_INT,
+    OPCODE_LTE_INT,
+    OPCODE_GTE_INT,
+    OPCODE_EQ_INT,
+    OPCODE_NEQ_INT,
+    OPCODE_JF_BOOL,
+    OPCODE_JT_BOOL,
+    OPCODE_TAILCALL  // CALL whose result the next instruction returns, which runs the callee in the frame of the caller
+};
+
+enum OperandKind {
+    OPERAND_NONE,
+    OPERAND_LITERAL,
+    OPERAND_GLOBAL,
+    OPERAND_LOCAL,     // slot of the frame of the running function
+    OPERAND_ENCLOSING  // slot of the frame of a function the running one is nested in, index into enclosingSlots
+};
+
+struct Operand {
+    OperandKind kind = OPERAND_NONE;
+    int index = 0;
+};
+
+// A name a nested function uses from the frame of a function it is nested in, reached by following the access
+// link of the running frame hops times
+struct EnclosingSlot {
+    int hops = 0;
+    int function = 0;  // function whose frame holds the slot
+    int slot = 0;
+};
+
+// A quadruple with its operands resolved to slots and its labels to instruction indexes
+struct Instruction {
+    Opcode opcode = OPCODE_NOP;
+    Operand arg1;
+    Operand arg2;
+    Operand result;
+    int target = -1;    // jump target, default case of a SWITCH, called function of a CALL
+    int extra = 0;      // argument count of a CALL, jump table of a SWITCH
+    int function = 0;   // function the instruction belongs to, 0 for the global code
+    int profileRow = 0; // (function, source line) the instruction is counted under
+    int line = 0;
+};
+
+struct RuntimeFunction {
+    string name;
+    Function* symbol = nullptr;  // null for the global code
+    int entry = 0;
+    Type returnType = VOID_T;
+    vector<Type> slotTypes;   // VOID_T for temporaries, which keep the type of the value stored in them
+    vector<Type> knownTypes;  // type of every value a slot holds, VOID_T when it is only known while running
+    int argumentCount = 0;
+    int parent = 0;  // function the body is nested in, 0 for the functions of the global code
+};
+
+struct ProfileRow {
+    int function = 0;
+    int line = 0;
+    long long instructions = 0;
+    long long nanoseconds = 0;
+};
+
+// Results of a pure function by the values of its arguments, direct mapped: a new result replaces the one
+// whose arguments hash to the same entry
+struct MemoTable {
+    int argumentCount = 0;
+    vector<RuntimeValue> arguments;  // argumentCount per entry
+    vector<RuntimeValue> results;
+    vector<char> filled;
+    long long calls = 0;
+    long long hits = 0;
+};
+
+// Node of the calling context tree built while profiling, one per distinct chain of active calls
+struct ProfileStackNode {
+    int parent = -1;
+    int function = 0;
+    long long instructions = 0;
+    long long nanoseconds = 0;
+};
+
+// Executes the final quadruples. Every operand is resolved once, before running: literals are decoded, names
+// in the frame of their function become frame slots, names in the frame of a function it is nested in are
+// reached through the access link the frame of a nested function keeps right below its slots, and every
+// other name is a global, as in the quadruples. Stored values are converted to the type of the variable they
+// go into, arithmetic takes the type of its left operand, integers wrap around at 32 bits and floats are
+// single precision, which is what the C program of --emit-c does too. The types of the temporaries are
+// inferred from the instructions that store into them, and instructions whose operands all have a known type
+// run as typed variants. With profiling enabled every executed instruction and the time spent on it is
+// charged to its (function, source line) row and to its chain of calls.
+class Interpreter {
+   private:
+    vector<Instruction> instructions;
+    vector<RuntimeFunction> functions;  // the global code is function 0
+    vector<RuntimeValue> literals;
+    vector<EnclosingSlot> enclosingSlots;
+    vector<string> globalNames;
+    unordered_map<string, int> globalOf;
+    vector<Type> globalTypes;
+    vector<Type> knownGlobalTypes;
+    vector<RuntimeValue> globals;
+    vector<string> strings;  // interned text of the string values, "" first
+    unordered_map<string, int> stringOf;
+    vector<vector<int>> jumpTables;
+    unordered_map<string, int> functionOfLabel;
+    vector<bool> pure;  // per function, the result only depends on the arguments
+    string error;
+
+    bool profiling = false;
+    vector<ProfileRow> profileRows;
+    vector<ProfileStackNode> stackNodes;
+    unordered_map<long long, int> stackNodeOf;  // parent node and called function to node
+    vector<long long> calls;                    // per function
+    long long totalNanoseconds = 0;
+
+    long long instructionBudget = LLONG_MAX;
+
+    size_t memoEntries = 0;  // per pure function, 0 when calls are not memoized
+    vector<MemoTable> memoTables;
+    vector<RuntimeValue> memoKeys;  // arguments of the memoized calls still running, stored in the table on RET
+
+    bool recordingJumps = false;
+    vector<long long> executions;  // per instruction, for labels and jumps
+    vector<long long> taken;       // per jump
+
+    void load(const vector<Quadruple>& quadruples);
+    int internString(const string& text);
+    Type knownType(const Operand& operand, int function) const;
+    void inferTemporaryTypes();
+    void specializeInstructions();
+    void findPureFunctions();
+    string formatValue(const RuntimeValue& value, Type type) const;
+    int getStackNode(int parent, int function);
+    bool fail(const Instruction& instruction, const string& message);
+
+   public:
+    explicit Interpreter(const vector<Quadruple>& quadruples);
+
+    void enableProfiling();
+    // Stop with a runtime error once that many instructions were executed
+    void setInstructionBudget(long long budget);
+    // Cache the results of the calls of pure functions, entries is rounded up to a power of two
+    void enableMemoization(size_t entries);
+    // Whether the function with that entry label only reads and writes its own frame and only calls pure functions
+    bool isPureFunction(const string& label) const;
+    // Count how often every label is reached and every jump is taken, for -fprofile-generate
+    void enableJumpRecording();
+    // Runs the program once from its first quadruple, false with the reason in getError() on a runtime error
+    bool run();
+    const string& getError() const;
+
+    // name = value for every variable declared outside of the functions, like the C program prints them
+    void printGlobals(ostream& out) const;
+    // Value of a global, or of a temporary of the global code, after run(); false for an unknown name
+    bool getGlobalValue(const string& name, RuntimeValue& value) const;
+    // Calls and hits of every memoized function that was called
+    void writeMemoizationReport(ostream& out) const;
+    // Rows sorted by time, with the text of their source line, then the functions
+    void writeProfileReport(ostream& out, const vector<string>& sourceLines) const;
+    // One line per chain of calls with the instructions executed in it, as read by flamegraph.pl
+    void writeCollapsedStacks(ostream& out) const;
+    // Adds the counts of every jump, and of the first label of every line, to the profile
+    void recordBranchProfile(BranchProfile& profile) const;
+};
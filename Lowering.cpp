@@ -0,0 +1,546 @@
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "Ast.hpp"
+#include "BranchProfile.hpp"
+#include "Module.hpp"
+#include "QuadrupleManager.hpp"
+
+// Switches with at least this many cases whose values fill at least half of their range use a jump table
+static const size_t minJumpTableCases = 4;
+static const double minJumpTableDensity = 0.5;
+// Below this many cases the decision tree falls back to comparing against every value
+static const size_t maxLinearSearchCases = 3;
+
+struct SwitchArm {
+    long long key;        // numeric value used to order the cases
+    string value;         // value as written in the quadruples
+    string label;         // first quadruple of the case body
+    const AstNode* body;  // case body
+    int line;             // line of the case value, which its label is tagged with
+    long long hits;       // times the case ran in the -fprofile-use profile
+};
+
+// temporaries that already have a slot in the frame of some function
+static unordered_set<string> frameTemporaries;
+
+// Walks the tree of a statement once and appends its quadruples in their final order, so nothing is copied
+// or inserted in front: the code of a loop condition is emitted where the loop tests it, the bodies of a
+// switch after its tests. Temporaries and labels are numbered in the order they are emitted.
+class Lowering {
+   private:
+    QuadrupleManager& quadruples;
+    // function whose body is being lowered, with the label after its ENTER that a self tail call jumps back to
+    // (empty when it has none) and the locals such a jump resets
+    Function* currentFunction = nullptr;
+    string tailCallLabel;
+    vector<Variable*> bareLocals;
+
+    void emit(const string& op, const string& arg1, const string& arg2, const string& result, int line) {
+        quadruples.addQuadruple(op, arg1, arg2, result, line);
+    }
+
+    void emitLabel(const string& label, int line) {
+        emit(label, "", "", "", line);
+    }
+
+    static bool containsCall(const AstNode* node) {
+        switch (node->kind) {
+            case AST_CALL:
+                return true;
+            case AST_BINARY:
+            case AST_LOGICAL: {
+                const AstBinary* binary = static_cast<const AstBinary*>(node);
+                return containsCall(binary->left) || containsCall(binary->right);
+            }
+            case AST_NEGATE:
+                return containsCall(static_cast<const AstNegate*>(node)->operand);
+            default:
+                return false;
+        }
+    }
+
+    string lowerLogicalValue(const AstBinary* logical) {
+        string left = lowerValue(logical->left);
+        if (!containsCall(logical->right)) {
+            string right = lowerValue(logical->right);
+            string result = quadruples.newTemp();
+            emit(logical->op, left, right, result, logical->line);
+            return result;
+        }
+        // only evaluate the right operand when the left one does not decide the result
+        string result = quadruples.newTemp();
+        string endLabel = quadruples.newLabel();
+        emit("ASSIGN", left, "", result, logical->line);
+        emit(strcmp(logical->op, "AND") == 0 ? "JF" : "JT", result, "", endLabel, logical->line);
+        string right = lowerValue(logical->right);
+        emit("ASSIGN", right, "", result, logical->line);
+        emitLabel(endLabel, logical->line);
+        return result;
+    }
+
+    // op is CALL, or TAILCALL for a call whose result the RET after it returns
+    string lowerCall(const AstCall* call, const string& op) {
+        vector<string> arguments;
+        for (int i = 0; i < call->argumentCount; i++) {
+            arguments.push_back(lowerValue(call->arguments[i]));
+        }
+        for (const string& argument : arguments) {
+            emit("PARAM", argument, "", "", call->line);
+        }
+        // a void call still gets a name, so that using its value reads a temporary that was never assigned
+        string result = quadruples.newTemp();
+        emit(op, call->function->getLabel(), to_string(call->argumentCount), call->function->getType() != VOID_T ? result : "", call->line);
+        return result;
+    }
+
+    // The variable, literal or temporary holding the value of an expression, after the code computing it
+    string lowerValue(const AstNode* node) {
+        switch (node->kind) {
+            case AST_NAME:
+                return static_cast<const AstName*>(node)->name;
+            case AST_BINARY: {
+                const AstBinary* binary = static_cast<const AstBinary*>(node);
+                string left = lowerValue(binary->left);
+                string right = lowerValue(binary->right);
+                string result = quadruples.newTemp();
+                emit(binary->op, left, right, result, binary->line);
+                return result;
+            }
+            case AST_NEGATE: {
+                string operand = lowerValue(static_cast<const AstNegate*>(node)->operand);
+                string result = quadruples.newTemp();
+                emit("NEG", "", operand, result, node->line);
+                return result;
+            }
+            case AST_LOGICAL:
+                return lowerLogicalValue(static_cast<const AstBinary*>(node));
+            case AST_CALL:
+                return lowerCall(static_cast<const AstCall*>(node), "CALL");
+            default:
+                return "";
+        }
+    }
+
+    // Falls through when the condition holds and jumps to falseLabel otherwise. && and || become jumps, so
+    // the right operand is skipped once the result is known; every other condition is computed as a value.
+    void lowerJumpIfFalse(const AstNode* condition, const string& falseLabel) {
+        if (condition->kind != AST_LOGICAL) {
+            emit("JF", lowerValue(condition), "", falseLabel, condition->line);
+            return;
+        }
+        const AstBinary* logical = static_cast<const AstBinary*>(condition);
+        if (strcmp(logical->op, "AND") == 0) {
+            lowerJumpIfFalse(logical->left, falseLabel);
+            lowerJumpIfFalse(logical->right, falseLabel);
+            return;
+        }
+        string rightLabel = quadruples.newLabel();
+        lowerJumpIfTrue(logical->left, rightLabel);
+        lowerJumpIfFalse(logical->right, falseLabel);
+        emitLabel(rightLabel, logical->line);
+    }
+
+    // Falls through when the condition does not hold and jumps to trueLabel otherwise
+    void lowerJumpIfTrue(const AstNode* condition, const string& trueLabel) {
+        if (condition->kind != AST_LOGICAL) {
+            emit("JT", lowerValue(condition), "", trueLabel, condition->line);
+            return;
+        }
+        const AstBinary* logical = static_cast<const AstBinary*>(condition);
+        if (strcmp(logical->op, "OR") == 0) {
+            lowerJumpIfTrue(logical->left, trueLabel);
+            lowerJumpIfTrue(logical->right, trueLabel);
+            return;
+        }
+        string falseLabel = quadruples.newLabel();
+        lowerJumpIfFalse(logical->left, falseLabel);
+        lowerJumpIfTrue(logical->right, trueLabel);
+        emitLabel(falseLabel, logical->line);
+    }
+
+    void lowerIf(const AstConditional* node) {
+        string elseLabel = quadruples.newLabel();
+        lowerJumpIfFalse(node->condition, elseLabel);
+        lowerStatement(node->body);
+        if (node->elseBody == nullptr) {
+            emitLabel(elseLabel, node->line);
+            return;
+        }
+        string endLabel = quadruples.newLabel();
+        emit("JMP", "", "", endLabel, node->line);
+        emitLabel(elseLabel, node->line);
+        lowerStatement(node->elseBody);
+        emitLabel(endLabel, node->line);
+    }
+
+    // WHILE, REPEAT and FOR, whose JMP back keeps its target in arg1
+    void lowerLoop(const AstConditional* node) {
+        if (node->initialization != nullptr) {
+            lowerStatement(node->initialization);
+        }
+        string loopLabel = quadruples.newLabel();
+        string endLabel = quadruples.newLabel();
+        emitLabel(loopLabel, node->line);
+        if (node->kind == AST_REPEAT) {
+            lowerStatement(node->body);
+            lowerJumpIfFalse(node->condition, endLabel);
+        } else {
+            lowerJumpIfFalse(node->condition, endLabel);
+            lowerStatement(node->body);
+            if (node->step != nullptr) {
+                lowerStatement(node->step);
+            }
+        }
+        emit("JMP", loopLabel, "", "", node->line);
+        emitLabel(endLabel, node->line);
+    }
+
+    static long long getSwitchCaseKey(const AstSwitchArm& arm) {
+        if (arm.type == CHAR_T) {
+            return (unsigned char)Quadruple::getCharLiteralValue(arm.value);
+        }
+        return stoll(arm.value);
+    }
+
+    // Binary search over the sorted case values; each leaf tests its few remaining values with NEQ + JF
+    void lowerSwitchDecisionTree(const string& switchValue, const vector<SwitchArm>& sortedArms, size_t begin, size_t end, const string& exitLabel, int line) {
+        if (end - begin <= maxLinearSearchCases) {
+            vector<SwitchArm> leaf(sortedArms.begin() + begin, sortedArms.begin() + end);
+            stable_sort(leaf.begin(), leaf.end(), [](const SwitchArm& a, const SwitchArm& b) { return a.hits > b.hits; });
+            for (const SwitchArm& arm : leaf) {
+                string tempVar = quadruples.newTemp();
+                emit("NEQ", switchValue, arm.value, tempVar, line);
+                emit("JF", tempVar, "", arm.label, line);
+            }
+            emit("JMP", "", "", exitLabel, line);
+            return;
+        }
+
+        size_t middle = begin + (end - begin) / 2;
+        string upperHalfLabel = quadruples.newLabel();
+        string tempVar = quadruples.newTemp();
+        emit("LT", switchValue, sortedArms[middle].value, tempVar, line);
+        emit("JF", tempVar, "", upperHalfLabel, line);
+        lowerSwitchDecisionTree(switchValue, sortedArms, begin, middle, exitLabel, line);
+        emitLabel(upperHalfLabel, line);
+        lowerSwitchDecisionTree(switchValue, sortedArms, middle, end, exitLabel, line);
+    }
+
+    // An arm that took at least half of the profiled hits not yet tested is compared first, hottest first, so
+    // a skewed switch reaches its common case with one test; the decision tree handles the rest
+    void lowerProfiledSwitchTests(const string& switchValue, vector<SwitchArm> sortedArms, const string& exitLabel, int line) {
+        long long remainingHits = 0;
+        for (const SwitchArm& arm : sortedArms) {
+            remainingHits += arm.hits;
+        }
+        vector<SwitchArm> hottest = sortedArms;
+        stable_sort(hottest.begin(), hottest.end(), [](const SwitchArm& a, const SwitchArm& b) { return a.hits > b.hits; });
+        for (const SwitchArm& arm : hottest) {
+            if (sortedArms.size() <= maxLinearSearchCases || remainingHits == 0 || arm.hits * 2 < remainingHits) {
+                break;
+            }
+            string tempVar = quadruples.newTemp();
+            emit("NEQ", switchValue, arm.value, tempVar, line);
+            emit("JF", tempVar, "", arm.label, line);
+            remainingHits -= arm.hits;
+            sortedArms.erase(find_if(sortedArms.begin(), sortedArms.end(), [&arm](const SwitchArm& other) { return other.key == arm.key; }));
+        }
+        lowerSwitchDecisionTree(switchValue, sortedArms, 0, sortedArms.size(), exitLabel, line);
+    }
+
+    // SWITCH value, low, default jumps to the target of the (value - low)th JTAB quadruple that follows it,
+    // or to default when value is outside of the table
+    void lowerSwitchJumpTable(const string& switchValue, const vector<SwitchArm>& sortedArms, const string& exitLabel, int line) {
+        long long low = sortedArms.front().key;
+        long long high = sortedArms.back().key;
+        emit("SWITCH", switchValue, sortedArms.front().value, exitLabel, line);
+
+        size_t next = 0;
+        for (long long key = low; key <= high; key++) {
+            string target = exitLabel;
+            if (sortedArms[next].key == key) {
+                target = sortedArms[next].label;
+                next++;
+            }
+            emit("JTAB", to_string(key - low), "", target, line);
+        }
+    }
+
+    void lowerSwitch(const AstSwitch* node) {
+        string switchValue = lowerValue(node->value);
+
+        // a case is counted by the entries into its label, keyed by the function and line of the case
+        const BranchProfile& profile = getBranchProfile();
+        vector<SwitchArm> arms;
+        long long totalHits = 0;
+        for (int i = 0; i < node->armCount; i++) {
+            const AstSwitchArm& arm = node->arms[i];
+            long long hits = profile.getLabelEntries(BranchProfile::getLineKey(node->function, arm.line));
+            arms.push_back({getSwitchCaseKey(arm), arm.value, quadruples.newLabel(), arm.body, arm.line, hits});
+            totalHits += hits;
+        }
+        string exitLabel = quadruples.newLabel();
+
+        vector<SwitchArm> sortedArms = arms;
+        sort(sortedArms.begin(), sortedArms.end(), [](const SwitchArm& a, const SwitchArm& b) {
+            return a.key < b.key;
+        });
+
+        double range = (double)(sortedArms.back().key - sortedArms.front().key) + 1;
+        if (sortedArms.size() >= minJumpTableCases && sortedArms.size() / range >= minJumpTableDensity) {
+            lowerSwitchJumpTable(switchValue, sortedArms, exitLabel, node->line);
+        } else if (totalHits > 0) {
+            lowerProfiledSwitchTests(switchValue, sortedArms, exitLabel, node->line);
+        } else {
+            lowerSwitchDecisionTree(switchValue, sortedArms, 0, sortedArms.size(), exitLabel, node->line);
+        }
+
+        // case bodies keep their source order, the last one falls through to the exit
+        for (size_t i = 0; i < arms.size(); i++) {
+            emitLabel(arms[i].label, arms[i].line);
+            lowerStatement(arms[i].body);
+            if (i + 1 < arms.size()) {
+                emit("JMP", "", "", exitLabel, node->line);
+            }
+        }
+        emitLabel(exitLabel, node->line);
+    }
+
+    // Lays out the activation record of a function whose body is complete: its arguments take the first
+    // slots (CALL copies the PARAMs there), then the locals of every nested scope, then the temporaries
+    void computeFrameLayout(Function* function, size_t bodyStart) {
+        for (Variable* argument : *function->getArguments()) {
+            function->addFrameSlot(argument->getName());
+        }
+
+        vector<Variable*> locals;
+        if (function->getScope() != nullptr) {
+            function->getScope()->collectFrameVariables(locals);
+        }
+        for (Variable* local : locals) {
+            function->addFrameSlot(local->getName());
+        }
+
+        const vector<Quadruple>& body = quadruples.getQuadruples();
+        for (size_t i = bodyStart; i < body.size(); i++) {
+            for (const string& operand : {body[i].getArg1(), body[i].getArg2(), body[i].getResult()}) {
+                // temporaries of nested functions are part of the body too, but already belong to their frames
+                if (Quadruple::isTemporary(operand) && frameTemporaries.insert(operand).second) {
+                    function->addFrameSlot(operand);
+                }
+            }
+        }
+    }
+
+    static bool containsSelfTailCall(const AstNode* node, const Function* function) {
+        if (node == nullptr) {
+            return false;
+        }
+        switch (node->kind) {
+            case AST_RETURN: {
+                const AstNode* value = static_cast<const AstReturn*>(node)->value;
+                return value != nullptr && value->kind == AST_CALL && static_cast<const AstCall*>(value)->function == function;
+            }
+            case AST_BLOCK:
+                for (const AstNode* statement = static_cast<const AstBlock*>(node)->first; statement != nullptr; statement = statement->next) {
+                    if (containsSelfTailCall(statement, function)) {
+                        return true;
+                    }
+                }
+                return false;
+            case AST_IF:
+            case AST_WHILE:
+            case AST_REPEAT:
+            case AST_FOR: {
+                const AstConditional* conditional = static_cast<const AstConditional*>(node);
+                return containsSelfTailCall(conditional->body, function) || containsSelfTailCall(conditional->elseBody, function);
+            }
+            case AST_SWITCH: {
+                const AstSwitch* switchNode = static_cast<const AstSwitch*>(node);
+                for (int i = 0; i < switchNode->armCount; i++) {
+                    if (containsSelfTailCall(switchNode->arms[i].body, function)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            default:
+                // a nested function returns to its own caller
+                return false;
+        }
+    }
+
+    // `return f(...)` inside f: the arguments are assigned to the parameters and the body starts over in the same
+    // frame. Every argument is computed before the first parameter changes, and an argument reading a parameter
+    // that was already overwritten reads a copy taken before. Locals declared without a value are zeroed again, as
+    // a new frame would have them.
+    bool lowerSelfTailCall(const AstCall* call, int line) {
+        vector<Variable*>& parameters = *currentFunction->getArguments();
+        if (tailCallLabel.empty() || (int)parameters.size() != call->argumentCount) {
+            return false;
+        }
+        vector<string> arguments;
+        for (int i = 0; i < call->argumentCount; i++) {
+            arguments.push_back(lowerValue(call->arguments[i]));
+        }
+        for (size_t i = 0; i < arguments.size(); i++) {
+            for (size_t k = 0; k < i; k++) {
+                if (arguments[i] == parameters[k]->getName() && arguments[k] != parameters[k]->getName()) {
+                    string copy = quadruples.newTemp();
+                    emit("ASSIGN", arguments[i], "", copy, line);
+                    arguments[i] = copy;
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < arguments.size(); i++) {
+            if (arguments[i] != parameters[i]->getName()) {
+                emit("ASSIGN", arguments[i], "", parameters[i]->getName(), line);
+            }
+        }
+        for (Variable* local : bareLocals) {
+            Type type = local->getType();
+            emit("ASSIGN", type == FLOAT_T ? "0.0" : type == STRING_T ? "\"\"" : type == CHAR_T ? "''" : "0", "", local->getName(), line);
+        }
+        emit("JMP", "", "", tailCallLabel, line);
+        return true;
+    }
+
+    // `return g(...)` inside another function becomes a TAILCALL, which runs g in place of the function that makes it
+    // and so needs the same return type. Whether a g nested in the function uses its frame is only known once its
+    // body is lowered, so the back ends run a TAILCALL of such a g as a CALL.
+    bool isTailCallable(Function* callee) const {
+        return currentFunction != nullptr && callee != currentFunction && callee->getType() == currentFunction->getType();
+    }
+
+    // The body is jumped over where the function is defined; ENTER gets the frame size once the body is known
+    void lowerFunction(const AstFunction* node) {
+        Function* function = node->function;
+        string skipFunctionLabel = quadruples.newLabel();
+        function->setLabel(quadruples.newLabel());
+        emit("JMP", "", "", skipFunctionLabel, node->line);
+        emitLabel(function->getLabel(), node->line);
+        size_t enter = quadruples.size();
+        emit("ENTER", "", "", "", node->line);
+
+        Function* enclosingFunction = currentFunction;
+        string enclosingTailCallLabel = tailCallLabel;
+        vector<Variable*> enclosingBareLocals = bareLocals;
+        currentFunction = function;
+        tailCallLabel.clear();
+        bareLocals.clear();
+        if (containsSelfTailCall(node->body, function)) {
+            vector<Variable*> locals;
+            if (function->getScope() != nullptr) {
+                function->getScope()->collectFrameVariables(locals);
+            }
+            for (Variable* local : locals) {
+                if (local->getIsDeclaredWithoutValue()) {
+                    bareLocals.push_back(local);
+                }
+            }
+            tailCallLabel = quadruples.newLabel();
+            emitLabel(tailCallLabel, node->line);
+        }
+        lowerStatement(node->body);
+        currentFunction = enclosingFunction;
+        tailCallLabel = enclosingTailCallLabel;
+        bareLocals = enclosingBareLocals;
+
+        computeFrameLayout(function, enter + 1);
+        quadruples.getQuadruple(enter).setArg1(to_string(function->getFrameSlots().size()));
+        emit("RET", "", "", "", node->line);
+        emitLabel(skipFunctionLabel, node->line);
+    }
+
+    // Links a module: its quadruples are appended with temporaries and labels of the program, renumbered as a
+    // block so they keep the order the module emitted them in, and its functions get the renamed entry labels
+    // and frames
+    void lowerImport(const AstImport* node) {
+        ImportedModule* module = node->module;
+        int temporaryBase = quadruples.reserveTemps(module->interface.temporaryCount);
+        int labelBase = quadruples.reserveLabels(module->interface.labelCount);
+        auto rename = [temporaryBase, labelBase](const string& name) {
+            if (Quadruple::isTemporary(name)) {
+                return "T" + to_string(temporaryBase + atoi(name.c_str() + 1));
+            }
+            if (!name.empty() && name.back() == ':') {
+                return "L" + to_string(labelBase + atoi(name.c_str() + 1)) + ":";
+            }
+            return name;
+        };
+        for (const Quadruple& quad : module->interface.quadruples) {
+            emit(rename(quad.getOp()), rename(quad.getArg1()), rename(quad.getArg2()), rename(quad.getResult()), quad.getLine());
+        }
+        PROFILE_COUNT(COUNTER_QUADS_COPIED, module->interface.quadruples.size());
+        for (size_t i = 0; i < module->functions.size(); i++) {
+            const ModuleFunction& moduleFunction = module->interface.functions[i];
+            module->functions[i]->setLabel(rename(moduleFunction.label));
+            for (const string& slot : moduleFunction.frameSlots) {
+                module->functions[i]->addFrameSlot(rename(slot));
+            }
+        }
+        // a module is linked once
+        vector<Quadruple>().swap(module->interface.quadruples);
+    }
+
+   public:
+    explicit Lowering(QuadrupleManager& quadruples) : quadruples(quadruples) {}
+
+    void lowerStatement(const AstNode* node) {
+        switch (node->kind) {
+            case AST_ASSIGN: {
+                const AstAssign* assign = static_cast<const AstAssign*>(node);
+                emit("ASSIGN", lowerValue(assign->value), "", assign->variable, node->line);
+                break;
+            }
+            case AST_BLOCK:
+                for (const AstNode* statement = static_cast<const AstBlock*>(node)->first; statement != nullptr; statement = statement->next) {
+                    lowerStatement(statement);
+                }
+                break;
+            case AST_IF:
+                lowerIf(static_cast<const AstConditional*>(node));
+                break;
+            case AST_WHILE:
+            case AST_REPEAT:
+            case AST_FOR:
+                lowerLoop(static_cast<const AstConditional*>(node));
+                break;
+            case AST_SWITCH:
+                lowerSwitch(static_cast<const AstSwitch*>(node));
+                break;
+            case AST_FUNCTION:
+                lowerFunction(static_cast<const AstFunction*>(node));
+                break;
+            case AST_IMPORT:
+                lowerImport(static_cast<const AstImport*>(node));
+                break;
+            case AST_RETURN: {
+                const AstReturn* ret = static_cast<const AstReturn*>(node);
+                const AstCall* call = ret->value != nullptr && ret->value->kind == AST_CALL ? static_cast<const AstCall*>(ret->value) : nullptr;
+                if (call != nullptr && currentFunction != nullptr && call->function == currentFunction && lowerSelfTailCall(call, node->line)) {
+                    break;
+                }
+                if (call != nullptr && isTailCallable(call->function)) {
+                    string result = lowerCall(call, "TAILCALL");
+                    emit("RET", call->function->getType() != VOID_T ? result : "", "", "", node->line);
+                    break;
+                }
+                emit("RET", ret->value != nullptr ? lowerValue(ret->value) : "", "", "", node->line);
+                break;
+            }
+            default:
+                // a call whose value is not used
+                lowerValue(node);
+                break;
+        }
+    }
+};
+
+void lowerStatement(const AstNode* statement) {
+    Lowering(getMainQuadrupleManager()).lowerStatement(statement);
+}
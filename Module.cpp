@@ -0,0 +1,306 @@
+#include "Module.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+
+#include "Profiler.hpp"
+#include "QuadrupleManager.hpp"
+#include "common.h"
+
+// Set by the parser from the command line
+extern "C" const char* inputFileName;
+extern "C" const char* compilerPath;
+
+// Every build writes interfaces of its own, since the quadruples of a function depend on the compiler
+static const string compilerBuild = __DATE__ " " __TIME__;
+
+// modules already imported, by path
+static unordered_map<string, ImportedModule*> importedModules;
+
+string ModuleInterface::hashSource(const string& path) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        return "";
+    }
+    unsigned long long hash = 14695981039346656037ULL;
+    char buffer[1 << 16];
+    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+        for (streamsize i = 0; i < in.gcount(); i++) {
+            hash = (hash ^ (unsigned char)buffer[i]) * 1099511628211ULL;
+        }
+    }
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", hash);
+    return text;
+}
+
+// Quadruple fields are separated by tabs, string literals may hold tabs and newlines of their own
+static string escapeField(const string& field) {
+    string escaped;
+    for (char c : field) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\t') {
+            escaped += "\\t";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static string unescapeField(const string& text, size_t begin, size_t end) {
+    string field;
+    for (size_t i = begin; i < end; i++) {
+        if (text[i] == '\\' && i + 1 < end) {
+            char next = text[++i];
+            field += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+        } else {
+            field += text[i];
+        }
+    }
+    return field;
+}
+
+// Splits the count fields of a record that start at begin; most fields hold no escapes and are copied as they are
+static bool splitFields(const string& text, size_t begin, char separator, string* fields, size_t count) {
+    bool escaped = text.find('\\', begin) != string::npos;
+    for (size_t i = 0; i < count; i++) {
+        size_t end = i + 1 < count ? text.find(separator, begin) : text.size();
+        if (end == string::npos || begin > text.size()) {
+            return false;
+        }
+        fields[i] = escaped ? unescapeField(text, begin, end) : text.substr(begin, end - begin);
+        begin = end + 1;
+    }
+    return true;
+}
+
+// Temporaries and labels of a module are numbered from 0, they are renamed by adding the count of the program
+static void countName(const string& name, int& temporaryCount, int& labelCount) {
+    if (Quadruple::isTemporary(name)) {
+        temporaryCount = max(temporaryCount, atoi(name.c_str() + 1) + 1);
+    } else if (!name.empty() && name.back() == ':') {
+        labelCount = max(labelCount, atoi(name.c_str() + 1) + 1);
+    }
+}
+
+static bool readType(const string& text, Type& type) {
+    int value = atoi(text.c_str());
+    type = (Type)value;
+    return value >= INTEGER_T && value <= VOID_T;
+}
+
+static bool readVariable(const string& text, size_t begin, vector<ModuleVariable>& variables) {
+    string fields[3];
+    ModuleVariable variable;
+    if (!splitFields(text, begin, ' ', fields, 3) || !readType(fields[0], variable.type)) {
+        return false;
+    }
+    variable.line = atoi(fields[1].c_str());
+    variable.name = fields[2];
+    variables.push_back(variable);
+    return true;
+}
+
+static bool startsWith(const string& text, const char* prefix) {
+    return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// One record per line, the argument, variable and slot records belong to the function before them:
+//     build <compiler build>
+//     source <hash>
+//     function <name> <return type> <line> <label> <exported>
+//     argument <type> <line> <name>
+//     variable <type> <line> <name>
+//     slot <name>
+//     quad <line> <op> <arg1> <arg2> <result>     (tab separated)
+bool ModuleInterface::read(istream& in) {
+    for (string text; getline(in, text);) {
+        if (text.empty() || text[0] == '#') {
+            continue;
+        }
+        if (startsWith(text, "quad\t")) {
+            string fields[5];
+            if (!splitFields(text, 5, '\t', fields, 5)) {
+                return false;
+            }
+            for (int i = 1; i < 5; i++) {
+                countName(fields[i], temporaryCount, labelCount);
+            }
+            quadruples.emplace_back(fields[1], fields[2], fields[3], fields[4], atoi(fields[0].c_str()));
+        } else if (startsWith(text, "build ")) {
+            compilerBuild = text.substr(6);
+        } else if (startsWith(text, "source ")) {
+            sourceHash = text.substr(7);
+        } else if (startsWith(text, "function ")) {
+            string fields[5];
+            ModuleFunction function;
+            if (!splitFields(text, 9, ' ', fields, 5) || !readType(fields[1], function.returnType)) {
+                return false;
+            }
+            function.name = fields[0];
+            function.line = atoi(fields[2].c_str());
+            function.label = fields[3];
+            function.exported = fields[4] == "1";
+            functions.push_back(function);
+        } else if (functions.empty()) {
+            return false;
+        } else if (startsWith(text, "argument ")) {
+            if (!readVariable(text, 9, functions.back().arguments)) {
+                return false;
+            }
+        } else if (startsWith(text, "variable ")) {
+            if (!readVariable(text, 9, functions.back().variables)) {
+                return false;
+            }
+        } else if (startsWith(text, "slot ")) {
+            functions.back().frameSlots.push_back(text.substr(5));
+        } else {
+            return false;
+        }
+    }
+    return !compilerBuild.empty() && !sourceHash.empty();
+}
+
+void ModuleInterface::write(ostream& out) const {
+    out << "# C-- module interface, written by the compiler for import \"<module>\"\n";
+    out << "build " << compilerBuild << "\n";
+    out << "source " << sourceHash << "\n";
+    for (const ModuleFunction& function : functions) {
+        out << "function " << function.name << " " << function.returnType << " " << function.line << " " << function.label << " "
+            << function.exported << "\n";
+        for (const ModuleVariable& argument : function.arguments) {
+            out << "argument " << argument.type << " " << argument.line << " " << argument.name << "\n";
+        }
+        for (const ModuleVariable& variable : function.variables) {
+            out << "variable " << variable.type << " " << variable.line << " " << variable.name << "\n";
+        }
+        for (const string& slot : function.frameSlots) {
+            out << "slot " << slot << "\n";
+        }
+    }
+    for (const Quadruple& quad : quadruples) {
+        out << "quad\t" << quad.getLine() << "\t" << escapeField(quad.getOp()) << "\t" << escapeField(quad.getArg1()) << "\t"
+            << escapeField(quad.getArg2()) << "\t" << escapeField(quad.getResult()) << "\n";
+    }
+}
+
+// A module is named relative to the file importing it
+static string resolveModulePath(const string& name) {
+    string importer = inputFileName;
+    size_t slash = importer.find_last_of("/\\");
+    if (name.empty() || name[0] == '/' || slash == string::npos) {
+        return name;
+    }
+    return importer.substr(0, slash + 1) + name;
+}
+
+// False when the cached interface is missing, malformed or out of date
+static bool loadInterface(const string& path, const string& sourceHash, ModuleInterface& interface) {
+    ifstream in(getOutputFileName(path.c_str(), "_interface.txt"));
+    interface = ModuleInterface();
+    return in && interface.read(in) && interface.compilerBuild == compilerBuild && interface.sourceHash == sourceHash;
+}
+
+// The parser and the symbol tables hold the state of a single file, so a module is compiled by another run of
+// the compiler, which reports the errors of the module itself
+static bool compileModule(const string& path) {
+    string command = "\"" + string(compilerPath) + "\" --emit-interface \"" + path + "\"";
+    fflush(stdout);
+    return system(command.c_str()) == 0;
+}
+
+static vector<Variable*> createModuleVariables(const vector<ModuleVariable>& variables, bool areArguments) {
+    vector<Variable*> created;
+    for (const ModuleVariable& variable : variables) {
+        created.push_back(new Variable(variable.type, variable.name, variable.line, false, areArguments, true));
+    }
+    return created;
+}
+
+extern "C" {
+
+void* importModule(const char* name, int line) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
+    if (compilerOptions.emitInterface) {
+        exitOnError("A module cannot import other modules", line);
+    }
+    if (!isGlobalScope()) {
+        exitOnError("Modules can only be imported in the global scope", line);
+    }
+    // the token keeps its quotes
+    string path = resolveModulePath(string(name + 1, strlen(name) - 2));
+    if (importedModules.count(path) != 0) {
+        return nullptr;
+    }
+
+    string sourceHash = ModuleInterface::hashSource(path);
+    if (sourceHash.empty()) {
+        string message = "Module " + path + " not found";
+        exitOnError(message.c_str(), line);
+    }
+    ImportedModule* module = new ImportedModule();
+    module->path = path;
+    if (!loadInterface(path, sourceHash, module->interface) && !(compileModule(path) && loadInterface(path, sourceHash, module->interface))) {
+        string message = "Unable to compile module " + path;
+        exitOnError(message.c_str(), line);
+    }
+
+    for (const ModuleFunction& moduleFunction : module->interface.functions) {
+        vector<Variable*>* arguments = new vector<Variable*>(createModuleVariables(moduleFunction.arguments, true));
+        Function* function = new Function(moduleFunction.name, moduleFunction.returnType, arguments, moduleFunction.line);
+        addImportedFunction(function, createModuleVariables(moduleFunction.variables, false), moduleFunction.exported, line);
+        module->functions.push_back(function);
+    }
+    importedModules[path] = module;
+    return createImportNode(module);
+}
+
+void writeModuleInterface(const char* inputFileName) {
+    vector<Variable*> globals = getGlobalVariables();
+    if (!globals.empty()) {
+        exitOnError("A module can only define functions", globals.front()->getLine());
+    }
+
+    ModuleInterface interface;
+    interface.compilerBuild = compilerBuild;
+    interface.sourceHash = ModuleInterface::hashSource(inputFileName);
+    for (Function* function : getFunctions()) {
+        ModuleFunction moduleFunction;
+        moduleFunction.name = function->getName();
+        moduleFunction.returnType = function->getType();
+        moduleFunction.line = function->getLine();
+        moduleFunction.label = function->getLabel();
+        moduleFunction.exported = isDeclaredInGlobalScope(function);
+        for (Variable* argument : *function->getArguments()) {
+            moduleFunction.arguments.push_back({argument->getType(), argument->getName(), argument->getLine()});
+        }
+        vector<Variable*> variables;
+        function->getScope()->collectFrameVariables(variables);
+        for (Variable* variable : variables) {
+            moduleFunction.variables.push_back({variable->getType(), variable->getName(), variable->getLine()});
+        }
+        moduleFunction.frameSlots = function->getFrameSlots();
+        interface.functions.push_back(moduleFunction);
+    }
+    interface.quadruples = getMainQuadrupleManager().getQuadruples();
+
+    // written next to it and renamed, so programs importing the module at the same time, as --batch runs them,
+    // never read a partly written interface
+    string path = getOutputFileName(inputFileName, "_interface.txt");
+    string partial = path + "." + to_string(getpid());
+    {
+        ofstream out(partial);
+        interface.write(out);
+    }
+    rename(partial.c_str(), path.c_str());
+}
+}
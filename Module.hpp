@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Quadruple.hpp"
+#include "SymbolTable.hpp"
+
+struct ModuleVariable {
+    Type type;
+    string name;
+    int line;
+};
+
+struct ModuleFunction {
+    string name;
+    Type returnType;
+    int line;
+    string label;                      // entry label in the quadruples of the module
+    bool exported;                     // declared at the top level of the module, so importers can call it
+    vector<ModuleVariable> arguments;
+    vector<ModuleVariable> variables;  // arguments and locals of every scope of the body
+    vector<string> frameSlots;
+};
+
+// Precompiled interface of a module, cached in <module>_interface.txt: the signatures of its functions and
+// their quadruples, whose temporaries and labels are renamed when they are linked into the importing program.
+// It is only valid for the source it was compiled from and for the build of the compiler that wrote it.
+struct ModuleInterface {
+    string compilerBuild;
+    string sourceHash;
+    vector<ModuleFunction> functions;  // in definition order
+    vector<Quadruple> quadruples;
+    int temporaryCount = 0;  // the quadruples use the temporaries T0 to T<temporaryCount - 1>
+    int labelCount = 0;      // and the labels L0: to L<labelCount - 1>:
+
+    // FNV-1a of the file, empty when it cannot be read
+    static string hashSource(const string& path);
+
+    // Returns false on a malformed file
+    bool read(istream& in);
+    void write(ostream& out) const;
+};
+
+// A module imported by the program being compiled, with the symbols its functions were declared as
+struct ImportedModule {
+    string path;
+    ModuleInterface interface;
+    vector<Function*> functions;  // in the order of interface.functions
+};
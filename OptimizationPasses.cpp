@@ -0,0 +1,1135 @@
+#include "OptimizationPasses.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "CallGraph.hpp"
+#include "QuadrupleManager.hpp"
+#include "SsaForm.hpp"
+#include "SymbolTable.hpp"
+
+static bool isFloatLiteral(const string& operand) {
+    return operand.find('.') != string::npos;
+}
+
+static string formatInteger(long long value) {
+    return to_string(value);
+}
+
+static string formatFloat(float value) {
+    if (value == 0) {
+        value = 0;  // drop the sign of -0
+    }
+    return to_string(value);
+}
+
+static string formatBoolean(bool value) {
+    return value ? "1" : "0";
+}
+
+template <typename T>
+static bool foldComparison(const string& op, T a, T b, string& folded) {
+    if (op == "LT") {
+        folded = formatBoolean(a < b);
+    } else if (op == "GT") {
+        folded = formatBoolean(a > b);
+    } else if (op == "LTE") {
+        folded = formatBoolean(a <= b);
+    } else if (op == "GTE") {
+        folded = formatBoolean(a >= b);
+    } else if (op == "EQ") {
+        folded = formatBoolean(a == b);
+    } else if (op == "NEQ") {
+        folded = formatBoolean(a != b);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool foldIntegerOperation(const string& op, long long a, long long b, string& folded) {
+    long long value;
+    if (op == "ADD") {
+        value = a + b;
+    } else if (op == "SUB") {
+        value = a - b;
+    } else if (op == "MUL") {
+        value = a * b;
+    } else if (op == "DIV") {
+        if (b == 0) {
+            return false;
+        }
+        value = a / b;
+    } else if (op == "POW") {
+        if (b < 0 || b > 62) {
+            return false;
+        }
+        value = 1;
+        for (long long i = 0; i < b; i++) {
+            value *= a;
+            if (value > INT_MAX || value < INT_MIN) {
+                return false;
+            }
+        }
+    } else if (op == "NEG") {
+        value = -b;
+    } else if (op == "AND" || op == "OR") {
+        if ((a != 0 && a != 1) || (b != 0 && b != 1)) {
+            return false;
+        }
+        folded = formatBoolean(op == "AND" ? (a && b) : (a || b));
+        return true;
+    } else {
+        return foldComparison(op, a, b, folded);
+    }
+    if (value > INT_MAX || value < INT_MIN) {
+        return false;
+    }
+    folded = formatInteger(value);
+    return true;
+}
+
+static bool foldFloatOperation(const string& op, float a, float b, string& folded) {
+    if (op == "ADD") {
+        folded = formatFloat(a + b);
+    } else if (op == "SUB") {
+        folded = formatFloat(a - b);
+    } else if (op == "MUL") {
+        folded = formatFloat(a * b);
+    } else if (op == "DIV") {
+        if (b == 0) {
+            return false;
+        }
+        folded = formatFloat(a / b);
+    } else if (op == "POW") {
+        folded = formatFloat(pow(a, b));
+    } else if (op == "NEG") {
+        folded = formatFloat(-b);
+    } else {
+        return foldComparison(op, a, b, folded);
+    }
+    return true;
+}
+
+bool foldConstantOperation(const string& op, const string& arg1, const string& arg2, string& folded) {
+    bool isUnary = op == "NEG";
+    if (!Quadruple::isNumericLiteral(arg2) || (!isUnary && !Quadruple::isNumericLiteral(arg1))) {
+        return false;
+    }
+    bool isFloat = isFloatLiteral(arg2);
+    if (!isUnary && isFloatLiteral(arg1) != isFloat) {
+        return false;
+    }
+    if (isFloat) {
+        float a = isUnary ? 0 : strtof(arg1.c_str(), nullptr);
+        return foldFloatOperation(op, a, strtof(arg2.c_str(), nullptr), folded);
+    }
+    long long a = isUnary ? 0 : strtoll(arg1.c_str(), nullptr, 10);
+    return foldIntegerOperation(op, a, strtoll(arg2.c_str(), nullptr, 10), folded);
+}
+
+string ConstantFoldingPass::getName() const {
+    return "constant-folding";
+}
+
+bool ConstantFoldingPass::run(FunctionUnit& unit) {
+    bool changed = false;
+    // constant value of each temporary assigned earlier in the current basic block
+    unordered_map<string, string> constants;
+
+    for (Quadruple& quad : unit.quadruples) {
+        if (quad.isLabel()) {
+            constants.clear();
+            continue;
+        }
+
+        if (!quad.isCall() && quad.getOp() != "JMP") {
+            auto arg1 = constants.find(quad.getArg1());
+            if (arg1 != constants.end()) {
+                quad.setArg1(arg1->second);
+                changed = true;
+            }
+            auto arg2 = constants.find(quad.getArg2());
+            if (arg2 != constants.end()) {
+                quad.setArg2(arg2->second);
+                changed = true;
+            }
+        }
+
+        string folded;
+        if (quad.isPureOperation() && quad.getOp() != "ASSIGN" &&
+            foldConstantOperation(quad.getOp(), quad.getArg1(), quad.getArg2(), folded)) {
+            quad = Quadruple("ASSIGN", folded, "", quad.getResult(), quad.getLine());
+            changed = true;
+        }
+
+        const string& result = quad.getResult();
+        if (quad.isPureOperation() || quad.isCall()) {
+            constants.erase(result);
+            if (quad.getOp() == "ASSIGN" && Quadruple::isTemporary(result) && Quadruple::isNumericLiteral(quad.getArg1())) {
+                constants[result] = quad.getArg1();
+            }
+        }
+
+        if (quad.isJump()) {
+            constants.clear();
+        }
+    }
+    return changed;
+}
+
+string DeadTemporaryEliminationPass::getName() const {
+    return "dead-temporary-elimination";
+}
+
+bool DeadTemporaryEliminationPass::run(FunctionUnit& unit) {
+    bool changed = false;
+    bool removedAny = true;
+    while (removedAny) {
+        unordered_map<string, int> useCount;
+        for (const Quadruple& quad : unit.quadruples) {
+            for (const string& operand : quad.getUsedOperands()) {
+                useCount[operand]++;
+            }
+        }
+
+        vector<Quadruple> kept;
+        kept.reserve(unit.quadruples.size());
+        removedAny = false;
+        for (const Quadruple& quad : unit.quadruples) {
+            const string& result = quad.getResult();
+            if (quad.isPureOperation() && Quadruple::isTemporary(result) && useCount.find(result) == useCount.end()) {
+                removedAny = true;
+                continue;
+            }
+            kept.push_back(quad);
+        }
+        if (removedAny) {
+            unit.quadruples.swap(kept);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Number of jumps targeting each label of the unit
+static unordered_map<string, int> countLabelReferences(const vector<Quadruple>& quadruples) {
+    unordered_map<string, int> references;
+    for (const Quadruple& quad : quadruples) {
+        string target = quad.getJumpTarget();
+        if (!target.empty()) {
+            references[target]++;
+        }
+    }
+    return references;
+}
+
+static size_t findLabel(const vector<Quadruple>& quadruples, const string& label, size_t end) {
+    for (size_t i = 0; i < end; i++) {
+        if (quadruples[i].getOp() == label) {
+            return i;
+        }
+    }
+    return end;
+}
+
+// The SSA passes need every edge into the unit, and a nested function reads and writes the frame around it
+static bool canBuildSsaForm(const FunctionUnit& unit) {
+    if (unit.hasExternalJumps) {
+        return false;
+    }
+    for (size_t i = 0; i < unit.quadruples.size(); i++) {
+        if (unit.quadruples[i].getOp() == "ENTER" && !(unit.isFunction() && i == 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Names that only the quadruples of the unit can change: temporaries, plus the frame of a function (a call
+// may change any global)
+static function<bool(const string&)> getTrackedNames(const FunctionUnit& unit) {
+    Function* function = unit.isFunction() ? getFunctionByLabel(unit.label) : nullptr;
+    return [function](const string& name) {
+        return Quadruple::isTemporary(name) || (function != nullptr && function->getFrameSlot(name) >= 0);
+    };
+}
+
+struct LatticeValue {
+    enum State { UNKNOWN, CONSTANT, VARYING } state = UNKNOWN;
+    string constant;
+};
+
+// Wegman and Zadeck: values start unknown and only move down to a constant and then to varying, while
+// blocks only become executable once an executable edge reaches them
+class ConstantSolver {
+   private:
+    const vector<Quadruple>& quads;
+    const SsaForm& ssa;
+    vector<LatticeValue> lattice;
+    // quadruples (>= 0) and phis (-value - 1) reading each value
+    vector<vector<int>> users;
+    // per block, whether the edge from each of its predecessors can be taken
+    vector<vector<bool>> executableEdges;
+    vector<bool> executableBlocks;
+    vector<pair<int, int>> flowWorklist;
+    vector<int> valueWorklist;
+
+    void lower(int value, const LatticeValue& next) {
+        LatticeValue& current = lattice[value];
+        if (current.state == LatticeValue::VARYING || next.state == LatticeValue::UNKNOWN) {
+            return;
+        }
+        if (current.state == LatticeValue::CONSTANT && next.state == LatticeValue::CONSTANT && current.constant == next.constant) {
+            return;
+        }
+        if (current.state == LatticeValue::CONSTANT) {
+            current.state = LatticeValue::VARYING;
+        } else {
+            current = next;
+        }
+        valueWorklist.push_back(value);
+    }
+
+    void addEdge(int from, int to) {
+        const vector<int>& predecessors = ssa.getBlocks()[to].predecessors;
+        size_t edge = find(predecessors.begin(), predecessors.end(), from) - predecessors.begin();
+        if (!executableEdges[to][edge]) {
+            flowWorklist.push_back({from, to});
+        }
+    }
+
+    void visitPhi(int phi) {
+        const SsaValue& value = ssa.getValues()[phi];
+        LatticeValue merged;
+        for (size_t edge = 0; edge < value.phiOperands.size(); edge++) {
+            if (!executableEdges[value.phiBlock][edge]) {
+                continue;
+            }
+            int operand = value.phiOperands[edge];
+            LatticeValue incoming;
+            incoming.state = LatticeValue::VARYING;
+            if (operand >= 0) {
+                incoming = lattice[operand];
+            }
+            if (incoming.state == LatticeValue::UNKNOWN || merged.state == LatticeValue::VARYING) {
+                continue;
+            }
+            if (merged.state == LatticeValue::UNKNOWN) {
+                merged = incoming;
+            } else if (incoming.state == LatticeValue::VARYING || incoming.constant != merged.constant) {
+                merged.state = LatticeValue::VARYING;
+            }
+        }
+        lower(phi, merged);
+    }
+
+    void visitQuadruple(size_t i) {
+        int value = ssa.getDefinedValue(i);
+        if (value < 0) {
+            return;
+        }
+        const Quadruple& quad = quads[i];
+        LatticeValue next;
+        next.state = LatticeValue::VARYING;
+        if (quad.getOp() == "ASSIGN") {
+            next = evaluateOperand(i, 0);
+        } else if (!quad.isCall()) {
+            LatticeValue a = evaluateOperand(i, 0);
+            LatticeValue b = evaluateOperand(i, 1);
+            if (a.state == LatticeValue::UNKNOWN || b.state == LatticeValue::UNKNOWN) {
+                return;
+            }
+            string folded;
+            if (a.state == LatticeValue::CONSTANT && b.state == LatticeValue::CONSTANT &&
+                foldConstantOperation(quad.getOp(), a.constant, b.constant, folded)) {
+                next.state = LatticeValue::CONSTANT;
+                next.constant = folded;
+            }
+        }
+        lower(value, next);
+    }
+
+    void visitBranch(int block) {
+        const SsaBlock& current = ssa.getBlocks()[block];
+        if (current.begin < current.end) {
+            size_t last = current.end - 1;
+            const string& op = quads[last].getOp();
+            LatticeValue condition = (op == "JF" || op == "JT") ? evaluateOperand(last, 0) : LatticeValue();
+            if (condition.state == LatticeValue::UNKNOWN && (op == "JF" || op == "JT")) {
+                return;
+            }
+            if (condition.state == LatticeValue::CONSTANT) {
+                bool jumps = (strtod(condition.constant.c_str(), nullptr) != 0) == (op == "JT");
+                int target = jumps ? ssa.getJumpTargetBlock(last) : block + 1;
+                if (target >= 0 && target < (int)ssa.getBlocks().size()) {
+                    addEdge(block, target);
+                }
+                return;
+            }
+        }
+        for (int successor : current.successors) {
+            addEdge(block, successor);
+        }
+    }
+
+   public:
+    ConstantSolver(const vector<Quadruple>& quads, const SsaForm& ssa)
+        : quads(quads), ssa(ssa), lattice(ssa.getValues().size()), users(ssa.getValues().size()), executableBlocks(ssa.getBlocks().size(), false) {
+        const vector<SsaBlock>& blocks = ssa.getBlocks();
+        for (const SsaBlock& block : blocks) {
+            executableEdges.push_back(vector<bool>(block.predecessors.size(), false));
+        }
+        for (size_t i = 0; i < quads.size(); i++) {
+            for (int position = 0; position < 2; position++) {
+                if (ssa.getUsedValue(i, position) >= 0) {
+                    users[ssa.getUsedValue(i, position)].push_back(i);
+                }
+            }
+        }
+        for (const SsaBlock& block : blocks) {
+            for (int phi : block.phis) {
+                for (int operand : ssa.getValues()[phi].phiOperands) {
+                    if (operand >= 0) {
+                        users[operand].push_back(-phi - 1);
+                    }
+                }
+            }
+        }
+        // arguments and uninitialized locals could hold anything on entry
+        for (size_t variable = 0; variable < ssa.getVariables().size(); variable++) {
+            lattice[ssa.getEntryValue(variable)].state = LatticeValue::VARYING;
+        }
+    }
+
+    void solve() {
+        flowWorklist.push_back({-1, 0});
+        while (!flowWorklist.empty() || !valueWorklist.empty()) {
+            if (!flowWorklist.empty()) {
+                pair<int, int> edge = flowWorklist.back();
+                flowWorklist.pop_back();
+                int block = edge.second;
+                const SsaBlock& current = ssa.getBlocks()[block];
+                if (edge.first >= 0) {
+                    size_t index = find(current.predecessors.begin(), current.predecessors.end(), edge.first) - current.predecessors.begin();
+                    if (executableEdges[block][index]) {
+                        continue;
+                    }
+                    executableEdges[block][index] = true;
+                }
+                for (int phi : current.phis) {
+                    visitPhi(phi);
+                }
+                if (!executableBlocks[block]) {
+                    executableBlocks[block] = true;
+                    for (size_t i = current.begin; i < current.end; i++) {
+                        visitQuadruple(i);
+                    }
+                    visitBranch(block);
+                }
+                continue;
+            }
+
+            int value = valueWorklist.back();
+            valueWorklist.pop_back();
+            for (int user : users[value]) {
+                if (user < 0) {
+                    int phi = -user - 1;
+                    if (executableBlocks[ssa.getValues()[phi].phiBlock]) {
+                        visitPhi(phi);
+                    }
+                    continue;
+                }
+                int block = ssa.getBlockOf(user);
+                if (!executableBlocks[block]) {
+                    continue;
+                }
+                visitQuadruple(user);
+                if ((size_t)user + 1 == ssa.getBlocks()[block].end) {
+                    visitBranch(block);
+                }
+            }
+        }
+    }
+
+    bool isExecutable(int block) const {
+        return executableBlocks[block];
+    }
+
+    const LatticeValue& getLattice(int value) const {
+        return lattice[value];
+    }
+
+    LatticeValue evaluateOperand(size_t i, int position) const {
+        const string& operand = position == 0 ? quads[i].getArg1() : quads[i].getArg2();
+        int value = ssa.getUsedValue(i, position);
+        if (value >= 0) {
+            return lattice[value];
+        }
+        LatticeValue result;
+        result.state = LatticeValue::VARYING;
+        // the missing first operand of NEG
+        if (operand.empty() || Quadruple::isNumericLiteral(operand)) {
+            result.state = LatticeValue::CONSTANT;
+            result.constant = operand;
+        }
+        return result;
+    }
+};
+
+string SparseConditionalConstantPropagationPass::getName() const {
+    return "sccp";
+}
+
+bool SparseConditionalConstantPropagationPass::run(FunctionUnit& unit) {
+    if (!canBuildSsaForm(unit)) {
+        return false;
+    }
+    const vector<Quadruple>& quads = unit.quadruples;
+    SsaForm ssa(quads, getTrackedNames(unit));
+    ConstantSolver solver(quads, ssa);
+    solver.solve();
+
+    bool changed = false;
+    vector<Quadruple> rewritten;
+    rewritten.reserve(quads.size());
+    for (size_t i = 0; i < quads.size(); i++) {
+        if (!solver.isExecutable(ssa.getBlockOf(i))) {
+            changed = true;
+            continue;
+        }
+        Quadruple quad = quads[i];
+        for (int position = 0; position < 2; position++) {
+            int value = ssa.getUsedValue(i, position);
+            if (value < 0 || solver.getLattice(value).state != LatticeValue::CONSTANT) {
+                continue;
+            }
+            if (position == 0) {
+                quad.setArg1(solver.getLattice(value).constant);
+            } else {
+                quad.setArg2(solver.getLattice(value).constant);
+            }
+            changed = true;
+        }
+
+        int defined = ssa.getDefinedValue(i);
+        if (defined >= 0 && solver.getLattice(defined).state == LatticeValue::CONSTANT &&
+            !(quad.getOp() == "ASSIGN" && quad.getArg1() == solver.getLattice(defined).constant)) {
+            quad = Quadruple("ASSIGN", solver.getLattice(defined).constant, "", quad.getResult(), quad.getLine());
+            changed = true;
+        }
+
+        if ((quad.getOp() == "JF" || quad.getOp() == "JT") && Quadruple::isNumericLiteral(quad.getArg1())) {
+            bool jumps = (strtod(quad.getArg1().c_str(), nullptr) != 0) == (quad.getOp() == "JT");
+            changed = true;
+            if (!jumps) {
+                continue;
+            }
+            quad = Quadruple("JMP", "", "", quad.getResult(), quad.getLine());
+        }
+        rewritten.push_back(quad);
+    }
+    if (changed) {
+        unit.quadruples.swap(rewritten);
+    }
+    return changed;
+}
+
+string GlobalValueNumberingPass::getName() const {
+    return "gvn";
+}
+
+static bool isCommutative(const string& op) {
+    return op == "ADD" || op == "MUL" || op == "EQ" || op == "NEQ" || op == "AND" || op == "OR";
+}
+
+bool GlobalValueNumberingPass::run(FunctionUnit& unit) {
+    if (!canBuildSsaForm(unit)) {
+        return false;
+    }
+    vector<Quadruple>& quads = unit.quadruples;
+    SsaForm ssa(quads, getTrackedNames(unit));
+    const vector<SsaValue>& values = ssa.getValues();
+    const vector<SsaBlock>& blocks = ssa.getBlocks();
+
+    // value number of every value: the first value computing the same thing on the dominator tree path
+    vector<int> number(values.size());
+    iota(number.begin(), number.end(), 0);
+    unordered_map<string, int> available;
+    vector<string> insertedKeys;
+    vector<size_t> insertedBefore(blocks.size(), 0);
+    vector<pair<int, size_t>> stack = {{0, 0}};
+    while (!stack.empty()) {
+        int block = stack.back().first;
+        size_t child = stack.back().second++;
+        if (child == 0) {
+            insertedBefore[block] = insertedKeys.size();
+            for (int phi : blocks[block].phis) {
+                // a phi whose operands are all the same value adds nothing
+                const vector<int>& operands = values[phi].phiOperands;
+                bool same = !operands.empty() && operands[0] >= 0;
+                for (int operand : operands) {
+                    same = same && operand >= 0 && number[operand] == number[operands[0]];
+                }
+                if (same) {
+                    number[phi] = number[operands[0]];
+                }
+            }
+            for (size_t i = blocks[block].begin; i < blocks[block].end; i++) {
+                int value = ssa.getDefinedValue(i);
+                const Quadruple& quad = quads[i];
+                if (value < 0 || quad.isCall()) {
+                    continue;
+                }
+                if (quad.getOp() == "ASSIGN") {
+                    if (ssa.getUsedValue(i, 0) >= 0) {
+                        number[value] = number[ssa.getUsedValue(i, 0)];
+                    }
+                    continue;
+                }
+                string operandKeys[2];
+                bool numbered = true;
+                for (int position = 0; position < 2; position++) {
+                    const string& operand = position == 0 ? quad.getArg1() : quad.getArg2();
+                    int used = ssa.getUsedValue(i, position);
+                    if (used >= 0) {
+                        operandKeys[position] = "v" + to_string(number[used]);
+                    } else if (operand.empty() || Quadruple::isNumericLiteral(operand)) {
+                        operandKeys[position] = "#" + operand;
+                    } else {
+                        numbered = false;  // globals may change between the two computations
+                    }
+                }
+                if (!numbered) {
+                    continue;
+                }
+                if (isCommutative(quad.getOp()) && operandKeys[1] < operandKeys[0]) {
+                    swap(operandKeys[0], operandKeys[1]);
+                }
+                string key = quad.getOp() + " " + operandKeys[0] + " " + operandKeys[1];
+                auto it = available.find(key);
+                if (it != available.end()) {
+                    number[value] = it->second;
+                } else {
+                    available[key] = value;
+                    insertedKeys.push_back(key);
+                }
+            }
+        }
+        if (child < blocks[block].dominatorChildren.size()) {
+            stack.push_back({blocks[block].dominatorChildren[child], 0});
+            continue;
+        }
+        while (insertedKeys.size() > insertedBefore[block]) {
+            available.erase(insertedKeys.back());
+            insertedKeys.pop_back();
+        }
+        stack.pop_back();
+    }
+
+    // only a name that is written once still holds its value wherever that definition dominates
+    vector<int> definitions(ssa.getVariables().size(), 0);
+    for (const SsaValue& value : values) {
+        if (value.quadruple >= 0) {
+            definitions[value.variable]++;
+        } else if (value.phiBlock >= 0) {
+            definitions[value.variable] += 2;
+        }
+    }
+
+    bool changed = false;
+    vector<string> replacements(values.size());
+    for (size_t i = 0; i < quads.size(); i++) {
+        int value = ssa.getDefinedValue(i);
+        if (value < 0 || number[value] == value || quads[i].getOp() == "ASSIGN" || quads[i].isCall()) {
+            continue;
+        }
+        const SsaValue& leader = values[number[value]];
+        if (leader.quadruple < 0 || definitions[leader.variable] != 1) {
+            continue;
+        }
+        const string& name = ssa.getVariables()[leader.variable];
+        quads[i] = Quadruple("ASSIGN", name, "", quads[i].getResult(), quads[i].getLine());
+        if (definitions[values[value].variable] == 1) {
+            replacements[value] = name;
+        }
+        changed = true;
+    }
+    for (size_t i = 0; i < quads.size(); i++) {
+        for (int position = 0; position < 2; position++) {
+            int used = ssa.getUsedValue(i, position);
+            if (used < 0 || replacements[used].empty()) {
+                continue;
+            }
+            if (position == 0) {
+                quads[i].setArg1(replacements[used]);
+            } else {
+                quads[i].setArg2(replacements[used]);
+            }
+        }
+    }
+    return changed;
+}
+
+string LoopRotationPass::getName() const {
+    return "loop-rotation";
+}
+
+bool LoopRotationPass::run(FunctionUnit& unit) {
+    vector<Quadruple>& quads = unit.quadruples;
+    bool changed = false;
+    unordered_map<string, int> references = countLabelReferences(quads);
+    // labels seen so far; a back edge jumps to one of them, and an inner loop ends first so it is rotated first
+    unordered_map<string, size_t> labelPositions;
+
+    for (size_t back = 0; back + 1 < quads.size(); back++) {
+        if (quads[back].isLabel()) {
+            labelPositions[quads[back].getOp()] = back;
+        }
+        const Quadruple& backEdge = quads[back];
+        string exitLabel = quads[back + 1].getOp();
+        string headerLabel = backEdge.getJumpTarget();
+        if (backEdge.getOp() != "JMP" || headerLabel.empty() || !quads[back + 1].isLabel() || references[headerLabel] != 1) {
+            continue;
+        }
+        auto position = labelPositions.find(headerLabel);
+        if (position == labelPositions.end()) {
+            continue;
+        }
+        size_t header = position->second;
+
+        // the condition is straight line code that only computes temporaries and leaves the loop with JF,
+        // which also keeps repeat until loops (whose body comes first) out
+        size_t conditionEnd = header;
+        int exits = 0;
+        for (size_t i = header + 1; i < back; i++) {
+            const Quadruple& quad = quads[i];
+            if (quad.isLabel() || quad.isCall() || (quad.isJump() && (quad.getOp() != "JF" || quad.getResult() != exitLabel)) ||
+                (!quad.isJump() && !Quadruple::isTemporary(quad.getResult()))) {
+                break;
+            }
+            if (quad.isJump()) {
+                conditionEnd = i;
+                exits++;
+            }
+        }
+        if (conditionEnd == header || references[exitLabel] != exits) {
+            continue;
+        }
+
+        // the condition moves in front of the header label and a copy ending in JT replaces the back edge;
+        // the body keeps its positions
+        vector<Quadruple> bottomTest(quads.begin() + header + 1, quads.begin() + conditionEnd + 1);
+        bottomTest.back() = Quadruple("JT", bottomTest.back().getArg1(), "", headerLabel, bottomTest.back().getLine());
+        rotate(quads.begin() + header, quads.begin() + header + 1, quads.begin() + conditionEnd + 1);
+        labelPositions[headerLabel] = conditionEnd;
+        quads[back] = bottomTest[0];
+        quads.insert(quads.begin() + back + 1, bottomTest.begin() + 1, bottomTest.end());
+        references[exitLabel] += exits - 1;
+
+        back += bottomTest.size() - 1;
+        changed = true;
+    }
+    return changed;
+}
+
+string LoopInvariantCodeMotionPass::getName() const {
+    return "loop-invariant-code-motion";
+}
+
+// Quadruples that can be executed once before the loop even if the loop body never runs
+static bool isHoistable(const Quadruple& quad) {
+    // DIV could fault on a division by zero that the loop would never have executed
+    return quad.isPureOperation() && quad.getOp() != "DIV" && Quadruple::isTemporary(quad.getResult());
+}
+
+// Temporaries whose definitions do not all compute the same value (rotation duplicates the condition)
+static unordered_set<string> findConflictingTemporaries(const vector<Quadruple>& quads) {
+    unordered_map<string, const Quadruple*> definitions;
+    unordered_set<string> conflicting;
+    for (const Quadruple& quad : quads) {
+        const string& result = quad.getResult();
+        if (quad.isJump() || !Quadruple::isTemporary(result)) {
+            continue;
+        }
+        auto it = definitions.find(result);
+        if (it == definitions.end()) {
+            definitions[result] = &quad;
+        } else if (it->second->getOp() != quad.getOp() || it->second->getArg1() != quad.getArg1() || it->second->getArg2() != quad.getArg2()) {
+            conflicting.insert(result);
+        }
+    }
+    return conflicting;
+}
+
+static bool hoistLoopInvariants(vector<Quadruple>& quads, size_t header, size_t back, const unordered_set<string>& conflicting) {
+    // definitions inside the loop of every name it modifies
+    unordered_map<string, int> modified;
+    for (size_t i = header; i <= back; i++) {
+        // a call may modify any global variable
+        if (quads[i].isCall()) {
+            return false;
+        }
+        if (!quads[i].isJump() && !quads[i].getResult().empty()) {
+            modified[quads[i].getResult()]++;
+        }
+    }
+
+    vector<Quadruple> hoisted;
+    vector<bool> isHoisted(back - header + 1, false);
+    bool hoistedAny = true;
+    while (hoistedAny) {
+        hoistedAny = false;
+        for (size_t i = header; i <= back; i++) {
+            const Quadruple& quad = quads[i];
+            if (isHoisted[i - header] || !isHoistable(quad) || conflicting.count(quad.getResult())) {
+                continue;
+            }
+            bool invariant = true;
+            for (const string& operand : quad.getUsedOperands()) {
+                if (modified.count(operand)) {
+                    invariant = false;
+                    break;
+                }
+            }
+            if (!invariant) {
+                continue;
+            }
+            hoisted.push_back(quad);
+            isHoisted[i - header] = true;
+            hoistedAny = true;
+            // the result no longer changes inside the loop once its last definition there is hoisted
+            auto definitions = modified.find(quad.getResult());
+            if (--definitions->second == 0) {
+                modified.erase(definitions);
+            }
+        }
+    }
+    if (hoisted.empty()) {
+        return false;
+    }
+
+    // the loop keeps its size, so positions outside of it do not change
+    vector<Quadruple> loop = move(hoisted);
+    for (size_t i = header; i <= back; i++) {
+        if (!isHoisted[i - header]) {
+            loop.push_back(move(quads[i]));
+        }
+    }
+    move(loop.begin(), loop.end(), quads.begin() + header);
+    return true;
+}
+
+bool LoopInvariantCodeMotionPass::run(FunctionUnit& unit) {
+    vector<Quadruple>& quads = unit.quadruples;
+    bool changed = false;
+    unordered_map<string, int> references = countLabelReferences(quads);
+    // hoisting only moves quadruples, so the temporaries that conflict stay the same
+    unordered_set<string> conflicting = findConflictingTemporaries(quads);
+    unordered_map<string, size_t> labelPositions;
+
+    // a loop is a label whose only reference is a backward jump; its preheader is right before the label
+    for (size_t back = 0; back < quads.size(); back++) {
+        if (quads[back].isLabel()) {
+            labelPositions[quads[back].getOp()] = back;
+        }
+        const Quadruple& backEdge = quads[back];
+        string headerLabel = backEdge.getJumpTarget();
+        if ((backEdge.getOp() != "JMP" && backEdge.getOp() != "JT") || headerLabel.empty() || references[headerLabel] != 1) {
+            continue;
+        }
+        auto position = labelPositions.find(headerLabel);
+        if (position == labelPositions.end()) {
+            continue;
+        }
+        // hoisting into an inner loop shifts the labels inside it, which never head a later loop
+        size_t header = position->second;
+        if (quads[header].getOp() != headerLabel) {
+            header = findLabel(quads, headerLabel, back);
+            if (header == back) {
+                continue;
+            }
+        }
+        // hoisting only moves quadruples in front of the loop, so back still indexes the back edge
+        if (hoistLoopInvariants(quads, header, back, conflicting)) {
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Inlining may grow the program by this share of its size, but always by at least minimumInlineGrowth quadruples
+static const int maximumInlineGrowthPercent = 50;
+static const long long minimumInlineGrowth = 64;
+
+InliningPass::InliningPass(int threshold) : threshold(threshold) {
+}
+
+string InliningPass::getName() const {
+    return "inline";
+}
+
+bool InliningPass::isInlinable(const string& label) const {
+    auto it = bodies.find(label);
+    if (it == bodies.end() || (int)it->second.size() > threshold) {
+        return false;
+    }
+    for (const Quadruple& quad : it->second) {
+        // nested functions would need a frame of their own, a call to itself would never stop inlining
+        if (quad.getOp() == "ENTER" || (quad.isCall() && quad.getArg1() == label)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void InliningPass::inlineCall(const string& calleeLabel, const vector<Quadruple>& parameters, const string& result, const string& callerLabel,
+                              vector<Quadruple>& out) const {
+    Function* callee = getFunctionByLabel(calleeLabel);
+    Function* caller = callerLabel.empty() ? nullptr : getFunctionByLabel(callerLabel);
+    const vector<Quadruple>& body = bodies.at(calleeLabel);
+    // module passes run on a single thread so the shared name counters can be used
+    QuadrupleManager& names = getMainQuadrupleManager();
+
+    unordered_map<string, string> renamed;
+    const vector<string>& frame = callee->getFrameSlots();
+    for (const string& name : frame) {
+        renamed[name] = names.newTemp();
+        if (caller != nullptr) {
+            caller->addFrameSlot(renamed[name]);
+        }
+    }
+    for (const Quadruple& quad : body) {
+        if (quad.isLabel()) {
+            renamed[quad.getOp()] = names.newLabel();
+        }
+    }
+    const string exitLabel = names.newLabel();
+    auto rename = [&renamed](const string& operand) {
+        auto it = renamed.find(operand);
+        return it == renamed.end() ? operand : it->second;
+    };
+
+    // the arguments occupy the first slots of the frame
+    for (size_t k = 0; k < parameters.size(); k++) {
+        out.push_back(Quadruple("ASSIGN", parameters[k].getArg1(), "", rename(frame[k]), parameters[k].getLine()));
+    }
+    bool exitLabelUsed = false;
+    for (size_t i = 0; i < body.size(); i++) {
+        const Quadruple& quad = body[i];
+        if (quad.getOp() == "RET") {
+            if (!quad.getArg1().empty() && !result.empty()) {
+                out.push_back(Quadruple("ASSIGN", rename(quad.getArg1()), "", result, quad.getLine()));
+            }
+            if (i + 1 < body.size()) {
+                out.push_back(Quadruple("JMP", "", "", exitLabel, quad.getLine()));
+                exitLabelUsed = true;
+            }
+            continue;
+        }
+        out.push_back(Quadruple(rename(quad.getOp()), rename(quad.getArg1()), rename(quad.getArg2()), rename(quad.getResult()), quad.getLine()));
+    }
+    // a label ends the basic block, so leave it out when the copy only falls through
+    if (exitLabelUsed) {
+        out.push_back(Quadruple(exitLabel, "", "", "", body.back().getLine()));
+    }
+}
+
+int InliningPass::run(vector<FunctionUnit>& units) {
+    long long programSize = 0;
+    for (const FunctionUnit& unit : units) {
+        programSize += unit.quadruples.size();
+    }
+    long long budget = max(minimumInlineGrowth, programSize * maximumInlineGrowthPercent / 100);
+
+    int changedUnits = 0;
+    // units are in source order and a function is defined before it is called, so callees are already final
+    for (FunctionUnit& unit : units) {
+        vector<Quadruple>& quads = unit.quadruples;
+        vector<Quadruple> rewritten;
+        rewritten.reserve(quads.size());
+        // skip labels of the nested functions being copied, their calls would need their own frame
+        vector<string> nestedFunctions;
+        bool changed = false;
+
+        for (size_t i = 0; i < quads.size(); i++) {
+            const Quadruple& quad = quads[i];
+            if (!nestedFunctions.empty() && quad.getOp() == nestedFunctions.back()) {
+                nestedFunctions.pop_back();
+            } else if (i > 0 && i + 1 < quads.size() && quad.isLabel() && quads[i + 1].getOp() == "ENTER" && quads[i - 1].getOp() == "JMP" &&
+                       !quads[i - 1].getResult().empty()) {
+                nestedFunctions.push_back(quads[i - 1].getResult());
+            }
+
+            if (quad.isCall() && nestedFunctions.empty() && isInlinable(quad.getArg1())) {
+                size_t argumentCount = (size_t)atoi(quad.getArg2().c_str());
+                bool parametersFound = argumentCount <= rewritten.size();
+                for (size_t k = 0; parametersFound && k < argumentCount; k++) {
+                    parametersFound = rewritten[rewritten.size() - 1 - k].getOp() == "PARAM";
+                }
+                long long growth = (long long)bodies[quad.getArg1()].size();
+                if (parametersFound && growth > budget) {
+                    callsOverBudget++;
+                } else if (parametersFound) {
+                    vector<Quadruple> parameters(rewritten.end() - argumentCount, rewritten.end());
+                    rewritten.erase(rewritten.end() - argumentCount, rewritten.end());
+                    inlineCall(quad.getArg1(), parameters, quad.getResult(), unit.label, rewritten);
+                    budget -= growth;
+                    addedQuadruples += growth;
+                    inlinedCalls++;
+                    changed = true;
+                    continue;
+                }
+            }
+            rewritten.push_back(quad);
+        }
+
+        if (changed) {
+            quads.swap(rewritten);
+            changedUnits++;
+            Function* function = unit.isFunction() ? getFunctionByLabel(unit.label) : nullptr;
+            if (function != nullptr) {
+                quads[1].setArg1(to_string(function->getFrameSlots().size()));
+            }
+        }
+        if (unit.isFunction() && quads.size() >= 2) {
+            size_t end = quads.size();
+            if (quads.back().getOp() == "RET" && quads.back().getArg1().empty()) {
+                end--;
+            }
+            bodies[unit.label].assign(quads.begin() + 2, quads.begin() + end);
+        }
+    }
+    return changedUnits;
+}
+
+string InliningPass::getSummary() const {
+    return to_string(inlinedCalls) + " calls inlined, " + to_string(addedQuadruples) + " quadruples copied, " + to_string(callsOverBudget) +
+           " calls over the growth budget";
+}
+
+string DeadFunctionEliminationPass::getName() const {
+    return "dead-function-elimination";
+}
+
+int DeadFunctionEliminationPass::run(vector<FunctionUnit>& units) {
+    CallGraph callGraph(units);
+    int changedUnits = 0;
+    for (size_t u = 0; u < units.size(); u++) {
+        const CallGraphNode* node = units[u].isFunction() ? callGraph.getNode(units[u].label) : nullptr;
+        if (node == nullptr) {
+            continue;
+        }
+        functionCount++;
+        leafFunctions += node->isLeaf() ? 1 : 0;
+        recursiveFunctions += node->isRecursive ? 1 : 0;
+        if (node->isReachable) {
+            continue;
+        }
+
+        // the global code jumps over the function to the label right after it
+        if (u > 0 && u + 1 < units.size()) {
+            vector<Quadruple>& before = units[u - 1].quadruples;
+            vector<Quadruple>& after = units[u + 1].quadruples;
+            if (!before.empty() && !after.empty() && before.back().getOp() == "JMP" && before.back().getResult() == after.front().getOp()) {
+                before.pop_back();
+                after.erase(after.begin());
+                changedUnits += 2;
+            }
+        }
+        units[u].quadruples.clear();
+        removedFunctions++;
+        changedUnits++;
+    }
+    return changedUnits;
+}
+
+string DeadFunctionEliminationPass::getSummary() const {
+    return to_string(removedFunctions) + " of " + to_string(functionCount) + " functions removed, " + to_string(leafFunctions) + " leaf, " +
+           to_string(recursiveFunctions) + " recursive";
+}
+
+string ConstantArgumentPropagationPass::getName() const {
+    return "constant-argument-propagation";
+}
+
+int ConstantArgumentPropagationPass::run(vector<FunctionUnit>& units) {
+    // literal passed for each argument of each function, empty once two call sites disagree
+    unordered_map<string, vector<string>> arguments;
+    for (const FunctionUnit& unit : units) {
+        const vector<Quadruple>& quads = unit.quadruples;
+        for (size_t i = 0; i < quads.size(); i++) {
+            if (!quads[i].isCall()) {
+                continue;
+            }
+            size_t count = (size_t)atoi(quads[i].getArg2().c_str());
+            vector<string> passed;
+            for (size_t k = 0; k < count && count <= i; k++) {
+                const Quadruple& param = quads[i - count + k];
+                passed.push_back(param.getOp() == "PARAM" && Quadruple::isNumericLiteral(param.getArg1()) ? param.getArg1() : "");
+            }
+            passed.resize(count);
+            auto it = arguments.find(quads[i].getArg1());
+            if (it == arguments.end()) {
+                arguments[quads[i].getArg1()] = passed;
+                continue;
+            }
+            for (size_t k = 0; k < count; k++) {
+                if (it->second[k] != passed[k]) {
+                    it->second[k] = "";
+                }
+            }
+        }
+    }
+
+    int changedUnits = 0;
+    for (FunctionUnit& unit : units) {
+        auto it = arguments.find(unit.label);
+        Function* function = unit.isFunction() ? getFunctionByLabel(unit.label) : nullptr;
+        if (it == arguments.end() || function == nullptr) {
+            continue;
+        }
+
+        unordered_map<string, string> constants;
+        const vector<string>& frame = function->getFrameSlots();
+        for (size_t k = 0; k < it->second.size() && k < frame.size(); k++) {
+            if (!it->second[k].empty()) {
+                constants[frame[k]] = it->second[k];
+            }
+        }
+        for (const Quadruple& quad : unit.quadruples) {
+            if (!quad.isJump() && !quad.isLabel()) {
+                constants.erase(quad.getResult());
+            }
+        }
+        if (constants.empty()) {
+            continue;
+        }
+
+        for (Quadruple& quad : unit.quadruples) {
+            if (quad.isLabel() || quad.isCall() || quad.getOp() == "ENTER") {
+                continue;
+            }
+            auto arg1 = constants.find(quad.getArg1());
+            if (arg1 != constants.end()) {
+                quad.setArg1(arg1->second);
+            }
+            auto arg2 = constants.find(quad.getArg2());
+            if (arg2 != constants.end()) {
+                quad.setArg2(arg2->second);
+            }
+        }
+        propagatedArguments += constants.size();
+        changedUnits++;
+    }
+    return changedUnits;
+}
+
+string ConstantArgumentPropagationPass::getSummary() const {
+    return to_string(propagatedArguments) + " arguments replaced by constants";
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include "PassManager.hpp"
+
+// Folds operations on numeric literals and forwards constant temporaries inside a basic block
+class ConstantFoldingPass : public FunctionPass {
+   public:
+    string getName() const override;
+    bool run(FunctionUnit& unit) override;
+};
+
+// Removes side effect free quadruples whose temporary result is never read in the unit
+class DeadTemporaryEliminationPass : public FunctionPass {
+   public:
+    string getName() const override;
+    bool run(FunctionUnit& unit) override;
+};
+
+// Sparse conditional constant propagation (Wegman and Zadeck) over the SSA form of the unit: finds the
+// variables that hold the same literal on every executable path, replaces their uses, folds branches on
+// constants and removes the blocks that can never run
+class SparseConditionalConstantPropagationPass : public FunctionPass {
+   public:
+    string getName() const override;
+    bool run(FunctionUnit& unit) override;
+};
+
+// Dominator based global value numbering over the SSA form of the unit: a computation that repeats one of
+// its dominators (also across if / else joins and into loop bodies) becomes a copy of the earlier result
+class GlobalValueNumberingPass : public FunctionPass {
+   public:
+    string getName() const override;
+    bool run(FunctionUnit& unit) override;
+};
+
+// Rotates while / for loops into a guarded bottom tested loop:
+//     Lh: cond; JF c, Lend; body; JMP Lh; Lend:
+// becomes
+//     cond; JF c, Lend; Lh: body; cond; JT c, Lh; Lend:
+// so every iteration runs a single jump instead of JF + JMP
+class LoopRotationPass : public FunctionPass {
+   public:
+    string getName() const override;
+    bool run(FunctionUnit& unit) override;
+};
+
+// Moves quadruples whose operands do not change inside a loop into its preheader
+class LoopInvariantCodeMotionPass : public FunctionPass {
+   public:
+    string getName() const override;
+    bool run(FunctionUnit& unit) override;
+};
+
+// Local rewrites over a window of consecutive quadruples: a temporary copied right after it is computed
+// is computed into the copy's target, runs of labels merge, jumps to the next quadruple and code after
+// an unconditional jump disappear, and JF over a single JMP becomes one JT. Rules are declared as
+// patterns in Peephole.cpp and applied with a worklist until none matches.
+class PeepholePass : public FunctionPass {
+   public:
+    PeepholePass();
+    string getName() const override;
+    bool run(FunctionUnit& unit) override;
+    // Number of rewrites made by each rule
+    string getSummary() const override;
+
+   private:
+    vector<atomic<long long>> ruleHits;
+};
+
+// Profile guided block layout (-fprofile-use): basic blocks are chained along their most taken edges,
+// hottest first (Pettis and Hansen), so the common successor of a jump is the next quadruple. Conditional
+// jumps are inverted or followed by a JMP where the new order needs it, and blocks that never ran move to
+// the end of the unit. Runs last, on the units whose jumps the profile has counts for.
+class ProfileGuidedLayoutPass : public FunctionPass {
+   public:
+    string getName() const override;
+    bool run(FunctionUnit& unit) override;
+    // Number of blocks moved and jumps inverted
+    string getSummary() const override;
+
+   private:
+    atomic<long long> movedBlocks{0};
+    atomic<long long> invertedJumps{0};
+};
+
+// Replaces calls of small non recursive functions by a copy of their body. Arguments become assignments
+// to fresh temporaries, the callee frame and labels are renamed and every RET jumps to the end of the copy.
+// Bodies are remembered across runs so --stream can inline functions defined in earlier statements.
+class InliningPass : public ModulePass {
+   public:
+    // Functions whose body has at most threshold quadruples are inlined
+    explicit InliningPass(int threshold);
+    string getName() const override;
+    int run(vector<FunctionUnit>& units) override;
+    string getSummary() const override;
+
+   private:
+    int threshold;
+    // body of every top level function seen so far without its label, ENTER and final RET
+    unordered_map<string, vector<Quadruple>> bodies;
+    long long inlinedCalls = 0;
+    long long addedQuadruples = 0;
+    long long callsOverBudget = 0;
+
+    bool isInlinable(const string& label) const;
+    void inlineCall(const string& calleeLabel, const vector<Quadruple>& parameters, const string& result, const string& callerLabel,
+                    vector<Quadruple>& out) const;
+};
+
+// Removes the top level functions that the global code can never call, together with the jump around them.
+// Needs the whole program, so it is not used with --stream.
+class DeadFunctionEliminationPass : public ModulePass {
+   public:
+    string getName() const override;
+    int run(vector<FunctionUnit>& units) override;
+    string getSummary() const override;
+
+   private:
+    int functionCount = 0;
+    int removedFunctions = 0;
+    int leafFunctions = 0;
+    int recursiveFunctions = 0;
+};
+
+// Replaces an argument that is never assigned by the literal that every call site passes for it.
+// Needs the whole program, so it is not used with --stream.
+class ConstantArgumentPropagationPass : public ModulePass {
+   public:
+    string getName() const override;
+    int run(vector<FunctionUnit>& units) override;
+    string getSummary() const override;
+
+   private:
+    int propagatedArguments = 0;
+};
+
+// Replaces a call of a pure function (Interpreter::isPureFunction) whose arguments are all numeric literals by
+// the number it returns, found by running the function and the ones it calls in the interpreter with a budget of
+// instructions. Needs the whole program, so it is not used with --stream.
+class PureCallEvaluationPass : public ModulePass {
+   public:
+    string getName() const override;
+    int run(vector<FunctionUnit>& units) override;
+    string getSummary() const override;
+
+   private:
+    int pureFunctions = 0;
+    long long evaluatedCalls = 0;
+};
+
+// Evaluates op on two numeric literals, returns false if it cannot be folded safely
+bool foldConstantOperation(const string& op, const string& arg1, const string& arg2, string& folded);
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "FastScanner.h"
+#include "ThreadPool.hpp"
+#include "common.h"
+
+// Bytes a chunk covers at least when --parallel-lex is given no size, small inputs stay in one chunk
+static const size_t defaultChunkBytes = 256 * 1024;
+// Chunks per worker, so a chunk that is slow to scan does not hold up the others
+static const size_t chunksPerJob = 4;
+
+// The tokens that start in [begin, end), scanned as if a token started at begin
+struct LexedChunk {
+    size_t begin = 0;
+    size_t end = 0;
+    vector<ScannedToken> tokens;
+    size_t stop = 0;  // where the scan stopped, the start of the first token at or after end
+    long long linesAtStop = 0;
+};
+
+struct ParallelLex {
+    const char* input = nullptr;
+    size_t length = 0;
+    vector<ScannedToken> tokens;  // lines counted from the start of the input
+    long long lines = 0;          // newlines in the whole input
+    size_t next = 0;
+    string text;  // yytext of the current token
+};
+
+static void lexChunk(const char* input, size_t length, LexedChunk& chunk) {
+    ScanCursor cursor;
+    startScan(&cursor, input, length, chunk.begin);
+    ScannedToken token;
+    while (scanNextToken(&cursor, chunk.end, &token)) {
+        chunk.tokens.push_back(token);
+    }
+    chunk.stop = cursor.position;
+    chunk.linesAtStop = cursor.lines;
+}
+
+// Chunks end after a newline, which is between two tokens unless it is inside a comment or a string
+static vector<LexedChunk> splitIntoChunks(const char* input, size_t length, size_t chunkCount) {
+    vector<LexedChunk> chunks;
+    size_t begin = 0;
+    for (size_t c = 1; c <= chunkCount && begin < length; c++) {
+        size_t end = c == chunkCount ? length : max(begin + 1, length / chunkCount * c);
+        while (end < length && input[end - 1] != '\n') {
+            end++;
+        }
+        LexedChunk chunk;
+        chunk.begin = begin;
+        chunk.end = end;
+        chunks.push_back(chunk);
+        begin = end;
+    }
+    return chunks;
+}
+
+// The chunks were scanned speculatively. The scan of the previous chunk tells where the first token of a chunk
+// really starts: when it is not the start of the chunk (a comment, string or char literal crossed the
+// boundary), the chunk is scanned again from there until a token starts where a speculative one did, and the
+// speculative tokens are kept from then on. The newlines counted per chunk are shifted to absolute lines.
+static void joinChunks(ParallelLex& lex, vector<LexedChunk>& chunks) {
+    size_t position = 0;
+    long long lines = 0;  // newlines before position
+    for (LexedChunk& chunk : chunks) {
+        if (position >= chunk.end) {
+            continue;  // inside a token or comment of an earlier chunk
+        }
+        size_t next = 0;
+        long long shift = lines;
+        if (position != chunk.begin) {
+            ScanCursor cursor;
+            startScan(&cursor, lex.input, lex.length, position);
+            ScannedToken token;
+            bool synchronized = false;
+            while (scanNextToken(&cursor, chunk.end, &token)) {
+                while (next < chunk.tokens.size() && chunk.tokens[next].start < token.start) {
+                    next++;
+                }
+                if (next < chunk.tokens.size() && chunk.tokens[next].start == token.start) {
+                    shift = lines + token.linesBefore - chunk.tokens[next].linesBefore;
+                    synchronized = true;
+                    break;
+                }
+                token.linesBefore += lines;
+                lex.tokens.push_back(token);
+            }
+            if (!synchronized) {
+                position = cursor.position;
+                lines += cursor.lines;
+                continue;
+            }
+        }
+        for (; next < chunk.tokens.size(); next++) {
+            ScannedToken token = chunk.tokens[next];
+            token.linesBefore += shift;
+            lex.tokens.push_back(token);
+        }
+        position = chunk.stop;
+        lines = chunk.linesAtStop + shift;
+        vector<ScannedToken>().swap(chunk.tokens);
+    }
+    lex.lines = lines;
+}
+
+static ParallelLex* lexInParallel() {
+    ParallelLex* lex = new ParallelLex();
+    lex->input = readScannerInput(&lex->length);
+    unsigned jobs = compilerOptions.jobs > 0 ? (unsigned)compilerOptions.jobs : ThreadPool::defaultThreadCount();
+    size_t chunkBytes = compilerOptions.parallelLexChunk > 0 ? (size_t)compilerOptions.parallelLexChunk : defaultChunkBytes;
+    size_t chunkCount = max<size_t>(1, min<size_t>(lex->length / chunkBytes, jobs * chunksPerJob));
+    vector<LexedChunk> chunks = splitIntoChunks(lex->input, lex->length, chunkCount);
+
+    if (jobs == 1 || chunks.size() <= 1) {
+        for (LexedChunk& chunk : chunks) {
+            lexChunk(lex->input, lex->length, chunk);
+        }
+    } else {
+        ThreadPool pool(min<size_t>(jobs, chunks.size()));
+        for (LexedChunk& chunk : chunks) {
+            LexedChunk* target = &chunk;
+            pool.enqueue([lex, target] { lexChunk(lex->input, lex->length, *target); });
+        }
+        pool.wait();
+    }
+    joinChunks(*lex, chunks);
+    return lex;
+}
+
+// The yylex of --parallel-lex: the whole input is scanned into a token array at the first call, the parser
+// then reads it one token at a time with the same yytext, yylineno and yylval the flex scanner would set
+extern "C" int parallelScanToken(void) {
+    static ParallelLex* lex = lexInParallel();
+    ScannedToken end;
+    const ScannedToken* token = &end;
+    if (lex->next < lex->tokens.size()) {
+        token = &lex->tokens[lex->next++];
+    } else {
+        end.token = 0;
+        end.error = SCAN_ERROR_NONE;
+        end.start = end.end = lex->length;
+        end.linesBefore = lex->lines;
+        end.linesInside = 0;
+    }
+    lex->text.assign(lex->input + token->start, token->end - token->start);
+    return emitScannedToken(token, &lex->text[0], 1);
+}
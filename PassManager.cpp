@@ -0,0 +1,271 @@
+#include "PassManager.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "BranchProfile.hpp"
+#include "OptimizationPasses.hpp"
+#include "Profiler.hpp"
+#include "QuadrupleManager.hpp"
+#include "ThreadPool.hpp"
+#include "Vendor/VariadicTable.h"
+#include "common.h"
+
+bool FunctionUnit::isFunction() const {
+    return !label.empty();
+}
+
+PassManager::PassManager(unsigned jobs) : jobs(jobs == 0 ? 1 : jobs) {
+}
+
+PassManager::~PassManager() {
+    for (ModulePass* pass : modulePasses) {
+        delete pass;
+    }
+    for (FunctionPass* pass : passes) {
+        delete pass;
+    }
+}
+
+void PassManager::addPass(FunctionPass* pass) {
+    passes.push_back(pass);
+    PassStatistics passStatistics;
+    passStatistics.name = pass->getName();
+    statistics.push_back(passStatistics);
+}
+
+void PassManager::addModulePass(ModulePass* pass) {
+    modulePasses.push_back(pass);
+    PassStatistics passStatistics;
+    passStatistics.name = pass->getName();
+    moduleStatistics.push_back(passStatistics);
+}
+
+static size_t countQuadruples(const vector<FunctionUnit>& units) {
+    size_t total = 0;
+    for (const FunctionUnit& unit : units) {
+        total += unit.quadruples.size();
+    }
+    return total;
+}
+
+// A function starts with its label followed by the ENTER of its frame
+static bool isFunctionEntry(const vector<Quadruple>& quadruples, size_t index) {
+    if (index == 0 || index + 1 >= quadruples.size()) {
+        return false;
+    }
+    const Quadruple& label = quadruples[index];
+    const Quadruple& next = quadruples[index + 1];
+    const Quadruple& previous = quadruples[index - 1];
+    return label.isLabel() && next.getOp() == "ENTER" && previous.getOp() == "JMP" && !previous.getResult().empty();
+}
+
+// Jumps over a function definition are the only expected jumps between units
+static void markExternalJumps(vector<FunctionUnit>& units, const unordered_set<string>& skipLabels) {
+    unordered_map<string, size_t> unitOfLabel;
+    for (size_t u = 0; u < units.size(); u++) {
+        for (const Quadruple& quad : units[u].quadruples) {
+            if (quad.isLabel()) {
+                unitOfLabel[quad.getOp()] = u;
+            }
+        }
+    }
+    for (size_t u = 0; u < units.size(); u++) {
+        for (const Quadruple& quad : units[u].quadruples) {
+            string target = quad.getJumpTarget();
+            if (target.empty() || skipLabels.count(target)) {
+                continue;
+            }
+            auto it = unitOfLabel.find(target);
+            if (it != unitOfLabel.end() && it->second != u) {
+                units[u].hasExternalJumps = true;
+                units[it->second].hasExternalJumps = true;
+            }
+        }
+    }
+}
+
+vector<FunctionUnit> PassManager::splitIntoUnits(const vector<Quadruple>& quadruples) {
+    vector<FunctionUnit> units;
+    FunctionUnit globalUnit;
+    unordered_set<string> skipLabels;
+
+    size_t i = 0;
+    while (i < quadruples.size()) {
+        if (!isFunctionEntry(quadruples, i)) {
+            globalUnit.quadruples.push_back(quadruples[i]);
+            i++;
+            continue;
+        }
+
+        // the function body ends right before the label that skips over it
+        const string& skipLabel = quadruples[i - 1].getResult();
+        skipLabels.insert(skipLabel);
+        size_t end = i + 1;
+        while (end < quadruples.size() && quadruples[end].getOp() != skipLabel) {
+            end++;
+        }
+
+        if (!globalUnit.quadruples.empty()) {
+            units.push_back(globalUnit);
+            globalUnit.quadruples.clear();
+        }
+
+        FunctionUnit functionUnit;
+        functionUnit.label = quadruples[i].getOp();
+        functionUnit.quadruples.assign(quadruples.begin() + i, quadruples.begin() + end);
+        units.push_back(functionUnit);
+        i = end;
+    }
+
+    if (!globalUnit.quadruples.empty()) {
+        units.push_back(globalUnit);
+    }
+    markExternalJumps(units, skipLabels);
+    return units;
+}
+
+vector<Quadruple> PassManager::mergeUnits(const vector<FunctionUnit>& units) {
+    vector<Quadruple> quadruples;
+    quadruples.reserve(countQuadruples(units));
+    for (const FunctionUnit& unit : units) {
+        quadruples.insert(quadruples.end(), unit.quadruples.begin(), unit.quadruples.end());
+    }
+    PROFILE_COUNT(COUNTER_QUADS_COPIED, quadruples.size());
+    return quadruples;
+}
+
+void PassManager::runPassesOnUnit(FunctionUnit& unit, vector<PassStatistics>& unitStatistics) const {
+    for (size_t p = 0; p < passes.size(); p++) {
+        size_t sizeBefore = unit.quadruples.size();
+        auto start = chrono::steady_clock::now();
+
+        bool changed = passes[p]->run(unit);
+
+        auto end = chrono::steady_clock::now();
+        unitStatistics[p].totalMilliseconds += chrono::duration<double, milli>(end - start).count();
+        unitStatistics[p].removedQuadruples += (long long)sizeBefore - (long long)unit.quadruples.size();
+        if (changed) {
+            unitStatistics[p].changedUnits++;
+        }
+    }
+}
+
+vector<Quadruple> PassManager::run(const vector<Quadruple>& quadruples) {
+    vector<FunctionUnit> units = splitIntoUnits(quadruples);
+    for (size_t p = 0; p < modulePasses.size(); p++) {
+        size_t sizeBefore = countQuadruples(units);
+        auto start = chrono::steady_clock::now();
+
+        int changedUnits = modulePasses[p]->run(units);
+
+        auto end = chrono::steady_clock::now();
+        moduleStatistics[p].totalMilliseconds += chrono::duration<double, milli>(end - start).count();
+        moduleStatistics[p].removedQuadruples += (long long)sizeBefore - (long long)countQuadruples(units);
+        moduleStatistics[p].changedUnits += changedUnits;
+    }
+
+    // one statistics row per unit so workers never share counters
+    vector<vector<PassStatistics>> unitStatistics(units.size(), vector<PassStatistics>(passes.size()));
+
+    if (jobs == 1 || units.size() <= 1) {
+        for (size_t u = 0; u < units.size(); u++) {
+            runPassesOnUnit(units[u], unitStatistics[u]);
+        }
+    } else {
+        ThreadPool pool(min<size_t>(jobs, units.size()));
+        for (size_t u = 0; u < units.size(); u++) {
+            pool.enqueue([this, &units, &unitStatistics, u] {
+                runPassesOnUnit(units[u], unitStatistics[u]);
+            });
+        }
+        pool.wait();
+    }
+
+    for (const vector<PassStatistics>& unitRow : unitStatistics) {
+        for (size_t p = 0; p < passes.size(); p++) {
+            statistics[p].changedUnits += unitRow[p].changedUnits;
+            statistics[p].removedQuadruples += unitRow[p].removedQuadruples;
+            statistics[p].totalMilliseconds += unitRow[p].totalMilliseconds;
+        }
+    }
+
+    return mergeUnits(units);
+}
+
+const vector<PassStatistics>& PassManager::getStatistics() const {
+    return statistics;
+}
+
+void PassManager::printStatistics(ostream& out) const {
+    VariadicTable<string, string, string, string> vt({"Pass", "Changed Units", "Removed Quads", "Time (ms)"});
+    vector<PassStatistics> rows = moduleStatistics;
+    rows.insert(rows.end(), statistics.begin(), statistics.end());
+    for (const PassStatistics& passStatistics : rows) {
+        ostringstream time;
+        time << fixed << setprecision(3) << passStatistics.totalMilliseconds;
+        vt.addRow(passStatistics.name, to_string(passStatistics.changedUnits), to_string(passStatistics.removedQuadruples), time.str());
+    }
+    vt.print(out);
+    for (ModulePass* pass : modulePasses) {
+        string summary = pass->getSummary();
+        if (!summary.empty()) {
+            out << pass->getName() << ": " << summary << "\n";
+        }
+    }
+    for (FunctionPass* pass : passes) {
+        string summary = pass->getSummary();
+        if (!summary.empty()) {
+            out << pass->getName() << ": " << summary << "\n";
+        }
+    }
+}
+
+extern "C" {
+
+// Created on first use and kept alive so statistics add up when --stream optimizes statement by statement
+static PassManager& getPassManager() {
+    static PassManager* passManager = nullptr;
+    if (passManager == nullptr) {
+        unsigned jobs = compilerOptions.jobs > 0 ? (unsigned)compilerOptions.jobs : ThreadPool::defaultThreadCount();
+        passManager = new PassManager(jobs);
+        // before inlining, which would copy the calls it can replace by their value
+        if (!compilerOptions.stream) {
+            passManager->addModulePass(new PureCallEvaluationPass());
+        }
+        if (compilerOptions.inlineThreshold > 0) {
+            passManager->addModulePass(new InliningPass(compilerOptions.inlineThreshold));
+        }
+        // a streamed statement does not know the calls that come after it
+        if (!compilerOptions.stream) {
+            passManager->addModulePass(new DeadFunctionEliminationPass());
+            passManager->addModulePass(new ConstantArgumentPropagationPass());
+        }
+        passManager->addPass(new ConstantFoldingPass());
+        passManager->addPass(new SparseConditionalConstantPropagationPass());
+        passManager->addPass(new GlobalValueNumberingPass());
+        passManager->addPass(new LoopRotationPass());
+        passManager->addPass(new LoopInvariantCodeMotionPass());
+        passManager->addPass(new DeadTemporaryEliminationPass());
+        passManager->addPass(new PeepholePass());
+        if (!getBranchProfile().isEmpty()) {
+            passManager->addPass(new ProfileGuidedLayoutPass());
+        }
+    }
+    return *passManager;
+}
+
+void optimizeQuadruples() {
+    PROFILE_SCOPE(PHASE_OPTIMIZE);
+    QuadrupleManager& quadManager = getMainQuadrupleManager();
+    quadManager.setQuadruples(getPassManager().run(quadManager.getQuadruples()));
+}
+
+void printPassStatistics() {
+    ostringstream oss;
+    getPassManager().printStatistics(oss);
+    printf("%s", oss.str().c_str());
+}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "Quadruple.hpp"
+
+// A slice of the final quadruple stream that can be optimized independently:
+// either a top level function (from its entry label up to its final RET)
+// or a run of global code between two function definitions
+struct FunctionUnit {
+    string label;  // entry label of the function, empty for global code
+    vector<Quadruple> quadruples;
+    // a jump between this unit and another one (a function defined inside a loop or an if), so the
+    // unit does not see all of its control flow
+    bool hasExternalJumps = false;
+
+    bool isFunction() const;
+};
+
+// Passes are shared between worker threads, so run() may only change the pass through atomic counters
+class FunctionPass {
+   public:
+    virtual ~FunctionPass() {}
+    virtual string getName() const = 0;
+    // Returns true if the unit was changed
+    virtual bool run(FunctionUnit& unit) = 0;
+    // Extra line printed under the pass statistics, empty for none
+    virtual string getSummary() const { return ""; }
+};
+
+// Module passes see every unit at once (e.g. to copy one function into another). They run one after
+// the other on the calling thread before the function passes, so they may keep state between runs.
+class ModulePass {
+   public:
+    virtual ~ModulePass() {}
+    virtual string getName() const = 0;
+    // Returns the number of units that were changed
+    virtual int run(vector<FunctionUnit>& units) = 0;
+    // Extra line printed under the pass statistics, empty for none
+    virtual string getSummary() const { return ""; }
+};
+
+struct PassStatistics {
+    string name;
+    int changedUnits = 0;
+    long long removedQuadruples = 0;
+    double totalMilliseconds = 0;
+};
+
+class PassManager {
+   private:
+    vector<ModulePass*> modulePasses;
+    vector<PassStatistics> moduleStatistics;
+    vector<FunctionPass*> passes;
+    vector<PassStatistics> statistics;
+    unsigned jobs;
+
+    // Runs every pass on one unit, recording into the unit's own statistics row
+    void runPassesOnUnit(FunctionUnit& unit, vector<PassStatistics>& unitStatistics) const;
+
+   public:
+    explicit PassManager(unsigned jobs);
+    ~PassManager();
+
+    // The pass manager takes ownership of the pass
+    void addPass(FunctionPass* pass);
+    void addModulePass(ModulePass* pass);
+
+    static vector<FunctionUnit> splitIntoUnits(const vector<Quadruple>& quadruples);
+    static vector<Quadruple> mergeUnits(const vector<FunctionUnit>& units);
+
+    // Split, run the module passes, optimize every unit on the thread pool and merge back in source order
+    vector<Quadruple> run(const vector<Quadruple>& quadruples);
+
+    const vector<PassStatistics>& getStatistics() const;
+    void printStatistics(ostream& out) const;
+};
@@ -0,0 +1,404 @@
+#include <sstream>
+#include <unordered_map>
+
+#include "OptimizationPasses.hpp"
+
+// Rewrite rules are types: a Shape lists the opcode classes of the consecutive quadruples a rule looks at,
+// and rewrite() checks the operands and changes the unit. The rule list below is unrolled by the compiler
+// into one matcher, so a quadruple is classified once and every rule test is a bit test on that class.
+
+enum PeepholeOpcode { OP_LABEL, OP_JMP, OP_JF, OP_JT, OP_RET, OP_ASSIGN, OP_COMPUTE, OP_CALL, OP_OTHER };
+
+static constexpr unsigned anyOf() {
+    return 0;
+}
+
+template <typename... Rest>
+static constexpr unsigned anyOf(PeepholeOpcode first, Rest... rest) {
+    return (1u << first) | anyOf(rest...);
+}
+
+static PeepholeOpcode classify(const Quadruple& quad) {
+    const string& op = quad.getOp();
+    if (quad.isLabel()) {
+        return OP_LABEL;
+    }
+    if (op == "JMP") {
+        return OP_JMP;
+    }
+    if (op == "JF") {
+        return OP_JF;
+    }
+    if (op == "JT") {
+        return OP_JT;
+    }
+    if (op == "RET") {
+        return OP_RET;
+    }
+    if (op == "ASSIGN") {
+        return OP_ASSIGN;
+    }
+    if (quad.isCall()) {
+        return OP_CALL;
+    }
+    return quad.isPureOperation() ? OP_COMPUTE : OP_OTHER;
+}
+
+// The unit as a linked list of live quadruples, so a rewrite removes a quadruple in constant time.
+// Labels are numbered and merged with union find; jump targets are written back once at the end.
+class PeepholeState {
+   public:
+    enum { NONE = -1 };
+
+    vector<Quadruple>& quads;
+    vector<PeepholeOpcode> opcodes;
+    vector<int> next, previous;
+    vector<bool> isLive;
+    vector<int> labelOf;   // label number of a label quadruple
+    vector<int> targetOf;  // label number a jump goes to, NONE if it leaves the unit
+    vector<int> labelParent;
+    vector<int> labelPosition;
+    vector<int> references;  // jumps to each label, counted on the representative
+    vector<bool> isPinned;   // the first label of the unit and called labels may be referenced from elsewhere
+    unordered_map<string, int> temporaryUses;
+    vector<int> worklist;
+
+    explicit PeepholeState(vector<Quadruple>& quads) : quads(quads) {
+        size_t count = quads.size();
+        opcodes.resize(count);
+        next.resize(count);
+        previous.resize(count);
+        isLive.assign(count, true);
+        labelOf.assign(count, NONE);
+        targetOf.assign(count, NONE);
+
+        unordered_map<string, int> labelNumbers;
+        for (size_t i = 0; i < count; i++) {
+            opcodes[i] = classify(quads[i]);
+            next[i] = i + 1 < count ? (int)(i + 1) : (int)NONE;
+            previous[i] = i > 0 ? (int)(i - 1) : (int)NONE;
+            if (opcodes[i] == OP_LABEL) {
+                labelOf[i] = labelParent.size();
+                labelNumbers[quads[i].getOp()] = labelParent.size();
+                labelParent.push_back(labelParent.size());
+                labelPosition.push_back(i);
+                isPinned.push_back(i == 0);
+            }
+        }
+        references.assign(labelParent.size(), 0);
+        for (size_t i = 0; i < count; i++) {
+            const Quadruple& quad = quads[i];
+            auto target = labelNumbers.find(quad.isCall() ? quad.getArg1() : quad.getJumpTarget());
+            if (target != labelNumbers.end()) {
+                if (quad.isCall()) {
+                    isPinned[target->second] = true;
+                } else {
+                    targetOf[i] = target->second;
+                    references[target->second]++;
+                }
+            }
+            for (const string& operand : quad.getUsedOperands()) {
+                if (Quadruple::isTemporary(operand)) {
+                    temporaryUses[operand]++;
+                }
+            }
+            worklist.push_back(count - 1 - i);
+        }
+    }
+
+    int findLabel(int label) {
+        while (labelParent[label] != label) {
+            labelParent[label] = labelParent[labelParent[label]];
+            label = labelParent[label];
+        }
+        return label;
+    }
+
+    int getTarget(int position) {
+        return targetOf[position] == NONE ? NONE : findLabel(targetOf[position]);
+    }
+
+    int getLabel(int position) {
+        return findLabel(labelOf[position]);
+    }
+
+    // Revisits the windows that contained position (the longest rule spans three quadruples)
+    void revisitAround(int position) {
+        for (int i = 0; i < 3 && position != NONE; i++) {
+            worklist.push_back(position);
+            position = previous[position];
+        }
+    }
+
+    void dropReference(int label) {
+        if (label != NONE && --references[label] == 0) {
+            revisitAround(labelPosition[label]);
+        }
+    }
+
+    void remove(int position) {
+        const Quadruple& quad = quads[position];
+        for (const string& operand : quad.getUsedOperands()) {
+            if (Quadruple::isTemporary(operand)) {
+                temporaryUses[operand]--;
+            }
+        }
+        dropReference(getTarget(position));
+        isLive[position] = false;
+        if (previous[position] != NONE) {
+            next[previous[position]] = next[position];
+        }
+        if (next[position] != NONE) {
+            previous[next[position]] = previous[position];
+        }
+        revisitAround(next[position] != NONE ? next[position] : previous[position]);
+    }
+
+    // Makes every jump to from go to into instead
+    void mergeLabel(int from, int into) {
+        labelParent[from] = into;
+        references[into] += references[from];
+        isPinned[into] = isPinned[into] || isPinned[from];
+    }
+
+    void writeBack() {
+        for (size_t i = 0; i < quads.size(); i++) {
+            int target = getTarget(i);
+            if (isLive[i] && target != NONE && target != targetOf[i]) {
+                const string& name = quads[labelPosition[target]].getOp();
+                if (quads[i].getResult().empty()) {
+                    quads[i].setArg1(name);
+                } else {
+                    quads[i].setResult(name);
+                }
+            }
+        }
+        vector<Quadruple> kept;
+        kept.reserve(quads.size());
+        for (size_t i = 0; i < quads.size(); i++) {
+            if (isLive[i]) {
+                kept.push_back(move(quads[i]));
+            }
+        }
+        quads.swap(kept);
+    }
+};
+
+// Positions of the live quadruples starting at the one being matched
+struct PeepholeWindow {
+    int positions[3];
+    int length;
+};
+
+template <unsigned... Masks>
+struct Shape;
+
+template <>
+struct Shape<> {
+    static const int length = 0;
+    static const unsigned firstMask = ~0u;
+    static bool matches(const PeepholeState&, const PeepholeWindow&, int) { return true; }
+};
+
+template <unsigned First, unsigned... Rest>
+struct Shape<First, Rest...> {
+    static const int length = 1 + Shape<Rest...>::length;
+    static const unsigned firstMask = First;
+    static bool matches(const PeepholeState& state, const PeepholeWindow& window, int index) {
+        return index < window.length && (First & (1u << state.opcodes[window.positions[index]])) &&
+               Shape<Rest...>::matches(state, window, index + 1);
+    }
+};
+
+// op a, b, T; ASSIGN T, , x  =>  op a, b, x  when the ASSIGN is the only read of T
+struct ForwardCopyRule {
+    typedef Shape<anyOf(OP_COMPUTE, OP_CALL, OP_ASSIGN), anyOf(OP_ASSIGN)> Pattern;
+    static const char* getName() { return "forward-copy"; }
+    static bool rewrite(PeepholeState& state, const PeepholeWindow& window) {
+        Quadruple& definition = state.quads[window.positions[0]];
+        const Quadruple& copy = state.quads[window.positions[1]];
+        const string& temporary = definition.getResult();
+        if (!Quadruple::isTemporary(temporary) || copy.getArg1() != temporary || state.temporaryUses[temporary] != 1) {
+            return false;
+        }
+        definition.setResult(copy.getResult());
+        state.remove(window.positions[1]);
+        return true;
+    }
+};
+
+// L3: L4:  =>  L3:  with every jump to L4 going to L3
+struct MergeLabelsRule {
+    typedef Shape<anyOf(OP_LABEL), anyOf(OP_LABEL)> Pattern;
+    static const char* getName() { return "merge-labels"; }
+    static bool rewrite(PeepholeState& state, const PeepholeWindow& window) {
+        int first = state.getLabel(window.positions[0]);
+        int second = state.getLabel(window.positions[1]);
+        if (!state.isPinned[second]) {
+            state.mergeLabel(second, first);
+            state.labelPosition[first] = window.positions[0];
+            state.remove(window.positions[1]);
+        } else if (!state.isPinned[first]) {
+            state.mergeLabel(first, second);
+            state.labelPosition[second] = window.positions[1];
+            state.remove(window.positions[0]);
+        } else {
+            return false;
+        }
+        return true;
+    }
+};
+
+// JMP L; L:  =>  L:  (also JF / JT, whose condition is a side effect free temporary)
+struct JumpToNextRule {
+    typedef Shape<anyOf(OP_JMP, OP_JF, OP_JT), anyOf(OP_LABEL)> Pattern;
+    static const char* getName() { return "jump-to-next"; }
+    static bool rewrite(PeepholeState& state, const PeepholeWindow& window) {
+        int target = state.getTarget(window.positions[0]);
+        if (target == PeepholeState::NONE || target != state.getLabel(window.positions[1])) {
+            return false;
+        }
+        state.remove(window.positions[0]);
+        return true;
+    }
+};
+
+// JF c, , L1; JMP L2; L1:  =>  JT c, , L2; L1:  (and the same with JT)
+struct InvertBranchRule {
+    typedef Shape<anyOf(OP_JF, OP_JT), anyOf(OP_JMP), anyOf(OP_LABEL)> Pattern;
+    static const char* getName() { return "invert-branch"; }
+    static bool rewrite(PeepholeState& state, const PeepholeWindow& window) {
+        int branch = window.positions[0];
+        int jump = window.positions[1];
+        int target = state.getTarget(branch);
+        if (target == PeepholeState::NONE || target != state.getLabel(window.positions[2])) {
+            return false;
+        }
+        const Quadruple& condition = state.quads[branch];
+        string op = state.opcodes[branch] == OP_JF ? "JT" : "JF";
+        state.quads[branch] = Quadruple(op, condition.getArg1(), "", state.quads[jump].getJumpTarget(), condition.getLine());
+        state.opcodes[branch] = state.opcodes[branch] == OP_JF ? OP_JT : OP_JF;
+        state.dropReference(target);
+        // the branch takes over the reference of the jump, which is then removed without dropping it again
+        state.targetOf[branch] = state.targetOf[jump];
+        state.targetOf[jump] = PeepholeState::NONE;
+        state.remove(jump);
+        return true;
+    }
+};
+
+// JMP L; x  =>  JMP L  for anything but a label, which nothing can reach (also after RET)
+struct UnreachableRule {
+    typedef Shape<anyOf(OP_JMP, OP_RET), ~anyOf(OP_LABEL)> Pattern;
+    static const char* getName() { return "unreachable"; }
+    static bool rewrite(PeepholeState& state, const PeepholeWindow& window) {
+        state.remove(window.positions[1]);
+        return true;
+    }
+};
+
+// L:  =>  nothing, when no jump in the unit goes to L
+struct UnusedLabelRule {
+    typedef Shape<anyOf(OP_LABEL)> Pattern;
+    static const char* getName() { return "unused-label"; }
+    static bool rewrite(PeepholeState& state, const PeepholeWindow& window) {
+        int label = state.getLabel(window.positions[0]);
+        if (state.isPinned[label] || state.references[label] != 0) {
+            return false;
+        }
+        state.remove(window.positions[0]);
+        return true;
+    }
+};
+
+template <typename... Rules>
+struct RuleList;
+
+template <>
+struct RuleList<> {
+    static const int count = 0;
+    static const int maximumLength = 0;
+    static const unsigned firstMask = 0;
+    static bool apply(PeepholeState&, const PeepholeWindow&, vector<long long>&, int) { return false; }
+    static void getNames(vector<string>&) {}
+};
+
+template <typename Rule, typename... Rest>
+struct RuleList<Rule, Rest...> {
+    static const int count = 1 + RuleList<Rest...>::count;
+    static const int maximumLength =
+        Rule::Pattern::length > RuleList<Rest...>::maximumLength ? Rule::Pattern::length : RuleList<Rest...>::maximumLength;
+    static const unsigned firstMask = Rule::Pattern::firstMask | RuleList<Rest...>::firstMask;
+
+    // Tries the rules in order and applies the first one that matches
+    static bool apply(PeepholeState& state, const PeepholeWindow& window, vector<long long>& hits, int rule) {
+        if (Rule::Pattern::matches(state, window, 0) && Rule::rewrite(state, window)) {
+            hits[rule]++;
+            return true;
+        }
+        return RuleList<Rest...>::apply(state, window, hits, rule + 1);
+    }
+
+    static void getNames(vector<string>& names) {
+        names.push_back(Rule::getName());
+        RuleList<Rest...>::getNames(names);
+    }
+};
+
+// A new rule is a struct like the ones above added to this list
+typedef RuleList<ForwardCopyRule, MergeLabelsRule, JumpToNextRule, InvertBranchRule, UnreachableRule, UnusedLabelRule> PeepholeRules;
+
+static_assert(PeepholeRules::maximumLength <= 3, "PeepholeWindow and revisitAround() hold three quadruples");
+
+PeepholePass::PeepholePass() : ruleHits(size_t(PeepholeRules::count)) {
+}
+
+string PeepholePass::getName() const {
+    return "peephole";
+}
+
+bool PeepholePass::run(FunctionUnit& unit) {
+    // a label of the unit may be the target of a jump in another unit
+    if (unit.hasExternalJumps) {
+        return false;
+    }
+    PeepholeState state(unit.quadruples);
+    vector<long long> hits(size_t(PeepholeRules::count), 0);
+    bool changed = false;
+
+    // every rewrite removes a quadruple and queues a constant number of positions, so this is linear
+    while (!state.worklist.empty()) {
+        int position = state.worklist.back();
+        state.worklist.pop_back();
+        if (!state.isLive[position] || !(PeepholeRules::firstMask & (1u << state.opcodes[position]))) {
+            continue;
+        }
+        PeepholeWindow window;
+        window.length = 0;
+        for (int i = position; i != PeepholeState::NONE && window.length < PeepholeRules::maximumLength; i = state.next[i]) {
+            window.positions[window.length++] = i;
+        }
+        if (PeepholeRules::apply(state, window, hits, 0)) {
+            state.worklist.push_back(position);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        state.writeBack();
+        for (int rule = 0; rule < PeepholeRules::count; rule++) {
+            ruleHits[rule] += hits[rule];
+        }
+    }
+    return changed;
+}
+
+string PeepholePass::getSummary() const {
+    vector<string> names;
+    PeepholeRules::getNames(names);
+    ostringstream summary;
+    for (int rule = 0; rule < PeepholeRules::count; rule++) {
+        summary << (rule > 0 ? ", " : "") << names[rule] << " " << ruleHits[rule].load();
+    }
+    return summary.str();
+}
@@ -0,0 +1,89 @@
+#include "Pipeline.hpp"
+
+#include <stdlib.h>
+
+#include <new>
+#include <string>
+#include <thread>
+using namespace std;
+
+#include "FastScanner.h"
+#include "SpscRing.hpp"
+#include "ThreadPool.hpp"
+
+// Tokens the lexer thread may run ahead of the parser
+static const size_t tokenRingCapacity = 1 << 14;
+
+struct TokenPipeline {
+    const char* input = nullptr;
+    size_t length = 0;
+    SpscRing<ScannedToken> ring{tokenRingCapacity};
+    bool finished = false;  // the end of the input was popped, the parser may ask for it again
+    ScannedToken last;
+    string text;  // yytext of the current token
+};
+
+// Stops after a lexical error, which ends the compilation once the parser reaches it
+static void lexIntoRing(TokenPipeline* pipeline) {
+    ScanCursor cursor;
+    startScan(&cursor, pipeline->input, pipeline->length, 0);
+    ScannedToken token;
+    while (scanNextToken(&cursor, pipeline->length, &token)) {
+        pipeline->ring.push(token);
+        if (token.error != SCAN_ERROR_NONE) {
+            return;
+        }
+    }
+    token.token = 0;
+    token.error = SCAN_ERROR_NONE;
+    token.start = token.end = pipeline->length;
+    token.linesBefore = cursor.lines;
+    token.linesInside = 0;
+    pipeline->ring.push(token);
+}
+
+static TokenPipeline* startTokenPipeline() {
+    // before C++17 new ignores the alignment of over-aligned types, which keeps the producer and consumer indices
+    // of the ring on separate cache lines
+    void* memory = nullptr;
+    if (posix_memalign(&memory, alignof(TokenPipeline), sizeof(TokenPipeline)) != 0) {
+        throw bad_alloc();
+    }
+    TokenPipeline* pipeline = new (memory) TokenPipeline();
+    pipeline->input = readScannerInput(&pipeline->length);
+    thread(lexIntoRing, pipeline).detach();
+    return pipeline;
+}
+
+// The yylex of --pipeline: the lexer thread scans with the fast scanner while the parser works, this pops its
+// tokens and sets yytext, yylineno and yylval like the flex scanner would
+extern "C" int pipelineScanToken(void) {
+    static TokenPipeline* pipeline = startTokenPipeline();
+    if (!pipeline->finished) {
+        pipeline->last = pipeline->ring.pop();
+        pipeline->finished = pipeline->last.token == 0 && pipeline->last.error == SCAN_ERROR_NONE;
+    }
+    const ScannedToken& token = pipeline->last;
+    pipeline->text.assign(pipeline->input + token.start, token.end - token.start);
+    return emitScannedToken(&token, &pipeline->text[0], 1);
+}
+
+static ThreadPool* outputWriter = nullptr;
+
+void runOnOutputWriter(function<void()> task) {
+    if (!compilerOptions.pipeline) {
+        task();
+        return;
+    }
+    // one thread, so the files and stdout are written in the order the tasks were given
+    if (outputWriter == nullptr) {
+        outputWriter = new ThreadPool(1);
+    }
+    outputWriter->enqueue(task);
+}
+
+extern "C" void finishOutputWriter(void) {
+    if (outputWriter != nullptr) {
+        outputWriter->wait();
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <functional>
+using namespace std;
+
+#include "common.h"
+
+// Runs the task on the --pipeline writer thread, after the tasks given to it before, or right away without
+// --pipeline. Tasks must not touch anything the parser still changes.
+void runOnOutputWriter(function<void()> task);
@@ -0,0 +1,282 @@
+#include "Profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Vendor/VariadicTable.h"
+using namespace std;
+
+struct PhaseRecord {
+    long long selfNanoseconds = 0;
+    long long calls = 0;
+};
+
+struct ActivePhase {
+    ProfilerPhase phase;
+    chrono::steady_clock::time_point start;
+    long long childNanoseconds;
+};
+
+// Static initialization runs on the main thread; the hooks ignore the --pipeline lexer and writer threads
+static const thread::id profiledThread = this_thread::get_id();
+static PhaseRecord phaseRecords[PHASE_COUNT];
+static long long counters[COUNTER_COUNT];
+static vector<ActivePhase> activePhases;
+// operator new is also called from the optimizer's worker threads; counted while a report is requested
+static atomic<long long> allocationCount(0);
+
+struct MemoryRecord {
+    long long liveBytes = 0;
+    long long peakBytes = 0;
+    long long allocations = 0;
+    long long allocatedBytes = 0;
+};
+
+struct LiveAllocation {
+    size_t size;
+    MemorySubsystem subsystem;
+};
+
+// --mem-report keeps every live C++ allocation in a table so that a free is charged to the subsystem that
+// allocated it. Without a report operator new only tests profilerEnabled, so the optimizer's workers do not
+// contend on the allocation counter, and operator delete only tests memoryTracking.
+static atomic<bool> memoryTracking(false);
+static atomic<int> activeSubsystem(MEMORY_OTHER);  // read by the worker threads, which run inside the optimize phase
+static mutex memoryMutex;
+static unordered_map<void*, LiveAllocation>* liveAllocations = nullptr;
+static MemoryRecord memoryRecords[MEMORY_SUBSYSTEM_COUNT];
+static long long totalLiveBytes = 0;
+static long long totalPeakBytes = 0;
+// set while the table itself allocates, so those allocations are not recorded
+static thread_local bool insideMemoryHook = false;
+
+static const MemorySubsystem subsystemOfPhase[PHASE_COUNT] = {
+    MEMORY_LEXER, MEMORY_PARSER_VALUES, MEMORY_SYMBOLS, MEMORY_IR, MEMORY_IR, MEMORY_OUTPUT, MEMORY_OUTPUT, MEMORY_OUTPUT};
+
+static const char* subsystemNames[MEMORY_SUBSYSTEM_COUNT] = {"lexer", "parser values", "ast", "symbols", "ir", "output", "other"};
+
+// Called with memoryMutex held
+static void chargeAllocation(MemorySubsystem subsystem, long long bytes) {
+    MemoryRecord& record = memoryRecords[subsystem];
+    record.liveBytes += bytes;
+    record.allocations++;
+    record.allocatedBytes += bytes;
+    if (record.liveBytes > record.peakBytes) {
+        record.peakBytes = record.liveBytes;
+    }
+    totalLiveBytes += bytes;
+    if (totalLiveBytes > totalPeakBytes) {
+        totalPeakBytes = totalLiveBytes;
+    }
+}
+
+static void recordNew(void* pointer, size_t size) {
+    lock_guard<mutex> lock(memoryMutex);
+    insideMemoryHook = true;
+    MemorySubsystem subsystem = (MemorySubsystem)activeSubsystem.load(memory_order_relaxed);
+    (*liveAllocations)[pointer] = {size, subsystem};
+    chargeAllocation(subsystem, size);
+    insideMemoryHook = false;
+}
+
+static void recordDelete(void* pointer) {
+    lock_guard<mutex> lock(memoryMutex);
+    insideMemoryHook = true;
+    auto it = liveAllocations->find(pointer);
+    // blocks allocated before the report started are not in the table
+    if (it != liveAllocations->end()) {
+        memoryRecords[it->second.subsystem].liveBytes -= it->second.size;
+        totalLiveBytes -= it->second.size;
+        liveAllocations->erase(it);
+    }
+    insideMemoryHook = false;
+}
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "lex", "parse", "semantic", "ir", "optimize", "output_symbol_table", "output_quadruples", "output_warnings"};
+
+static const char* counterNames[COUNTER_COUNT] = {
+    "tokens", "symbol_lookups", "scopes_searched", "max_scope_depth", "quads_emitted", "quads_copied", "bytes_written", "allocations"};
+
+void* operator new(size_t size) {
+    void* pointer = malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw bad_alloc();
+    }
+    if (profilerEnabled) {
+        allocationCount.fetch_add(1, memory_order_relaxed);
+        if (memoryTracking.load(memory_order_relaxed) && !insideMemoryHook) {
+            recordNew(pointer, size);
+        }
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer != nullptr && memoryTracking.load(memory_order_relaxed) && !insideMemoryHook) {
+        recordDelete(pointer);
+    }
+    free(pointer);
+}
+
+extern "C" {
+
+int profilerEnabled = 0;
+
+void startTimeReport(void) {
+    profilerEnabled = 1;
+}
+
+void profilerBeginPhase(ProfilerPhase phase) {
+    if (this_thread::get_id() != profiledThread) {
+        return;
+    }
+    activePhases.push_back({phase, chrono::steady_clock::now(), 0});
+    activeSubsystem.store(subsystemOfPhase[phase], memory_order_relaxed);
+}
+
+void profilerEndPhase(ProfilerPhase phase) {
+    if (this_thread::get_id() != profiledThread || activePhases.empty()) {
+        return;
+    }
+    auto now = chrono::steady_clock::now();
+    ActivePhase active = activePhases.back();
+    activePhases.pop_back();
+
+    long long elapsed = chrono::duration_cast<chrono::nanoseconds>(now - active.start).count();
+    PhaseRecord& record = phaseRecords[phase];
+    record.selfNanoseconds += elapsed - active.childNanoseconds;
+    record.calls++;
+
+    if (!activePhases.empty()) {
+        activePhases.back().childNanoseconds += elapsed;
+    }
+    activeSubsystem.store(activePhases.empty() ? MEMORY_OTHER : subsystemOfPhase[activePhases.back().phase], memory_order_relaxed);
+}
+
+void profilerAddToCounter(ProfilerCounter counter, long long amount) {
+    if (this_thread::get_id() != profiledThread) {
+        return;
+    }
+    counters[counter] += amount;
+}
+
+void profilerUpdateMaxCounter(ProfilerCounter counter, long long value) {
+    if (this_thread::get_id() != profiledThread) {
+        return;
+    }
+    if (value > counters[counter]) {
+        counters[counter] = value;
+    }
+}
+
+static string formatMilliseconds(long long nanoseconds) {
+    ostringstream oss;
+    oss << fixed << setprecision(3) << nanoseconds / 1e6;
+    return oss.str();
+}
+
+void printTimeReport(int asJson) {
+    counters[COUNTER_ALLOCATIONS] = allocationCount.load();
+    long long totalNanoseconds = 0;
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        totalNanoseconds += phaseRecords[phase].selfNanoseconds;
+    }
+
+    ostringstream oss;
+    if (asJson) {
+        oss << "{\n  \"total_ms\": " << formatMilliseconds(totalNanoseconds) << ",\n  \"phases\": {\n";
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            oss << "    \"" << phaseNames[phase] << "\": {\"ms\": " << formatMilliseconds(phaseRecords[phase].selfNanoseconds)
+                << ", \"calls\": " << phaseRecords[phase].calls << "}" << (phase + 1 < PHASE_COUNT ? "," : "") << "\n";
+        }
+        oss << "  },\n  \"counters\": {\n";
+        for (int counter = 0; counter < COUNTER_COUNT; counter++) {
+            oss << "    \"" << counterNames[counter] << "\": " << counters[counter] << (counter + 1 < COUNTER_COUNT ? "," : "") << "\n";
+        }
+        oss << "  }\n}\n";
+    } else {
+        VariadicTable<string, string, string, string> phaseTable({"Phase", "Self Time (ms)", "Share", "Calls"});
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            const PhaseRecord& record = phaseRecords[phase];
+            ostringstream share;
+            share << fixed << setprecision(1) << (totalNanoseconds ? 100.0 * record.selfNanoseconds / totalNanoseconds : 0.0) << "%";
+            phaseTable.addRow(phaseNames[phase], formatMilliseconds(record.selfNanoseconds), share.str(), to_string(record.calls));
+        }
+        phaseTable.addRow("total", formatMilliseconds(totalNanoseconds), "100.0%", "");
+
+        VariadicTable<string, string> counterTable({"Counter", "Value"});
+        for (int counter = 0; counter < COUNTER_COUNT; counter++) {
+            counterTable.addRow(counterNames[counter], to_string(counters[counter]));
+        }
+
+        oss << "------ Time Report ------\n";
+        phaseTable.print(oss);
+        oss << "\n";
+        counterTable.print(oss);
+    }
+    printf("%s", oss.str().c_str());
+}
+
+void startMemoryReport(void) {
+    liveAllocations = new unordered_map<void*, LiveAllocation>();
+    memoryTracking.store(true);
+    // allocations are charged to the subsystem of the running phase
+    profilerEnabled = 1;
+}
+
+void profilerRecordAllocation(MemorySubsystem subsystem, long long bytes) {
+    if (!memoryTracking.load(memory_order_relaxed)) {
+        return;
+    }
+    lock_guard<mutex> lock(memoryMutex);
+    chargeAllocation(subsystem, bytes);
+}
+
+void printMemoryReport(void) {
+    // copied under the lock, the report allocates too
+    MemoryRecord records[MEMORY_SUBSYSTEM_COUNT];
+    MemoryRecord total;
+    {
+        lock_guard<mutex> lock(memoryMutex);
+        copy(memoryRecords, memoryRecords + MEMORY_SUBSYSTEM_COUNT, records);
+        total.liveBytes = totalLiveBytes;
+        total.peakBytes = totalPeakBytes;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    VariadicTable<string, string, string, string, string> table({"Subsystem", "Live Bytes", "Peak Bytes", "Allocations", "Allocated Bytes"});
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEM_COUNT; subsystem++) {
+        const MemoryRecord& record = records[subsystem];
+        table.addRow(subsystemNames[subsystem], to_string(record.liveBytes), to_string(record.peakBytes), to_string(record.allocations),
+                     to_string(record.allocatedBytes));
+        total.allocations += record.allocations;
+        total.allocatedBytes += record.allocatedBytes;
+    }
+    table.addRow("total", to_string(total.liveBytes), to_string(total.peakBytes), to_string(total.allocations), to_string(total.allocatedBytes));
+
+    ostringstream oss;
+    oss << "------ Memory Report ------\n";
+    table.print(oss);
+    // ru_maxrss is in kilobytes on Linux
+    oss << "Peak resident set size: " << usage.ru_maxrss << " KB\n";
+    printf("%s", oss.str().c_str());
+}
+}
+
+#endif
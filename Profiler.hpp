@@ -0,0 +1,28 @@
+#pragma once
+
+#include "common.h"
+
+#ifdef ENABLE_PROFILER
+// Times the enclosing C++ scope as the given phase
+class ScopedPhaseTimer {
+   private:
+    ProfilerPhase phase;
+    bool active;  // the end matches the begin even if a report starts inside the scope
+
+   public:
+    explicit ScopedPhaseTimer(ProfilerPhase phase) : phase(phase), active(profilerEnabled) {
+        if (active) {
+            profilerBeginPhase(phase);
+        }
+    }
+    ~ScopedPhaseTimer() {
+        if (active) {
+            profilerEndPhase(phase);
+        }
+    }
+};
+
+#define PROFILE_SCOPE(phase) ScopedPhaseTimer scopedPhaseTimer(phase)
+#else
+#define PROFILE_SCOPE(phase)
+#endif
@@ -0,0 +1,145 @@
+#include <stdio.h>
+
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Interpreter.hpp"
+#include "OptimizationPasses.hpp"
+#include "SymbolTable.hpp"
+
+// Instructions a single call may run at compile time before it is left to run time
+static const long long evaluationBudget = 100000;
+
+// The value as a literal of the quadruples, false when it has none that reads back exactly
+static bool formatLiteral(const RuntimeValue& value, Type type, string& literal) {
+    if (type == INTEGER_T) {
+        literal = to_string(value.integer);
+        return true;
+    }
+    if (type == BOOLEAN_T) {
+        literal = value.integer != 0 ? "1" : "0";
+        return true;
+    }
+    if (type != FLOAT_T) {
+        return false;
+    }
+    char text[32];
+    snprintf(text, sizeof(text), "%.9g", value.floating == 0 ? 0.0f : value.floating);
+    literal = text;
+    if (literal.find('.') == string::npos) {
+        literal += ".0";
+    }
+    return Quadruple::isNumericLiteral(literal);
+}
+
+string PureCallEvaluationPass::getName() const {
+    return "pure-call-evaluation";
+}
+
+int PureCallEvaluationPass::run(vector<FunctionUnit>& units) {
+    Interpreter program(PassManager::mergeUnits(units));
+    unordered_map<string, size_t> unitOf;
+    for (size_t u = 0; u < units.size(); u++) {
+        if (units[u].isFunction() && program.isPureFunction(units[u].label)) {
+            unitOf[units[u].label] = u;
+        }
+    }
+    pureFunctions += unitOf.size();
+    if (unitOf.empty()) {
+        return 0;
+    }
+
+    // the function and every function it calls, which are pure too, each behind the jump that skips it
+    auto buildProgram = [&](const string& label, vector<Quadruple>& quadruples) {
+        unordered_set<string> seen = {label};
+        deque<string> pending = {label};
+        while (!pending.empty()) {
+            auto unit = unitOf.find(pending.front());
+            pending.pop_front();
+            if (unit == unitOf.end()) {
+                return false;
+            }
+            string skipLabel = "E" + to_string(seen.size()) + ":";
+            quadruples.emplace_back("JMP", "", "", skipLabel);
+            for (const Quadruple& quad : units[unit->second].quadruples) {
+                quadruples.push_back(quad);
+                if (quad.isCall() && seen.insert(quad.getArg1()).second) {
+                    pending.push_back(quad.getArg1());
+                }
+            }
+            quadruples.emplace_back(skipLabel, "", "", "");
+        }
+        return true;
+    };
+    // literal returned for "label(arguments)", empty when the call could not be evaluated
+    unordered_map<string, string> evaluated;
+    auto evaluate = [&](const string& label, const vector<const Quadruple*>& parameters) {
+        string key = label + "(";
+        for (const Quadruple* parameter : parameters) {
+            key += parameter->getArg1() + ",";
+        }
+        auto it = evaluated.find(key);
+        if (it != evaluated.end()) {
+            return it->second;
+        }
+        string& literal = evaluated[key];
+        Function* function = getFunctionByLabel(label);
+        vector<Quadruple> quadruples;
+        if (function == nullptr || !buildProgram(label, quadruples)) {
+            return literal;
+        }
+        for (const Quadruple* parameter : parameters) {
+            quadruples.push_back(*parameter);
+        }
+        // T0 of the global code, temporaries of functions are slots of their frame
+        quadruples.emplace_back("CALL", label, to_string(parameters.size()), "T0");
+        Interpreter call(quadruples);
+        call.setInstructionBudget(evaluationBudget);
+        RuntimeValue value;
+        string formatted;
+        if (call.run() && call.getGlobalValue("T0", value) && formatLiteral(value, function->getType(), formatted)) {
+            literal = formatted;
+        }
+        return literal;
+    };
+
+    int changedUnits = 0;
+    for (FunctionUnit& unit : units) {
+        vector<Quadruple> quadruples;
+        quadruples.reserve(unit.quadruples.size());
+        bool changed = false;
+        for (size_t i = 0; i < unit.quadruples.size(); i++) {
+            const Quadruple& quad = unit.quadruples[i];
+            size_t count = quad.isCall() ? (size_t)atoi(quad.getArg2().c_str()) : 0;
+            bool isCandidate = quad.isCall() && unitOf.count(quad.getArg1()) && count <= i && count <= quadruples.size();
+            vector<const Quadruple*> parameters;
+            for (size_t k = 0; isCandidate && k < count; k++) {
+                const Quadruple& parameter = unit.quadruples[i - count + k];
+                isCandidate = parameter.getOp() == "PARAM" && Quadruple::isNumericLiteral(parameter.getArg1());
+                parameters.push_back(&parameter);
+            }
+            string literal = isCandidate ? evaluate(quad.getArg1(), parameters) : "";
+            if (literal.empty()) {
+                quadruples.push_back(quad);
+                continue;
+            }
+            // the PARAMs were copied just before
+            quadruples.erase(quadruples.end() - count, quadruples.end());
+            if (!quad.getResult().empty()) {
+                quadruples.emplace_back("ASSIGN", literal, "", quad.getResult(), quad.getLine());
+            }
+            evaluatedCalls++;
+            changed = true;
+        }
+        if (changed) {
+            unit.quadruples = quadruples;
+            changedUnits++;
+        }
+    }
+    return changedUnits;
+}
+
+string PureCallEvaluationPass::getSummary() const {
+    return to_string(evaluatedCalls) + " calls of " + to_string(pureFunctions) + " pure functions evaluated";
+}
@@ -1,9 +1,145 @@
 #include "Quadruple.hpp"
 
-Quadruple::Quadruple(const string& op, const string& arg1, const string& arg2, const string& result)
-    : op(op), arg1(arg1), arg2(arg2), result(result) {
+#include <cctype>
+
+Quadruple::Quadruple(const string& op, const string& arg1, const string& arg2, const string& result, int line)
+    : op(op), arg1(arg1), arg2(arg2), result(result), line(line) {
+}
+
+const string& Quadruple::getOp() const {
+    return op;
+}
+
+const string& Quadruple::getArg1() const {
+    return arg1;
+}
+
+const string& Quadruple::getArg2() const {
+    return arg2;
+}
+
+const string& Quadruple::getResult() const {
+    return result;
+}
+
+void Quadruple::setOp(const string& op) {
+    this->op = op;
+}
+
+void Quadruple::setArg1(const string& arg1) {
+    this->arg1 = arg1;
+}
+
+void Quadruple::setArg2(const string& arg2) {
+    this->arg2 = arg2;
+}
+
+void Quadruple::setResult(const string& result) {
+    this->result = result;
+}
+
+int Quadruple::getLine() const {
+    return line;
+}
+
+void Quadruple::setLine(int line) {
+    this->line = line;
+}
+
+bool Quadruple::isLabel() const {
+    return !op.empty() && op.back() == ':';
+}
+
+bool Quadruple::isJump() const {
+    return op == "JMP" || op == "JF" || op == "JT" || op == "RET" || op == "SWITCH" || op == "JTAB";
+}
+
+string Quadruple::getJumpTarget() const {
+    if (!isJump()) {
+        return "";
+    }
+    if (!result.empty()) {
+        return result;
+    }
+    if (!arg1.empty() && arg1.back() == ':') {
+        return arg1;
+    }
+    return "";
+}
+
+bool Quadruple::isCall() const {
+    return op == "CALL" || op == "TAILCALL";
+}
+
+bool Quadruple::isTailCall() const {
+    return op == "TAILCALL";
+}
+
+bool Quadruple::isPureOperation() const {
+    static const char* pureOps[] = {"ADD", "SUB", "MUL", "DIV", "POW", "NEG", "AND", "OR",
+                                    "LT", "GT", "LTE", "GTE", "EQ", "NEQ", "ASSIGN"};
+    for (const char* pureOp : pureOps) {
+        if (op == pureOp) {
+            return true;
+        }
+    }
+    return false;
+}
+
+vector<string> Quadruple::getUsedOperands() const {
+    vector<string> operands;
+    if (isLabel() || isCall() || op == "JMP" || op == "ENTER" || op == "JTAB") {
+        return operands;
+    }
+    if (!arg1.empty() && arg1.back() != ':') {
+        operands.push_back(arg1);
+    }
+    if (!arg2.empty()) {
+        operands.push_back(arg2);
+    }
+    return operands;
+}
+
+bool Quadruple::isTemporary(const string& operand) {
+    if (operand.size() < 2 || operand[0] != 'T') {
+        return false;
+    }
+    for (size_t i = 1; i < operand.size(); i++) {
+        if (!isdigit((unsigned char)operand[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Quadruple::isNumericLiteral(const string& operand) {
+    size_t i = (!operand.empty() && operand[0] == '-') ? 1 : 0;
+    if (i >= operand.size() || !isdigit((unsigned char)operand[i])) {
+        return false;
+    }
+    bool seenDot = false;
+    for (; i < operand.size(); i++) {
+        if (operand[i] == '.' && !seenDot) {
+            seenDot = true;
+        } else if (!isdigit((unsigned char)operand[i])) {
+            return false;
+        }
+    }
+    return operand.back() != '.';
+}
+
+bool Quadruple::isCharLiteral(const string& operand) {
+    return (operand.size() == 3 || operand.size() == 2) && operand.front() == '\'' && operand.back() == '\'';
+}
+
+char Quadruple::getCharLiteralValue(const string& operand) {
+    return operand.size() == 3 ? operand[1] : '\0';
 }
 
 void Quadruple::display(int index, VariadicTable<string, string, string, string, string>& vt) const {
     vt.addRow(to_string(index), op, arg1, arg2, result);
 }
+
+void Quadruple::display(int index, VariadicTable<string, string, string, string, string, string>& vt) const {
+    vt.addRow(to_string(index), line > 0 ? to_string(line) : "", op, arg1, arg2, result);
+}
@@ -3,6 +3,7 @@
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "Vendor/VariadicTable.h"
 
@@ -13,11 +14,47 @@ class Quadruple {
     string arg1;    // First operand
     string arg2;    // Second operand (can be empty for unary ops)
     string result;  // Result variable
+    int line;       // Source line the quadruple was generated for, 0 when unknown
 
    public:
     // Constructor
-    Quadruple(const std::string& op, const std::string& arg1, const std::string& arg2, const std::string& result);
+    Quadruple(const std::string& op, const std::string& arg1, const std::string& arg2, const std::string& result, int line = 0);
+
+    const string& getOp() const;
+    const string& getArg1() const;
+    const string& getArg2() const;
+    const string& getResult() const;
+    void setOp(const string& op);
+    void setArg1(const string& arg1);
+    void setArg2(const string& arg2);
+    void setResult(const string& result);
+    int getLine() const;
+    void setLine(int line);
+
+    // Labels are emitted as a quadruple whose operator is the label itself (e.g. "L3:")
+    bool isLabel() const;
+    // JMP, JF, JT, RET and the SWITCH / JTAB jump table quadruples
+    bool isJump() const;
+    // Label a jump transfers control to: JMP keeps it in arg1 for loops and in result otherwise, empty for RET
+    string getJumpTarget() const;
+    // CALL Lf:, argument count, result - control comes back to the next quadruple
+    // TAILCALL has the same operands and comes before the RET of its result, the callee may return in its place
+    bool isCall() const;
+    bool isTailCall() const;
+    // Operators that only compute a value into result (arithmetic, logical, comparison, ASSIGN)
+    bool isPureOperation() const;
+    // Operands that are read by this quadruple
+    vector<string> getUsedOperands() const;
+
+    // Compiler generated temporaries are named T<n>
+    static bool isTemporary(const string& operand);
+    // Integer or float literal as printed by the parser, optionally negative
+    static bool isNumericLiteral(const string& operand);
+    // Char literal as printed by the parser, in single quotes ('' is the null char)
+    static bool isCharLiteral(const string& operand);
+    static char getCharLiteralValue(const string& operand);
 
     // Display function for debugging
     void display(int index, VariadicTable<string, string, string, string, string>& vt) const;
-};
\ No newline at end of file
+    void display(int index, VariadicTable<string, string, string, string, string, string>& vt) const;
+};
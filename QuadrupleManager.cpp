@@ -1,28 +1,21 @@
 #include "QuadrupleManager.hpp"
 
-#include <string.h>
-
 #include <fstream>
+#include <memory>
 #include <sstream>
 
-#include "SymbolTable.hpp"
+#include "Ast.hpp"
+#include "Pipeline.hpp"
+#include "Profiler.hpp"
 #include "Vendor/VariadicTable.h"
 #include "common.h"
 
-void QuadrupleManager::addQuadruple(const string &op, const string &arg1, const string &arg2, const string &result) {
-    quadruples.emplace_back(op, arg1, arg2, result);
-}
-
-void QuadrupleManager::addQuadruple(const Quadruple &quadruple) {
-    quadruples.push_back(quadruple);
-}
-
-void QuadrupleManager::addQuadrupleInFront(const string &op, const string &arg1, const string &arg2, const string &result) {
-    quadruples.insert(quadruples.begin(), Quadruple(op, arg1, arg2, result));
-}
+// Line the lexer is on, for quadruples added without a line
+extern "C" int yylineno;
 
-void QuadrupleManager::addQuadrupleInFront(const Quadruple &quadruple) {
-    quadruples.insert(quadruples.begin(), quadruple);
+void QuadrupleManager::addQuadruple(const string &op, const string &arg1, const string &arg2, const string &result, int line) {
+    PROFILE_COUNT(COUNTER_QUADS_EMITTED, 1);
+    quadruples.emplace_back(op, arg1, arg2, result, line > 0 ? line : yylineno);
 }
 
 string QuadrupleManager::newTemp() {
@@ -33,28 +26,51 @@ string QuadrupleManager::newLabel() {
     return "L" + std::to_string(labelCount++) + ":";
 }
 
-int QuadrupleManager::generateNewExitLabel() {
-    exitLabel = labelCount++;
-    return exitLabel;
+int QuadrupleManager::reserveTemps(int count) {
+    tempCount += count;
+    return tempCount - count;
 }
 
-int QuadrupleManager::getExitLabel() {
-    return exitLabel;
+int QuadrupleManager::reserveLabels(int count) {
+    labelCount += count;
+    return labelCount - count;
 }
 
-vector<Quadruple> QuadrupleManager::getQuadruples() {
+const vector<Quadruple> &QuadrupleManager::getQuadruples() const {
     return this->quadruples;
 }
 
-void QuadrupleManager::print(ofstream &outFile) {
-    VariadicTable<string, string, string, string, string> vt({"Index", "Op", "Arg1", "Arg2", "Result"});
+Quadruple &QuadrupleManager::getQuadruple(size_t index) {
+    return this->quadruples[index];
+}
 
-    for (size_t i = 0; i < quadruples.size(); ++i) {
-        quadruples[i].display(i, vt);
-    }
+void QuadrupleManager::setQuadruples(const vector<Quadruple> &quadruples) {
+    this->quadruples = quadruples;
+}
+
+size_t QuadrupleManager::size() const {
+    return quadruples.size();
+}
 
+void QuadrupleManager::truncate(size_t size) {
+    quadruples.erase(quadruples.begin() + size, quadruples.end());
+}
+
+void QuadrupleManager::print(ofstream &outFile) {
     std::ostringstream oss;
-    vt.print(oss);
+    if (compilerOptions.lineNumbers) {
+        VariadicTable<string, string, string, string, string, string> vt({"Index", "Line", "Op", "Arg1", "Arg2", "Result"});
+        for (size_t i = 0; i < quadruples.size(); ++i) {
+            quadruples[i].display(i, vt);
+        }
+        vt.print(oss);
+    } else {
+        VariadicTable<string, string, string, string, string> vt({"Index", "Op", "Arg1", "Arg2", "Result"});
+        for (size_t i = 0; i < quadruples.size(); ++i) {
+            quadruples[i].display(i, vt);
+        }
+        vt.print(oss);
+    }
 
     printf("%s", oss.str().c_str());
     outFile << oss.str();
@@ -65,182 +81,112 @@ int QuadrupleManager::labelCount = 0;
 
 static QuadrupleManager mainQuadrupleManager;
 
-vector<QuadrupleManager *> quadrupleManagers = {&mainQuadrupleManager};
-vector<string> caseExpression;
-
-extern "C" {
-
-void addQuadrupleToQuadManager(void *quadManager, const char *op, const char *arg1, const char *arg2, const char *result) {
-    QuadrupleManager *quadManagerPtr = (QuadrupleManager *)quadManager;
-    quadManagerPtr->addQuadruple(op, arg1, arg2, result);
-}
-
-void addQuadrupleToQuadManagerInFront(void *quadManager, const char *op, const char *arg1, const char *arg2, const char *result) {
-    QuadrupleManager *quadManagerPtr = (QuadrupleManager *)quadManager;
-    quadManagerPtr->addQuadrupleInFront(Quadruple(op, arg1, arg2, result));
-}
-
-void addCaseExpression(const char *expr) {
-    caseExpression.push_back(expr);
-}
-
-const char *getCurrentCaseExpression() {
-    return strdup(caseExpression.back().c_str());
-}
-
-void removeLastCaseExpression() {
-    caseExpression.pop_back();
-}
-
-const char *generateNewExitLabelFromCurrentQuadManager() {
-    int labelId = quadrupleManagers.back()->generateNewExitLabel();
-    return strdup(("L" + std::to_string(labelId) + ":").c_str());
+// --stream writes rows as they come, so the columns get fixed widths instead of fitting the widest cell
+static ofstream quadrupleStream;
+static size_t streamedQuadruples = 0;
+static const int streamColumnWidths[] = {5, 4, 6, 8, 8, 8};
+static const char *streamColumnHeaders[] = {"Index", "Line", "Op", "Arg1", "Arg2", "Result"};
+static const int lineColumn = 1;  // only written with --line-numbers
+
+static void writeToQuadrupleStream(const string &text) {
+    printf("%s", text.c_str());
+    quadrupleStream << text;
+    PROFILE_COUNT(COUNTER_BYTES_WRITTEN, text.size());
+}
+
+static string formatStreamRow(const string cells[6]) {
+    ostringstream oss;
+    for (int i = 0; i < 6; i++) {
+        if (i == lineColumn && !compilerOptions.lineNumbers) {
+            continue;
+        }
+        oss << "| " << setw(streamColumnWidths[i]) << left << cells[i] << " ";
+    }
+    oss << "|\n";
+    return oss.str();
 }
 
-const char *getExitLabelFromCurrentQuadManager() {
-    int labelId = quadrupleManagers.back()->getExitLabel();
-    return strdup(("L" + std::to_string(labelId) + ":").c_str());
+static string formatStreamSeparator() {
+    size_t width = 1;
+    for (int i = 0; i < 6; i++) {
+        if (i != lineColumn || compilerOptions.lineNumbers) {
+            width += streamColumnWidths[i] + 3;
+        }
+    }
+    return string(width, '-') + "\n";
 }
 
-void enterQuadManager() {
-    QuadrupleManager *quadManager = new QuadrupleManager();
-    quadrupleManagers.push_back(quadManager);
+QuadrupleManager &getMainQuadrupleManager() {
+    return mainQuadrupleManager;
 }
 
-void *exitQuadManager() {
-    QuadrupleManager *quadManager = quadrupleManagers.back();
-    quadrupleManagers.pop_back();
-    return (void *)quadManager;
+// Writes the quadruples of the statements flushed so far and drops them from memory
+static void streamMainQuadruples() {
+    PROFILE_SCOPE(PHASE_OUTPUT_QUADRUPLES);
+    shared_ptr<vector<Quadruple>> statements = make_shared<vector<Quadruple>>(mainQuadrupleManager.getQuadruples());
+    mainQuadrupleManager.truncate(0);
+    runOnOutputWriter([statements] {
+        string rows;
+        for (const Quadruple &quad : *statements) {
+            string line = quad.getLine() > 0 ? to_string(quad.getLine()) : "";
+            string cells[6] = {to_string(streamedQuadruples++), line, quad.getOp(), quad.getArg1(), quad.getArg2(), quad.getResult()};
+            rows += formatStreamRow(cells);
+        }
+        writeToQuadrupleStream(rows);
+    });
 }
 
-void addQuadrupleToCurrentQuadManager(const char *op, const char *arg1, const char *arg2, const char *result) {
-    quadrupleManagers.back()->addQuadruple(op, arg1, arg2, result);
-}
+extern "C" {
 
-void mergeQuadManagerToCurrentQuadManager(void *quadManager) {
-    QuadrupleManager *quadManagerPtr = (QuadrupleManager *)quadManager;
-    QuadrupleManager *prevQuadManager = quadrupleManagers.back();
-    for (auto quad : quadManagerPtr->getQuadruples()) {
-        prevQuadManager->addQuadruple(quad);
-    }
+void addQuadruple(const char *op, const char *arg1, const char *arg2, const char *result) {
+    mainQuadrupleManager.addQuadruple(op, arg1, arg2, result);
 }
 
-void mergeQuadManagerToCurrentQuadManagerInFront(void *quadManager) {
-    QuadrupleManager *quadManagerPtr = (QuadrupleManager *)quadManager;
-    QuadrupleManager *prevQuadManager = quadrupleManagers.back();
-    // reverse iterate
-    vector<Quadruple> quads = quadManagerPtr->getQuadruples();
-    for (auto it = quads.rbegin(); it != quads.rend(); ++it) {
-        prevQuadManager->addQuadrupleInFront(*it);
-    }
+void beginQuadrupleStream(const char *inputFileName) {
+    PROFILE_SCOPE(PHASE_OUTPUT_QUADRUPLES);
+    runOnOutputWriter([inputFileName] {
+        const char *outputFileName = getOutputFileName(inputFileName, "_quadruples.txt");
+        quadrupleStream.open(outputFileName, ios::out);
+        string headers[6];
+        for (int i = 0; i < 6; i++) {
+            headers[i] = streamColumnHeaders[i];
+        }
+        writeToQuadrupleStream(formatStreamSeparator() + formatStreamRow(headers) + formatStreamSeparator());
+    });
 }
 
-void handleFunctionQuadruples(void *quadManager, void *function) {
-    QuadrupleManager *quadManagerPtr = (QuadrupleManager *)quadManager;
-    Function *func = (Function *)function;
-    vector<Variable *> *arguments = func->getArguments();
-    for (auto arg : *arguments) {
-        string argName = arg->getName();
-        quadManagerPtr->addQuadrupleInFront("POP", "", "", argName);
+// Called after every statement, only acts once a top level statement is complete
+void flushStatementQuadruples() {
+    if (!lowerTopLevelStatements()) {
+        return;
     }
-
-    string returnLabel = "ret_" + func->getLabel();
-    quadManagerPtr->addQuadrupleInFront("POP", "", "", returnLabel);
-    string returnLabelContent = "content(" + string(returnLabel) + ")";
-    quadManagerPtr->addQuadruple("JMP", returnLabelContent, "", "");
-}
-
-void handleFunctionReturnQuadruples() {
-    Function *function = FunctionContextSingleton::getCurrentFunction();
-    string returnLabel = "ret_" + function->getLabel();
-    string returnLabelContent = "content(" + string(returnLabel) + ")";
-    addQuadrupleToCurrentQuadManager("JMP", returnLabelContent.c_str(), "", "");
-}
-
-void handleFunctionReturnWithExprQuadruples(const char *expr) {
-    addQuadrupleToCurrentQuadManager("PUSH", expr, "", "");
-    handleFunctionReturnQuadruples();
-}
-
-void handleFunctionCallQuadruples(void *function, void *paramList, const char *returnVar) {
-    Function *func = (Function *)function;
-    vector<Parameter> *params = (vector<Parameter> *)paramList;
-    vector<Variable *> *arguments = func->getArguments();
-    const char *returnLabel = newLabel();
-    for (int i = 0; i < params->size(); i++) {
-        addQuadrupleToCurrentQuadManager("PUSH", params->at(i).name.c_str(), "", "");
+    if (!compilerOptions.stream) {
+        return;
     }
-    addQuadrupleToCurrentQuadManager("PUSH", returnLabel, "", "");
-    addQuadrupleToCurrentQuadManager("JMP", func->getLabel().c_str(), "", "");
-
-    addQuadrupleToCurrentQuadManager(returnLabel, "", "", "");
-    if (func->getType() != VOID_T) {
-        addQuadrupleToCurrentQuadManager("POP", "", "", returnVar);
+    if (compilerOptions.optimize) {
+        optimizeQuadruples();
     }
+    streamMainQuadruples();
 }
 
-void handleForLoopQuadruples(const char *booleanExprVar, void *booleanExprQuadManager, void *assignmentQuadManager, void *scopeQuadManager) {
-    QuadrupleManager *booleanExprQuadManagerPtr = (QuadrupleManager *)booleanExprQuadManager;
-    QuadrupleManager *assignmentQuadManagerPtr = (QuadrupleManager *)assignmentQuadManager;
-    QuadrupleManager *scopeQuadManagerPtr = (QuadrupleManager *)scopeQuadManager;
-
-    string forLabel = newLabel();
-    string endForLabel = newLabel();
-    addQuadrupleToCurrentQuadManager(forLabel.c_str(), "", "", "");
-    mergeQuadManagerToCurrentQuadManager(booleanExprQuadManagerPtr);
-    addQuadrupleToCurrentQuadManager("JF", booleanExprVar, "", endForLabel.c_str());
-    mergeQuadManagerToCurrentQuadManager(scopeQuadManagerPtr);
-    mergeQuadManagerToCurrentQuadManager(assignmentQuadManagerPtr);
-    addQuadrupleToCurrentQuadManager("JMP", forLabel.c_str(), "", "");
-    addQuadrupleToCurrentQuadManager(endForLabel.c_str(), "", "", "");
-}
-
-void handleRepeatUntilQuadruples(const char *booleanExprVar, void *booleanExprQuadManager, void *scopeQuadManager) {
-    QuadrupleManager *booleanExprQuadManagerPtr = (QuadrupleManager *)booleanExprQuadManager;
-    QuadrupleManager *scopeQuadManagerPtr = (QuadrupleManager *)scopeQuadManager;
-
-    string repeatLabel = newLabel();
-    string endLabel = newLabel();
-
-    addQuadrupleToCurrentQuadManager(repeatLabel.c_str(), "", "", "");
-    mergeQuadManagerToCurrentQuadManager(scopeQuadManagerPtr);
-    mergeQuadManagerToCurrentQuadManager(booleanExprQuadManagerPtr);
-    addQuadrupleToCurrentQuadManager("JF", booleanExprVar, "", endLabel.c_str());
-    addQuadrupleToCurrentQuadManager("JMP", repeatLabel.c_str(), "", "");
-    addQuadrupleToCurrentQuadManager(endLabel.c_str(), "", "", "");
-}
-
-void handleWhileQuadruples(const char *booleanExprVar, void *booleanExprQuadManager, void *scopeQuadManager) {
-    QuadrupleManager *booleanExprQuadManagerPtr = (QuadrupleManager *)booleanExprQuadManager;
-    QuadrupleManager *scopeQuadManagerPtr = (QuadrupleManager *)scopeQuadManager;
-
-    string whileLabel = newLabel();
-    string endLabel = newLabel();
-
-    addQuadrupleToCurrentQuadManager(whileLabel.c_str(), "", "", "");
-    mergeQuadManagerToCurrentQuadManager(booleanExprQuadManagerPtr);
-    addQuadrupleToCurrentQuadManager("JF", booleanExprVar, "", endLabel.c_str());
-    mergeQuadManagerToCurrentQuadManager(scopeQuadManagerPtr);
-    addQuadrupleToCurrentQuadManager("JMP", whileLabel.c_str(), "", "");
-    addQuadrupleToCurrentQuadManager(endLabel.c_str(), "", "", "");
-}
-
-void addQuadruple(const char *op, const char *arg1, const char *arg2, const char *result) {
-    mainQuadrupleManager.addQuadruple(op, arg1, arg2, result);
-}
-
-const char *newTemp() {
-    return strdup(mainQuadrupleManager.newTemp().c_str());
-}
-
-const char *newLabel() {
-    return strdup(mainQuadrupleManager.newLabel().c_str());
+// What --stream wrote before a semantic error, when the compiler exits without running static destructors
+void flushQuadrupleStream() {
+    quadrupleStream.flush();
 }
 
 void printQuadruples(const char *inputFileName) {
-    const char *outputFileName = getOutputFileName(inputFileName, "_quadruples.txt");
-    ofstream outFile = ofstream(outputFileName, ios::out);
-    mainQuadrupleManager.print(outFile);
-    outFile.close();
+    PROFILE_SCOPE(PHASE_OUTPUT_QUADRUPLES);
+    runOnOutputWriter([inputFileName] {
+        if (compilerOptions.stream) {
+            writeToQuadrupleStream(formatStreamSeparator());
+            quadrupleStream.close();
+            return;
+        }
+        const char *outputFileName = getOutputFileName(inputFileName, "_quadruples.txt");
+        ofstream outFile = ofstream(outputFileName, ios::out);
+        mainQuadrupleManager.print(outFile);
+        PROFILE_COUNT(COUNTER_BYTES_WRITTEN, outFile.tellp());
+        outFile.close();
+    });
 }
 }
@@ -11,29 +11,33 @@ using namespace std;
 class QuadrupleManager {
    private:
     vector<Quadruple> quadruples;  // Stores all quadruples
-    int exitLabel;
 
     static int tempCount;   // Counter for temporary variables
     static int labelCount;  // Counter for labels
    public:
-    // Add a new quadruple
-    void addQuadruple(const string& op, const string& arg1, const string& arg2, const string& result);
+    // Add a new quadruple, tagged with the line being parsed unless line is given
+    void addQuadruple(const string& op, const string& arg1, const string& arg2, const string& result, int line = 0);
 
-    void addQuadruple(const Quadruple& quadruple);
     // Generate a new temporary variable
     string newTemp();
 
-    void addQuadrupleInFront(const string& op, const string& arg1, const string& arg2, const string& result);
-    void addQuadrupleInFront(const Quadruple& quadruple);
-
     // Generate a new label
     string newLabel();
 
-    int generateNewExitLabel();
-    int getExitLabel();
+    // Numbers of count new temporaries (labels) in a row, returns the first one
+    int reserveTemps(int count);
+    int reserveLabels(int count);
 
-    vector<Quadruple> getQuadruples();
+    const vector<Quadruple>& getQuadruples() const;
+    Quadruple& getQuadruple(size_t index);
+    void setQuadruples(const vector<Quadruple>& quadruples);
+    size_t size() const;
+    // Drop every quadruple from index size onwards
+    void truncate(size_t size);
 
     // Display all quadruples
     void print(ofstream& outFile);
 };
+
+// The manager holding the final program once parsing is done
+QuadrupleManager& getMainQuadrupleManager();
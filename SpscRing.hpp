@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Bounded FIFO between exactly one producer thread and one consumer thread. Each index is only written by
+// one side, so push and pop need no lock: the release store of an index publishes the slots before it.
+// A full or an empty ring yields a few times, then sleeps, so a waiting side does not take the core from
+// the other one when they share it.
+template <typename T>
+class SpscRing {
+   private:
+    vector<T> slots;
+    size_t mask;
+    alignas(64) atomic<size_t> head;  // next slot to pop, written by the consumer
+    alignas(64) atomic<size_t> tail;  // next slot to push, written by the producer
+
+    static void backOff(int& attempts) {
+        if (++attempts < 64) {
+            this_thread::yield();
+        } else {
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+    }
+
+   public:
+    // The capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) : head(0), tail(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    void push(const T& value) {
+        size_t position = tail.load(memory_order_relaxed);
+        for (int attempts = 0; position - head.load(memory_order_acquire) == slots.size();) {
+            backOff(attempts);
+        }
+        slots[position & mask] = value;
+        tail.store(position + 1, memory_order_release);
+    }
+
+    T pop() {
+        size_t position = head.load(memory_order_relaxed);
+        for (int attempts = 0; tail.load(memory_order_acquire) == position;) {
+            backOff(attempts);
+        }
+        T value = slots[position & mask];
+        head.store(position + 1, memory_order_release);
+        return value;
+    }
+};
@@ -0,0 +1,352 @@
+#include "SsaForm.hpp"
+
+#include <algorithm>
+
+SsaForm::SsaForm(const vector<Quadruple>& quadruples, const function<bool(const string&)>& isTracked) : quadruples(quadruples) {
+    for (const Quadruple& quad : quadruples) {
+        const string* operands[] = {&quad.getArg1(), &quad.getArg2()};
+        for (int position = 0; position < 2; position++) {
+            if (readsOperand(quad, position) && isTracked(*operands[position]) && !variableOf.count(*operands[position])) {
+                variableOf[*operands[position]] = variables.size();
+                variables.push_back(*operands[position]);
+            }
+        }
+        if (writesResult(quad) && isTracked(quad.getResult()) && !variableOf.count(quad.getResult())) {
+            variableOf[quad.getResult()] = variables.size();
+            variables.push_back(quad.getResult());
+        }
+    }
+
+    buildBlocks();
+    computeDominators();
+    placePhis();
+    rename();
+}
+
+bool SsaForm::readsOperand(const Quadruple& quad, int position) {
+    if (quad.isLabel() || quad.isCall() || quad.getOp() == "JMP" || quad.getOp() == "ENTER" || quad.getOp() == "JTAB") {
+        return false;
+    }
+    const string& operand = position == 0 ? quad.getArg1() : quad.getArg2();
+    return !operand.empty() && operand.back() != ':';
+}
+
+bool SsaForm::writesResult(const Quadruple& quad) {
+    return (quad.isPureOperation() || quad.isCall()) && !quad.getResult().empty();
+}
+
+int SsaForm::getVariable(const string& name) const {
+    auto it = variableOf.find(name);
+    return it == variableOf.end() ? -1 : it->second;
+}
+
+void SsaForm::buildBlocks() {
+    size_t count = quadruples.size();
+    blocks.push_back(SsaBlock());  // entry
+    blockOf.assign(count, -1);
+
+    for (size_t i = 0; i < count; i++) {
+        const Quadruple& quad = quadruples[i];
+        bool startsBlock = i == 0 || quad.isLabel();
+        // a jump ends its block, except that SWITCH keeps its JTAB entries
+        if (i > 0 && quadruples[i - 1].isJump() && quad.getOp() != "JTAB") {
+            startsBlock = true;
+        }
+        if (startsBlock) {
+            if (blocks.size() > 1) {
+                blocks.back().end = i;
+            }
+            SsaBlock block;
+            block.begin = i;
+            blocks.push_back(block);
+        }
+        blockOf[i] = blocks.size() - 1;
+        if (quad.isLabel()) {
+            blockOfLabel[quad.getOp()] = blocks.size() - 1;
+        }
+    }
+    if (blocks.size() > 1) {
+        blocks.back().end = count;
+    }
+
+    for (size_t b = 0; b < blocks.size(); b++) {
+        vector<int>& successors = blocks[b].successors;
+        bool fallsThrough = true;
+        if (b > 0) {
+            for (size_t i = blocks[b].begin; i < blocks[b].end; i++) {
+                const Quadruple& quad = quadruples[i];
+                if (!quad.isJump()) {
+                    continue;
+                }
+                auto target = blockOfLabel.find(quad.getJumpTarget());
+                if (target != blockOfLabel.end()) {
+                    successors.push_back(target->second);
+                }
+                // targets outside of the unit (the jump over a function) leave it
+                fallsThrough = quad.getOp() == "JF" || quad.getOp() == "JT";
+            }
+        }
+        if (fallsThrough && b + 1 < blocks.size()) {
+            successors.push_back(b + 1);
+        }
+        sort(successors.begin(), successors.end());
+        successors.erase(unique(successors.begin(), successors.end()), successors.end());
+    }
+}
+
+void SsaForm::computeDominators() {
+    // depth first order from the entry, reversed
+    vector<int> postorder;
+    vector<size_t> nextSuccessor(blocks.size(), 0);
+    vector<int> stack = {0};
+    blocks[0].isReachable = true;
+    while (!stack.empty()) {
+        int block = stack.back();
+        if (nextSuccessor[block] < blocks[block].successors.size()) {
+            int successor = blocks[block].successors[nextSuccessor[block]++];
+            if (!blocks[successor].isReachable) {
+                blocks[successor].isReachable = true;
+                stack.push_back(successor);
+            }
+        } else {
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+    }
+    reversePostorder.assign(postorder.rbegin(), postorder.rend());
+
+    for (size_t b = 0; b < blocks.size(); b++) {
+        if (!blocks[b].isReachable) {
+            continue;
+        }
+        for (int successor : blocks[b].successors) {
+            blocks[successor].predecessors.push_back(b);
+        }
+    }
+
+    // Cooper, Harvey and Kennedy: iterate intersections of the predecessors' dominators in reverse postorder
+    vector<int> orderOf(blocks.size(), -1);
+    for (size_t i = 0; i < reversePostorder.size(); i++) {
+        orderOf[reversePostorder[i]] = i;
+    }
+    vector<int> dominator(blocks.size(), -1);
+    dominator[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < reversePostorder.size(); i++) {
+            int block = reversePostorder[i];
+            int newDominator = -1;
+            for (int predecessor : blocks[block].predecessors) {
+                if (dominator[predecessor] == -1) {
+                    continue;
+                }
+                if (newDominator == -1) {
+                    newDominator = predecessor;
+                    continue;
+                }
+                int a = predecessor, b = newDominator;
+                while (a != b) {
+                    while (orderOf[a] > orderOf[b]) {
+                        a = dominator[a];
+                    }
+                    while (orderOf[b] > orderOf[a]) {
+                        b = dominator[b];
+                    }
+                }
+                newDominator = a;
+            }
+            if (dominator[block] != newDominator) {
+                dominator[block] = newDominator;
+                changed = true;
+            }
+        }
+    }
+
+    for (size_t i = 1; i < reversePostorder.size(); i++) {
+        int block = reversePostorder[i];
+        blocks[block].immediateDominator = dominator[block];
+        blocks[dominator[block]].dominatorChildren.push_back(block);
+    }
+}
+
+void SsaForm::placePhis() {
+    size_t variableCount = variables.size();
+    // blocks that define each variable, and whether the variable is read before it is written in a block
+    vector<vector<int>> definingBlocks(variableCount);
+    vector<bool> isLiveAcrossBlocks(variableCount, false);
+    vector<int> writtenInBlock(variableCount, -1);
+    for (int block : reversePostorder) {
+        for (size_t i = blocks[block].begin; i < blocks[block].end; i++) {
+            const Quadruple& quad = quadruples[i];
+            const string* operands[] = {&quad.getArg1(), &quad.getArg2()};
+            for (int position = 0; position < 2; position++) {
+                int variable = readsOperand(quad, position) ? getVariable(*operands[position]) : -1;
+                if (variable >= 0 && writtenInBlock[variable] != block) {
+                    isLiveAcrossBlocks[variable] = true;
+                }
+            }
+            int variable = writesResult(quad) ? getVariable(quad.getResult()) : -1;
+            if (variable >= 0 && writtenInBlock[variable] != block) {
+                writtenInBlock[variable] = block;
+                definingBlocks[variable].push_back(block);
+            }
+        }
+    }
+
+    // dominance frontiers
+    vector<vector<int>> frontiers(blocks.size());
+    for (int block : reversePostorder) {
+        const vector<int>& predecessors = blocks[block].predecessors;
+        if (predecessors.size() < 2) {
+            continue;
+        }
+        for (int predecessor : predecessors) {
+            int runner = predecessor;
+            while (runner != blocks[block].immediateDominator && runner != -1) {
+                vector<int>& frontier = frontiers[runner];
+                if (frontier.empty() || frontier.back() != block) {
+                    frontier.push_back(block);
+                }
+                runner = blocks[runner].immediateDominator;
+            }
+        }
+    }
+
+    // stamps of the last variable that got a phi in / was queued for each block
+    vector<int> hasPhi(blocks.size(), -1);
+    vector<int> queued(blocks.size(), -1);
+    for (size_t variable = 0; variable < variableCount; variable++) {
+        if (!isLiveAcrossBlocks[variable]) {
+            continue;
+        }
+        vector<int> worklist = definingBlocks[variable];
+        for (int block : worklist) {
+            queued[block] = variable;
+        }
+        while (!worklist.empty()) {
+            int block = worklist.back();
+            worklist.pop_back();
+            for (int frontier : frontiers[block]) {
+                if (hasPhi[frontier] == (int)variable) {
+                    continue;
+                }
+                hasPhi[frontier] = variable;
+                SsaValue phi;
+                phi.variable = variable;
+                phi.phiBlock = frontier;
+                phi.phiOperands.assign(blocks[frontier].predecessors.size(), -1);
+                blocks[frontier].phis.push_back(values.size());
+                values.push_back(phi);
+                if (queued[frontier] != (int)variable) {
+                    queued[frontier] = variable;
+                    worklist.push_back(frontier);
+                }
+            }
+        }
+    }
+}
+
+void SsaForm::rename() {
+    definedValues.assign(quadruples.size(), -1);
+    usedValues[0].assign(quadruples.size(), -1);
+    usedValues[1].assign(quadruples.size(), -1);
+
+    vector<vector<int>> current(variables.size());
+    for (size_t variable = 0; variable < variables.size(); variable++) {
+        SsaValue entry;
+        entry.variable = variable;
+        entryValues.push_back(values.size());
+        current[variable].push_back(values.size());
+        values.push_back(entry);
+    }
+
+    // walk the dominator tree without recursion, a long chain of blocks would overflow the stack
+    vector<int> pushed;
+    vector<pair<int, size_t>> stack = {{0, 0}};
+    vector<size_t> pushedBefore(blocks.size(), 0);
+    while (!stack.empty()) {
+        int block = stack.back().first;
+        size_t child = stack.back().second++;
+        if (child == 0) {
+            pushedBefore[block] = pushed.size();
+            for (int phi : blocks[block].phis) {
+                current[values[phi].variable].push_back(phi);
+                pushed.push_back(values[phi].variable);
+            }
+            for (size_t i = blocks[block].begin; i < blocks[block].end; i++) {
+                const Quadruple& quad = quadruples[i];
+                const string* operands[] = {&quad.getArg1(), &quad.getArg2()};
+                for (int position = 0; position < 2; position++) {
+                    int variable = readsOperand(quad, position) ? getVariable(*operands[position]) : -1;
+                    if (variable >= 0) {
+                        usedValues[position][i] = current[variable].back();
+                    }
+                }
+                int variable = writesResult(quad) ? getVariable(quad.getResult()) : -1;
+                if (variable >= 0) {
+                    SsaValue value;
+                    value.variable = variable;
+                    value.quadruple = i;
+                    definedValues[i] = values.size();
+                    current[variable].push_back(values.size());
+                    pushed.push_back(variable);
+                    values.push_back(value);
+                }
+            }
+            for (int successor : blocks[block].successors) {
+                const vector<int>& predecessors = blocks[successor].predecessors;
+                size_t edge = find(predecessors.begin(), predecessors.end(), block) - predecessors.begin();
+                for (int phi : blocks[successor].phis) {
+                    values[phi].phiOperands[edge] = current[values[phi].variable].back();
+                }
+            }
+        }
+        if (child < blocks[block].dominatorChildren.size()) {
+            stack.push_back({blocks[block].dominatorChildren[child], 0});
+            continue;
+        }
+        while (pushed.size() > pushedBefore[block]) {
+            current[pushed.back()].pop_back();
+            pushed.pop_back();
+        }
+        stack.pop_back();
+    }
+}
+
+const vector<SsaBlock>& SsaForm::getBlocks() const {
+    return blocks;
+}
+
+int SsaForm::getBlockOf(size_t quadruple) const {
+    return blockOf[quadruple];
+}
+
+int SsaForm::getJumpTargetBlock(size_t quadruple) const {
+    auto it = blockOfLabel.find(quadruples[quadruple].getJumpTarget());
+    return it == blockOfLabel.end() ? -1 : it->second;
+}
+
+const vector<int>& SsaForm::getReversePostorder() const {
+    return reversePostorder;
+}
+
+const vector<string>& SsaForm::getVariables() const {
+    return variables;
+}
+
+const vector<SsaValue>& SsaForm::getValues() const {
+    return values;
+}
+
+int SsaForm::getEntryValue(int variable) const {
+    return entryValues[variable];
+}
+
+int SsaForm::getDefinedValue(size_t quadruple) const {
+    return definedValues[quadruple];
+}
+
+int SsaForm::getUsedValue(size_t quadruple, int position) const {
+    return usedValues[position][quadruple];
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include "Quadruple.hpp"
+
+struct SsaBlock {
+    size_t begin = 0;  // first quadruple of the block
+    size_t end = 0;    // one past its last quadruple
+    vector<int> predecessors;  // reachable predecessors only
+    vector<int> successors;
+    int immediateDominator = -1;  // -1 for the entry and for unreachable blocks
+    vector<int> dominatorChildren;
+    vector<int> phis;  // values defined by the phi functions at the top of the block
+    bool isReachable = false;
+};
+
+struct SsaValue {
+    int variable;            // index into SsaForm::getVariables()
+    int quadruple = -1;      // defining quadruple, -1 for phis and for the value a variable has on entry
+    int phiBlock = -1;       // block of the defining phi, -1 for other values
+    vector<int> phiOperands;  // value coming from each predecessor of phiBlock, -1 until it is known
+};
+
+// Static single assignment view of the quadruples of one unit. Every definition of a tracked variable is
+// a value of its own, and phis are placed at the dominance frontiers of the definitions (semi pruned: only
+// for variables read in some block before being written there). Block 0 is an empty entry block that
+// defines the value of every variable on entry. A name declared again in a sibling scope reuses its
+// frame slot, but each of its declarations still starts a value of its own.
+//
+// The quadruples keep their names: a pass reads the values and then rewrites the original operands, which
+// is the same as leaving SSA by dropping the versions as long as it only substitutes constants, or names
+// with a single definition that dominates the use.
+class SsaForm {
+   private:
+    const vector<Quadruple>& quadruples;
+    vector<SsaBlock> blocks;
+    vector<int> blockOf;
+    unordered_map<string, int> blockOfLabel;
+    vector<int> reversePostorder;
+    vector<string> variables;
+    unordered_map<string, int> variableOf;
+    vector<SsaValue> values;
+    vector<int> entryValues;
+    vector<int> definedValues;
+    vector<int> usedValues[2];
+
+    void buildBlocks();
+    void computeDominators();
+    void placePhis();
+    void rename();
+    int getVariable(const string& name) const;
+
+   public:
+    // isTracked selects the names that can only change through the quadruples of the unit
+    SsaForm(const vector<Quadruple>& quadruples, const function<bool(const string&)>& isTracked);
+
+    const vector<SsaBlock>& getBlocks() const;
+    int getBlockOf(size_t quadruple) const;
+    // Block of the label a jump quadruple goes to, -1 if the label is not in the unit
+    int getJumpTargetBlock(size_t quadruple) const;
+    // Reachable blocks, each after all of its dominators
+    const vector<int>& getReversePostorder() const;
+    const vector<string>& getVariables() const;
+    const vector<SsaValue>& getValues() const;
+    int getEntryValue(int variable) const;
+    // Value written by a quadruple, -1 if it does not write a tracked variable or is unreachable
+    int getDefinedValue(size_t quadruple) const;
+    // Value read through arg1 (position 0) or arg2 (position 1), -1 if that operand is not a tracked variable
+    int getUsedValue(size_t quadruple, int position) const;
+
+    // Whether position (0 for arg1, 1 for arg2) of the quadruple is read as a value
+    static bool readsOperand(const Quadruple& quad, int position);
+    // Whether the quadruple writes its result as a value (pure operations and calls)
+    static bool writesResult(const Quadruple& quad);
+};
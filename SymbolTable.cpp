@@ -6,6 +6,8 @@
 #include <sstream>
 #include <unordered_set>
 
+#include "Pipeline.hpp"
+#include "Profiler.hpp"
 #include "Vendor/VariadicTable.h"
 #include "common.h"
 static string getTypeName(Type type);
@@ -72,6 +74,14 @@ void Variable::setIsFuncArg(bool isFuncArg) {
     this->isFuncArg = isFuncArg;
 }
 
+bool Variable::getIsDeclaredWithoutValue() {
+    return this->isDeclaredWithoutValue;
+}
+
+void Variable::setIsDeclaredWithoutValue(bool isDeclaredWithoutValue) {
+    this->isDeclaredWithoutValue = isDeclaredWithoutValue;
+}
+
 Function::Function(string name, Type returnType, vector<Variable*>* arguments, int line) : Symbol(name, returnType, line) {
     this->arguments = arguments;
 }
@@ -105,6 +115,44 @@ string Function::getLabel() {
     return this->label;
 }
 
+void Function::setScope(SymbolTable* scope) {
+    this->scope = scope;
+}
+
+SymbolTable* Function::getScope() {
+    return this->scope;
+}
+
+int Function::addFrameSlot(const string& name) {
+    auto it = this->frameSlotOf.find(name);
+    if (it != this->frameSlotOf.end()) {
+        return it->second;
+    }
+    int slot = this->frameSlots.size();
+    this->frameSlots.push_back(name);
+    this->frameSlotOf[name] = slot;
+    return slot;
+}
+
+int Function::getFrameSlot(const string& name) {
+    auto it = this->frameSlotOf.find(name);
+    return it == this->frameSlotOf.end() ? -1 : it->second;
+}
+
+const vector<string>& Function::getFrameSlots() {
+    return this->frameSlots;
+}
+
+void Function::printFrame(ostream& out) {
+    VariadicTable<string, string> vt({"Slot", "Name"});
+    for (size_t slot = 0; slot < this->frameSlots.size(); slot++) {
+        vt.addRow(to_string(slot), this->frameSlots[slot]);
+    }
+    out << "------ Frame of " << this->getName() << " (" << this->label << ") ------\n";
+    vt.print(out);
+    out << "\n";
+}
+
 int SymbolTable::symbolTableIdCnt = 0;
 
 SymbolTable::SymbolTable() {
@@ -126,8 +174,10 @@ void SymbolTable::insert(Symbol* symbol) {
 }
 
 Symbol* SymbolTable::lookup(string name) {
+    PROFILE_COUNT(COUNTER_SYMBOL_LOOKUPS, 1);
     SymbolTable* current = this;
     while (current != nullptr) {
+        PROFILE_COUNT(COUNTER_SCOPES_SEARCHED, 1);
         auto it = current->symbols.find(name);
         if (it != current->symbols.end()) {
             return it->second;
@@ -146,6 +196,47 @@ SymbolTable* SymbolTable::createChild() {
     return children.back();
 }
 
+Function* SymbolTable::getFunction() {
+    return this->function;
+}
+
+void SymbolTable::setFunction(Function* function) {
+    this->function = function;
+}
+
+void SymbolTable::collectFrameVariables(vector<Variable*>& variables) {
+    vector<Variable*> own;
+    for (auto it = this->symbols.begin(); it != this->symbols.end(); ++it) {
+        Variable* variable = dynamic_cast<Variable*>(it->second);
+        if (variable != nullptr) {
+            own.push_back(variable);
+        }
+    }
+    // symbols are hashed, sort them so slots do not depend on the hash order
+    sort(own.begin(), own.end(), [](Variable* a, Variable* b) {
+        return a->getLine() != b->getLine() ? a->getLine() < b->getLine() : a->getName() < b->getName();
+    });
+    variables.insert(variables.end(), own.begin(), own.end());
+
+    for (SymbolTable* child : this->children) {
+        if (child->getFunction() == nullptr) {
+            child->collectFrameVariables(variables);
+        }
+    }
+}
+
+void SymbolTable::collectVariables(vector<Variable*>& variables) {
+    for (auto it = this->symbols.begin(); it != this->symbols.end(); ++it) {
+        Variable* variable = dynamic_cast<Variable*>(it->second);
+        if (variable != nullptr) {
+            variables.push_back(variable);
+        }
+    }
+    for (SymbolTable* child : this->children) {
+        child->collectVariables(variables);
+    }
+}
+
 void SymbolTable::print(ofstream& outFile) {
     VariadicTable<string, string, string, string> vt({"Name", "Kind", "Type", "Other"});
     for (auto it = this->symbols.begin(); it != this->symbols.end(); ++it) {
@@ -200,12 +291,67 @@ vector<Symbol*> SymbolTable::getUnusedSymbols() {
 
 static SymbolTable globalSymbolTable;
 static SymbolTable* currentSymbolTable = &globalSymbolTable;
+// every function in definition order, for printing their frames
+static vector<Function*> functions;
+static int scopeDepth = 0;
 static string getTypeName(Type type);
 
-struct SwitchCaseMetadata {
-    Type type;
-    int line;
-};
+Function* getFunctionByLabel(const string& label) {
+    for (Function* function : functions) {
+        if (function->getLabel() == label) {
+            return function;
+        }
+    }
+    return nullptr;
+}
+
+vector<Variable*> getGlobalVariables() {
+    vector<Variable*> variables;
+    globalSymbolTable.collectFrameVariables(variables);
+    return variables;
+}
+
+vector<Variable*> getAllVariables() {
+    vector<Variable*> variables;
+    globalSymbolTable.collectVariables(variables);
+    return variables;
+}
+
+const vector<Function*>& getFunctions() {
+    return functions;
+}
+
+bool isGlobalScope() {
+    return currentSymbolTable == &globalSymbolTable;
+}
+
+bool isDeclaredInGlobalScope(Symbol* symbol) {
+    return globalSymbolTable.lookup(symbol->getName()) == symbol;
+}
+
+void addImportedFunction(Function* function, const vector<Variable*>& variables, bool exported, int line) {
+    function->setIsUsed(true);
+    if (exported) {
+        try {
+            globalSymbolTable.insert(function);
+        } catch (string e) {
+            exitOnError(e.c_str(), line);
+        }
+    }
+    functions.push_back(function);
+
+    SymbolTable* scope = globalSymbolTable.createChild();
+    scope->setFunction(function);
+    function->setScope(scope);
+    for (Variable* variable : variables) {
+        variable->setIsUsed(true);
+        try {
+            scope->insert(variable);
+        } catch (string e) {
+            // a name of a nested scope of the module or a global of the program, the frame has a slot for it anyway
+        }
+    }
+}
 
 extern "C" {
 static void pushFunctionArgumentListIfExistsToScopeSymbolTable() {
@@ -218,6 +364,8 @@ static void pushFunctionArgumentListIfExistsToScopeSymbolTable() {
     if (functionMetadata.isFunctionConsumedInScopeCheck) {
         return;
     }
+    currentSymbolTable->setFunction(functionMetadata.function);
+    functionMetadata.function->setScope(currentSymbolTable);
     for (auto arg : *functionMetadata.function->getArguments()) {
         try {
             Variable* var = new Variable(arg->getType(), arg->getName(), arg->getLine(), arg->getIsConstant(), false, true);
@@ -271,20 +419,26 @@ void checkReturnStatementIsValid(Type returnType, int line) {
 }
 
 void enterScope() {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     currentSymbolTable = currentSymbolTable->createChild();
+    scopeDepth++;
+    PROFILE_MAX(COUNTER_MAX_SCOPE_DEPTH, scopeDepth);
     pushFunctionArgumentListIfExistsToScopeSymbolTable();
 }
 
 void exitScope(int line) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     SymbolTable* parent = currentSymbolTable->getParent();
     if (parent == nullptr) {
         exitOnError("Cannot exit global scope", line);
     }
     popFunctionArgumentListIfExists();
     currentSymbolTable = parent;
+    scopeDepth--;
 }
 
 void addSymbolToSymbolTable(void* symbol) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     Symbol* var = (Symbol*)symbol;
     try {
         currentSymbolTable->insert(var);
@@ -294,14 +448,15 @@ void addSymbolToSymbolTable(void* symbol) {
 }
 
 void* createVariable(Type type, const char* name, int line, int isConstant) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     Variable* variable = new Variable(type, name, line, isConstant);
     return (void*)variable;
 }
 
 void* createFunction(Type returnType, const char* name, void* argumentList, int line) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     vector<FunctionMetadata>& functionContext = FunctionContextSingleton::getFunctionContext();
     vector<Variable*>* arguments = (vector<Variable*>*)argumentList;
-    reverse(arguments->begin(), arguments->end());
 
     for (auto arg : *arguments) {
         arg->setIsFuncArg(true);
@@ -309,6 +464,7 @@ void* createFunction(Type returnType, const char* name, void* argumentList, int
     }
 
     Function* function = new Function(name, returnType, arguments, line);
+    functions.push_back(function);
 
     functionContext.push_back({false, function});
 
@@ -316,6 +472,7 @@ void* createFunction(Type returnType, const char* name, void* argumentList, int
 }
 
 void* getSymbolFromSymbolTable(const char* name, int line) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     Symbol* symbol = currentSymbolTable->lookup(name);
     if (symbol == nullptr) {
         string message = "Symbol " + string(name) + " not found";
@@ -330,7 +487,13 @@ void setVariableAsInitialized(void* symbol) {
     var->setIsInitialized(true);
 }
 
+void setVariableAsDeclaredWithoutValue(void* symbol) {
+    Variable* var = (Variable*)symbol;
+    var->setIsDeclaredWithoutValue(true);
+}
+
 void* getVariableFromSymbolTable(const char* name, int line) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     Symbol* symbol = (Symbol*)getSymbolFromSymbolTable(name, line);
     Variable* var = dynamic_cast<Variable*>(symbol);
     if (var == nullptr) {
@@ -394,46 +557,61 @@ void checkParamIsNumber(Type type, int line) {
 }
 
 void printSymbolTable(const char* inputFileName) {
-    const char* outputFileName = getOutputFileName(inputFileName, "_symbol_table.txt");
-    ofstream outFile = ofstream(outputFileName, ios::out);
-    currentSymbolTable->print(outFile);
-    outFile.close();
+    PROFILE_SCOPE(PHASE_OUTPUT_SYMBOL_TABLE);
+    runOnOutputWriter([inputFileName] {
+        const char* outputFileName = getOutputFileName(inputFileName, "_symbol_table.txt");
+        ofstream outFile = ofstream(outputFileName, ios::out);
+        currentSymbolTable->print(outFile);
+
+        ostringstream frames;
+        for (Function* function : functions) {
+            function->printFrame(frames);
+        }
+        printf("%s", frames.str().c_str());
+        outFile << frames.str();
+        PROFILE_COUNT(COUNTER_BYTES_WRITTEN, outFile.tellp());
+        outFile.close();
+    });
 }
 
 void printUnusedSymbols(const char* inputFileName) {
-    vector<Symbol*> unusedSymbols = currentSymbolTable->getUnusedSymbols();
+    PROFILE_SCOPE(PHASE_OUTPUT_WARNINGS);
+    runOnOutputWriter([inputFileName] {
+        vector<Symbol*> unusedSymbols = currentSymbolTable->getUnusedSymbols();
 
-    sort(unusedSymbols.begin(), unusedSymbols.end(), [](Symbol* a, Symbol* b) {
-        return a->getLine() < b->getLine();
-    });
+        sort(unusedSymbols.begin(), unusedSymbols.end(), [](Symbol* a, Symbol* b) {
+            return a->getLine() < b->getLine();
+        });
 
-    if (unusedSymbols.empty()) {
-        return;
-    }
+        if (unusedSymbols.empty()) {
+            return;
+        }
 
-    const char* outputFileName = getOutputFileName(inputFileName, "_error.txt");
-    ofstream outFile = ofstream(outputFileName, ios::app);
-    ostringstream oss;
+        const char* outputFileName = getOutputFileName(inputFileName, "_error.txt");
+        ofstream outFile = ofstream(outputFileName, ios::app);
+        ostringstream oss;
 
-    for (Symbol* symbol : unusedSymbols) {
-        Variable* var = dynamic_cast<Variable*>(symbol);
-        string symbolTypeName;
+        for (Symbol* symbol : unusedSymbols) {
+            Variable* var = dynamic_cast<Variable*>(symbol);
+            string symbolTypeName;
 
-        if (var == nullptr) {
-            symbolTypeName = "Function";
-        } else {
-            symbolTypeName = "Variable";
-        }
+            if (var == nullptr) {
+                symbolTypeName = "Function";
+            } else {
+                symbolTypeName = "Variable";
+            }
 
-        string message = "Warning: " + symbolTypeName + " " + symbol->getName() + " declared in line " + to_string(symbol->getLine());
-        message += " is not used";
-        oss << message << endl;
-    }
+            string message = "Warning: " + symbolTypeName + " " + symbol->getName() + " declared in line " + to_string(symbol->getLine());
+            message += " is not used";
+            oss << message << endl;
+        }
 
-    printf("%s", oss.str().c_str());
-    outFile << oss.str();
+        printf("%s", oss.str().c_str());
+        outFile << oss.str();
+        PROFILE_COUNT(COUNTER_BYTES_WRITTEN, oss.str().size());
 
-    outFile.close();
+        outFile.close();
+    });
 }
 
 Type getSymbolType(void* symbol) {
@@ -442,35 +620,39 @@ Type getSymbolType(void* symbol) {
 }
 
 void* createArgumentList() {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     return (void*)new vector<Variable*>();
 }
 
 void addVariableToArgumentList(void* argumentList, void* variable) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     vector<Variable*>* arguments = (vector<Variable*>*)argumentList;
     Variable* var = (Variable*)variable;
     arguments->push_back(var);
 }
 
 void* createParamList() {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     return (void*)new vector<Parameter>();
 }
 
-void addParamToParamList(void* paramList, const char* name, Type type) {
+void addParamToParamList(void* paramList, void* node, Type type) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     vector<Parameter>* arguments = (vector<Parameter>*)paramList;
-    arguments->push_back({type, name});
+    arguments->push_back({type, node});
 }
 
 void checkParamListAgainstFunction(void* paramList, void* function, int line) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     vector<Parameter>* params = (vector<Parameter>*)paramList;
     Function* func = (Function*)function;
     vector<Variable*>* arguments = func->getArguments();
-    reverse(params->begin(), params->end());
     if (params->size() != arguments->size()) {
         string message = "Function " + func->getName() + " expects " + to_string(arguments->size()) + " arguments";
         message += " but " + to_string(params->size()) + " were provided";
         exitOnError(message.c_str(), line);
     }
-    for (int i = 0; i < params->size(); i++) {
+    for (size_t i = 0; i < params->size(); i++) {
         Type paramType = params->at(i).type;
         Type argType = arguments->at(i)->getType();
         if (paramType != argType) {
@@ -483,12 +665,12 @@ void checkParamListAgainstFunction(void* paramList, void* function, int line) {
 
 const char* convertFloatNumToChar(float num) {
     string str = to_string(num);
-    return str.c_str();
+    return copyParserText(str.c_str());
 }
 
 const char* convertIntNumToChar(int num) {
     string str = to_string(num);
-    return strdup(str.c_str());
+    return copyParserText(str.c_str());
 }
 
 const char* convertNumToChar(void* num, Type type) {
@@ -499,15 +681,18 @@ const char* convertNumToChar(void* num, Type type) {
 }
 
 void* createSwitchCaseList() {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     return (void*)new vector<SwitchCaseMetadata>();
 }
 
-void addCaseToSwitchCaseList(void* switchCaseList, Type type, int line) {
+void addCaseToSwitchCaseList(void* switchCaseList, Type type, int line, const char* value, void* body) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     vector<SwitchCaseMetadata>* switchCases = (vector<SwitchCaseMetadata>*)switchCaseList;
-    switchCases->push_back({type, line});
+    switchCases->push_back({type, line, value, body});
 }
 
 void checkSwitchCaseListAgainstType(void* switchCaseList, Type type) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
     vector<SwitchCaseMetadata>* switchCases = (vector<SwitchCaseMetadata>*)switchCaseList;
     for (SwitchCaseMetadata switchCase : *switchCases) {
         if (switchCase.type != type) {
@@ -517,14 +702,17 @@ void checkSwitchCaseListAgainstType(void* switchCaseList, Type type) {
     }
 }
 
-void setFunctionLabel(void* function, const char* label) {
-    Function* func = (Function*)function;
-    func->setLabel(label);
-}
-
-const char* getFunctionLabel(void* function) {
-    Function* func = (Function*)function;
-    return strdup(func->getLabel().c_str());
+void checkSwitchCaseListForDuplicates(void* switchCaseList) {
+    PROFILE_SCOPE(PHASE_SEMANTIC);
+    vector<SwitchCaseMetadata>* switchCases = (vector<SwitchCaseMetadata>*)switchCaseList;
+    unordered_map<string, int> firstLines;
+    for (const SwitchCaseMetadata& switchCase : *switchCases) {
+        auto inserted = firstLines.insert({switchCase.value, switchCase.line});
+        if (!inserted.second) {
+            string message = "Duplicate case value " + switchCase.value + ", already used in line " + to_string(inserted.first->second);
+            exitOnError(message.c_str(), switchCase.line);
+        }
+    }
 }
 }
 
@@ -8,6 +8,8 @@
 #include "common.h"
 using namespace std;
 
+class SymbolTable;
+
 class Symbol {
    private:
     string name;
@@ -31,6 +33,7 @@ class Variable : public Symbol {
     bool isConstant;
     bool isFuncArg;
     bool isInitialized = false;
+    bool isDeclaredWithoutValue = false;  // declared as `int x;`, it holds whatever the frame had until assigned
 
    public:
     Variable(Type type, string name, int line, bool isConstant, bool isFuncArg = false, bool isInitialized = false);
@@ -40,6 +43,8 @@ class Variable : public Symbol {
     bool getIsInitialized();
     void setIsInitialized(bool isInitialized);
     void setIsFuncArg(bool isFuncArg);
+    bool getIsDeclaredWithoutValue();
+    void setIsDeclaredWithoutValue(bool isDeclaredWithoutValue);
 };
 
 class Function : public Symbol {
@@ -47,6 +52,9 @@ class Function : public Symbol {
     vector<Variable*>* arguments;
     bool isReturnStatementPresent = false;
     string label;
+    SymbolTable* scope = nullptr;             // scope of the body, the arguments are copied into it
+    vector<string> frameSlots;                // arguments, locals and temporaries indexed by their frame slot
+    unordered_map<string, int> frameSlotOf;
 
    public:
     Function(string name, Type returnType, vector<Variable*>* arguments, int line);
@@ -56,6 +64,14 @@ class Function : public Symbol {
     void setIsReturnStatementPresent(bool isReturnStatementPresent);
     void setLabel(string label);
     string getLabel();
+    void setScope(SymbolTable* scope);
+    SymbolTable* getScope();
+    // Slot of a name that lives in the activation record, a new name is appended to the frame
+    int addFrameSlot(const string& name);
+    // -1 for names that are not part of the frame (globals)
+    int getFrameSlot(const string& name);
+    const vector<string>& getFrameSlots();
+    void printFrame(ostream& out);
 };
 
 class SymbolTable {
@@ -63,6 +79,7 @@ class SymbolTable {
     unordered_map<string, Symbol*> symbols;
     SymbolTable* parent;
     vector<SymbolTable*> children;
+    Function* function = nullptr;
     int id;
     static int symbolTableIdCnt;
 
@@ -76,6 +93,14 @@ class SymbolTable {
     SymbolTable* getParent();
     SymbolTable* createChild();
 
+    // Function whose body this scope is, null for every other scope
+    Function* getFunction();
+    void setFunction(Function* function);
+    // Variables of this scope and its nested scopes ordered by declaration, without nested function bodies
+    void collectFrameVariables(vector<Variable*>& variables);
+    // Variables of this scope and of every scope nested in it, function bodies included
+    void collectVariables(vector<Variable*>& variables);
+
     // print symbol table and its children
     void print(ofstream& outFile);
     bool isEmpty();
@@ -84,6 +109,21 @@ class SymbolTable {
     vector<Symbol*> getUnusedSymbols();
 };
 
+// Function whose entry label is label, null if there is none
+Function* getFunctionByLabel(const string& label);
+// Variables declared outside of every function, ordered by declaration
+vector<Variable*> getGlobalVariables();
+// Every variable of the program, function arguments and locals included
+vector<Variable*> getAllVariables();
+// Every function in definition order, imported ones included
+const vector<Function*>& getFunctions();
+// True while the parser is outside of every scope
+bool isGlobalScope();
+bool isDeclaredInGlobalScope(Symbol* symbol);
+// Declares a function of an imported module, marked used like its variables. Exported functions are added to
+// the global scope; the scope of the body is a child of it holding the variables of the frame.
+void addImportedFunction(Function* function, const vector<Variable*>& variables, bool exported, int line);
+
 struct FunctionMetadata {
     bool isFunctionConsumedInScopeCheck;
     Function* function;
@@ -91,7 +131,14 @@ struct FunctionMetadata {
 
 struct Parameter {
     Type type;
-    string name;
+    void* node;  // syntax tree of the argument
+};
+
+struct SwitchCaseMetadata {
+    Type type;
+    int line;
+    string value;  // case value as it appears in the quadruples
+    void* body;    // syntax tree of the case body
 };
 
 class FunctionContextSingleton {
@@ -0,0 +1,63 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        unique_lock<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(function<void()> task) {
+    {
+        unique_lock<mutex> lock(queueMutex);
+        tasks.push(task);
+        pendingTasks++;
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> lock(queueMutex);
+    allTasksDone.wait(lock, [this] { return pendingTasks == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = tasks.front();
+            tasks.pop();
+        }
+
+        task();
+
+        unique_lock<mutex> lock(queueMutex);
+        pendingTasks--;
+        if (pendingTasks == 0) {
+            allTasksDone.notify_all();
+        }
+    }
+}
+
+unsigned ThreadPool::defaultThreadCount() {
+    unsigned count = thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Fixed size pool of worker threads consuming a FIFO queue of tasks
+class ThreadPool {
+   private:
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex queueMutex;
+    condition_variable taskAvailable;
+    condition_variable allTasksDone;
+    size_t pendingTasks = 0;
+    bool stopping = false;
+
+    void workerLoop();
+
+   public:
+    explicit ThreadPool(unsigned threadCount);
+    ~ThreadPool();
+
+    void enqueue(function<void()> task);
+
+    // Block until every enqueued task has finished
+    void wait();
+
+    // Number of hardware threads, at least 1
+    static unsigned defaultThreadCount();
+};
@@ -0,0 +1,139 @@
+"""Deterministic generator of large C-- programs used by `make bench`.
+
+Every program stresses one part of the front end. The same seed and scale
+always produce byte-identical files so results can be compared across runs.
+"""
+
+import argparse
+import os
+import random
+
+
+def deep_nesting(rng, scale):
+    """Nested scopes, if statements and loops, each level declaring and reading variables."""
+    depth = 60 * scale
+    lines = ["int total = 0;"]
+    indent = ""
+    for level in range(depth):
+        kind = level % 3
+        if kind == 0:
+            lines.append(f"{indent}{{")
+        elif kind == 1:
+            lines.append(f"{indent}if (total < {rng.randint(1, 1000)}) then {{")
+        else:
+            lines.append(f"{indent}while (total > {rng.randint(1000, 2000)}) {{")
+        indent += "    "
+        lines.append(f"{indent}int v{level} = total + {level};")
+        lines.append(f"{indent}total = v{level} * 2;")
+    for level in reversed(range(depth)):
+        indent = indent[:-4]
+        lines.append(f"{indent}}};")
+    return "\n".join(lines) + "\n"
+
+
+def big_switch(rng, scale):
+    """One switch per chunk, each with a thousand integer arms, plus a char switch."""
+    lines = ["int selector = 7;", "int hits = 0;", "char letter = 'q';"]
+    for chunk in range(scale):
+        arms = 1000
+        lines.append("switch (selector) {")
+        for arm in rng.sample(range(arms * 4), arms):
+            lines.append(f"    case {arm}: {{ hits = hits + {arm % 7 + 1}; }}")
+        lines.append("};")
+    lines.append("switch (letter) {")
+    for code in range(ord("a"), ord("z") + 1):
+        lines.append(f"    case '{chr(code)}': {{ hits = hits + 1; }}")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def long_expressions(rng, scale):
+    """Long arithmetic and boolean expression chains over a handful of variables."""
+    names = [f"x{i}" for i in range(16)]
+    lines = [f"int {name} = {rng.randint(1, 9)};" for name in names]
+    lines.append("bool flag = False;")
+    operators = ["+", "-", "*", "/"]
+    for statement in range(20 * scale):
+        terms = [rng.choice(names) for _ in range(300)]
+        expression = terms[0]
+        for term in terms[1:]:
+            expression += f" {rng.choice(operators)} {term}"
+        lines.append(f"{names[statement % len(names)]} = {expression};")
+        comparisons = [f"({rng.choice(names)} < {rng.choice(names)})" for _ in range(100)]
+        lines.append(f"flag = {' && '.join(comparisons[:50])} || {' || '.join(comparisons[50:])};")
+    return "\n".join(lines) + "\n"
+
+
+def many_functions(rng, scale):
+    """Hundreds of functions with many arguments calling earlier functions."""
+    count = 400 * scale
+    arguments = 12
+    lines = []
+    for index in range(count):
+        parameters = ", ".join(f"int a{i}" for i in range(arguments))
+        lines.append(f"function int f{index}({parameters}) {{")
+        lines.append(f"    int sum = a0 + a{arguments - 1};")
+        for i in range(1, arguments - 1):
+            lines.append(f"    sum = sum + a{i} * {rng.randint(1, 9)};")
+        if index > 0:
+            callee = rng.randrange(index)
+            actuals = ", ".join("sum" if i % 2 else f"a{i}" for i in range(arguments))
+            lines.append(f"    sum = sum + f{callee}({actuals});")
+        lines.append("    if (sum > 100) then {")
+        lines.append("        return sum - 100;")
+        lines.append("    };")
+        lines.append("    return sum;")
+        lines.append("};")
+    actuals = ", ".join(str(i) for i in range(arguments))
+    for index in range(0, count, 7):
+        lines.append(f"f{index}({actuals});")
+    return "\n".join(lines) + "\n"
+
+
+def long_loops(rng, scale):
+    """for, while and repeat loops with very long bodies."""
+    body_length = 1000 * scale
+    lines = ["int i = 0;", "int acc = 0;", "int limit = 10;"]
+    for loop in range(3):
+        if loop == 0:
+            lines.append("for (i = 0; i < limit; i = i + 1) {")
+        elif loop == 1:
+            lines.append("while (acc < limit * 100) {")
+        else:
+            lines.append("repeat {")
+        for statement in range(body_length):
+            lines.append(f"    acc = acc + i * {rng.randint(1, 50)} - {statement % 13};")
+        if loop == 2:
+            lines.append("} until (acc > limit);")
+        else:
+            lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+GENERATORS = {
+    "deep_nesting": deep_nesting,
+    "big_switch": big_switch,
+    "long_expressions": long_expressions,
+    "many_functions": many_functions,
+    "long_loops": long_loops,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--output", default="bench/corpus", help="directory the programs are written to")
+    parser.add_argument("--scale", type=int, default=1, help="size multiplier of every program")
+    parser.add_argument("--seed", type=int, default=403)
+    args = parser.parse_args()
+
+    os.makedirs(args.output, exist_ok=True)
+    for name, generator in GENERATORS.items():
+        rng = random.Random(f"{args.seed}:{name}")
+        path = os.path.join(args.output, f"{name}.txt")
+        with open(path, "w", newline="\n") as file:
+            file.write(generator(rng, args.scale))
+        print(f"generated {path} ({os.path.getsize(path)} bytes)")
+
+
+if __name__ == "__main__":
+    main()
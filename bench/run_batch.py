@@ -0,0 +1,81 @@
+"""Batch execution benchmark for the C-- compiler.
+
+Copies the test programs into a work directory a number of times, then
+compiles and runs all of them twice. The first run starts one `parser --run`
+process per program, -j at a time. The second starts a single
+`parser --batch -j<n>`. It reports the programs per second of both, and the
+summary the batch printed.
+"""
+
+import argparse
+import concurrent.futures
+import glob
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+OUTPUT_SUFFIXES = ("_error.txt", "_quadruples.txt", "_symbol_table.txt", "_profile.txt", "_interface.txt", "_batch.txt")
+
+
+def copy_programs(tests, work, copies):
+    shutil.rmtree(work, ignore_errors=True)
+    programs = []
+    for copy in range(copies):
+        directory = os.path.join(work, str(copy))
+        os.makedirs(directory)
+        for path in sorted(glob.glob(os.path.join(tests, "*.txt"))):
+            if not path.endswith(OUTPUT_SUFFIXES):
+                shutil.copy(path, directory)
+                # modules are compiled by the program importing them
+                if "_import_" not in os.path.basename(path):
+                    programs.append(os.path.join(str(copy), os.path.basename(path)))
+    return programs
+
+
+def run_processes(parser, work, programs, flags, jobs):
+    def run(program):
+        subprocess.run([parser, "--run", *flags, program], cwd=work, capture_output=True)
+
+    start = time.perf_counter()
+    with concurrent.futures.ThreadPoolExecutor(max_workers=jobs) as pool:
+        list(pool.map(run, programs))
+    return time.perf_counter() - start
+
+
+def run_batch(parser, work, programs, flags, jobs):
+    with open(os.path.join(work, "programs.txt"), "w") as listing:
+        listing.write("\n".join(programs) + "\n")
+    start = time.perf_counter()
+    process = subprocess.run([parser, "--batch", f"-j{jobs}", *flags, "programs.txt"], cwd=work, capture_output=True, text=True)
+    return time.perf_counter() - start, process.stdout
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--parser", default="./parser")
+    parser.add_argument("--tests", default="tests")
+    parser.add_argument("--work", default="bench/batch", help="directory the programs are copied to")
+    parser.add_argument("--copies", type=int, default=20, help="copies of every test program")
+    parser.add_argument("-j", dest="jobs", type=int, default=os.cpu_count() or 1, help="programs run at the same time")
+    parser.add_argument("--flags", default="", help="options given to every compilation, such as -O")
+    args = parser.parse_args()
+
+    parser_path = os.path.abspath(args.parser)
+    flags = args.flags.split()
+    programs = copy_programs(args.tests, args.work, args.copies)
+    # the modules are compiled once, before anything is timed
+    run_processes(parser_path, args.work, programs[: len(programs) // args.copies], flags, args.jobs)
+
+    processes_s = run_processes(parser_path, args.work, programs, flags, args.jobs)
+    batch_s, summary = run_batch(parser_path, args.work, programs, flags, args.jobs)
+    print(f"{len(programs)} programs, {args.jobs} at a time")
+    print(f"{'one process each':<18} {processes_s:>8.3f} s {len(programs) / processes_s:>9.1f} programs/s")
+    print(f"{'--batch':<18} {batch_s:>8.3f} s {len(programs) / batch_s:>9.1f} programs/s  ({processes_s / batch_s:.2f}x)")
+    print(summary, end="")
+    sys.exit(0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,142 @@
+"""Benchmark harness for the C-- compiler.
+
+Compiles every program of the corpus with `parser --time-report=json`, records
+wall time, peak RSS, heap allocations and per phase throughput, and compares
+the medians against a saved baseline.
+"""
+
+import argparse
+import glob
+import json
+import os
+import statistics
+import subprocess
+import sys
+import time
+
+REPORT_START = '{\n  "total_ms"'
+COMPARED_METRICS = ["wall_ms", "peak_rss_kb", "allocations"]
+
+
+def run_once(parser, program, flags):
+    """Run the compiler once and return (wall_ms, peak_rss_kb, time report)."""
+    start = time.perf_counter()
+    process = subprocess.Popen([parser, "--time-report=json", *flags, program], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    output = process.stdout.read()
+    peak_rss_kb = None
+    if hasattr(os, "wait4"):
+        _, status, usage = os.wait4(process.pid, 0)
+        process.returncode = os.waitstatus_to_exitcode(status)
+        peak_rss_kb = usage.ru_maxrss
+    else:
+        process.wait()
+    wall_ms = (time.perf_counter() - start) * 1000
+
+    text = output.decode(errors="replace")
+    if process.returncode != 0:
+        raise RuntimeError(f"{program} failed to compile:\n{text[-2000:]}")
+
+    report_index = text.rfind(REPORT_START)
+    if report_index < 0:
+        raise RuntimeError("no time report in the output, build the parser with make PROFILER=1")
+    return wall_ms, peak_rss_kb, json.loads(text[report_index:])
+
+
+def measure(parser, program, repeat, flags):
+    walls, rss, reports = [], [], []
+    for _ in range(repeat):
+        wall_ms, peak_rss_kb, report = run_once(parser, program, flags)
+        walls.append(wall_ms)
+        if peak_rss_kb is not None:
+            rss.append(peak_rss_kb)
+        reports.append(report)
+
+    # take the report of the median run so phases and counters stay consistent
+    median_run = sorted(range(repeat), key=lambda i: walls[i])[repeat // 2]
+    report = reports[median_run]
+    counters = report["counters"]
+    quads = counters["quads_emitted"]
+
+    phases = {}
+    for phase, values in report["phases"].items():
+        seconds = values["ms"] / 1000
+        phases[phase] = {
+            "ms": values["ms"],
+            "quads_per_sec": round(quads / seconds) if seconds > 0 else None,
+        }
+
+    return {
+        "wall_ms": round(statistics.median(walls), 3),
+        "peak_rss_kb": statistics.median(rss) if rss else None,
+        "allocations": counters.get("allocations"),
+        "quads": quads,
+        "tokens": counters["tokens"],
+        "phases": phases,
+    }
+
+
+def print_results(results, baseline, threshold):
+    regressions = []
+    for program, result in results.items():
+        print(f"== {program}: {result['quads']} quads, {result['tokens']} tokens")
+        for phase, values in result["phases"].items():
+            if values["ms"] == 0:
+                continue
+            rate = values["quads_per_sec"]
+            print(f"   {phase:<20} {values['ms']:>10.3f} ms {rate if rate is not None else '-':>14} quads/s")
+
+        previous = baseline.get(program) if baseline else None
+        for metric in COMPARED_METRICS:
+            value = result[metric]
+            line = f"   {metric:<20} {value if value is not None else '-':>10}"
+            if previous and previous.get(metric) and value is not None:
+                change = (value - previous[metric]) / previous[metric]
+                line += f"   baseline {previous[metric]:>10}   {change:+.1%}"
+                if change > threshold:
+                    line += "   REGRESSION"
+                    regressions.append(f"{program} {metric} {change:+.1%}")
+            print(line)
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--parser", default="./parser", help="compiler executable")
+    parser.add_argument("--corpus", default="bench/corpus", help="directory of generated programs")
+    parser.add_argument("--baseline", default="bench/baseline.json")
+    parser.add_argument("--save-baseline", action="store_true", help="store this run as the new baseline")
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument("--threshold", type=float, default=0.10, help="relative slowdown reported as a regression")
+    parser.add_argument("--flags", default="", help="extra compiler options, such as \"--pipeline --stream\"")
+    args = parser.parse_args()
+
+    programs = sorted(path for path in glob.glob(os.path.join(args.corpus, "*.txt"))
+                      if not path.endswith(("_quadruples.txt", "_symbol_table.txt", "_error.txt")))
+    if not programs:
+        sys.exit(f"no programs in {args.corpus}, run bench/generate_corpus.py first")
+
+    results = {}
+    for program in programs:
+        results[os.path.basename(program)] = measure(args.parser, program, args.repeat, args.flags.split())
+
+    baseline = None
+    if os.path.exists(args.baseline) and not args.save_baseline:
+        with open(args.baseline) as file:
+            baseline = json.load(file)
+
+    regressions = print_results(results, baseline, args.threshold)
+
+    if args.save_baseline or baseline is None:
+        with open(args.baseline, "w") as file:
+            json.dump(results, file, indent=2, sort_keys=True)
+        print(f"baseline written to {args.baseline}")
+
+    if regressions:
+        print("regressions against the baseline:")
+        for regression in regressions:
+            print(f"   {regression}")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,140 @@
+"""Interpreter benchmark for the C-- compiler.
+
+Runs small kernels that each stress one kind of instruction (integer and float
+arithmetic, comparisons and jumps, string assignment) with `parser --run` and
+reports how many quadruples per second the interpreter executes. The time of
+the compilation alone is measured separately and taken off. With
+`--baseline-parser` another build runs the same kernels, which must print the
+same globals, and the speedup over it is reported.
+"""
+
+import argparse
+import os
+import re
+import statistics
+import subprocess
+import sys
+import time
+
+
+KERNELS = {
+    "int_arithmetic": """
+int i = 0;
+int total = 0;
+int mixed = 7;
+while (i < {iterations}) {
+    total = total + i * 3 - mixed;
+    mixed = mixed * 31 + total - i;
+    i = i + 1;
+};
+""",
+    "float_arithmetic": """
+int i = 0;
+float sum = 0.0;
+float scale = 1.5;
+float decay = 0.999;
+while (i < {iterations}) {
+    sum = sum * decay + scale / 2.0;
+    scale = scale - 0.25 * decay;
+    i = i + 1;
+};
+""",
+    "comparison": """
+int i = 0;
+int inside = 0;
+int equal = 0;
+char grade = 'c';
+while (i < {iterations}) {
+    if (i > 100 && i <= {half}) then {
+        inside = inside + 1;
+    };
+    if (i == 7 || grade != 'c') then {
+        equal = equal + 1;
+    };
+    i = i + 1;
+};
+""",
+    "string_assignment": """
+int i = 0;
+int first = 0;
+string a = "first";
+string b = "second";
+string swap = "";
+while (i < {iterations}) {
+    swap = a;
+    a = b;
+    b = swap;
+    if (a == "first") then {
+        first = first + 1;
+    };
+    i = i + 1;
+};
+""",
+}
+
+EXECUTED = re.compile(r"Executed (\d+) instructions")
+
+
+def timed(command, repeat):
+    times, output = [], None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        output = subprocess.run(command, check=True, capture_output=True, text=True).stdout
+        times.append((time.perf_counter() - start) * 1000)
+    return statistics.median(times), output
+
+
+def globals_of(output):
+    return [line for line in output.splitlines() if " = " in line]
+
+
+def run_ms(parser, source, flags, repeat):
+    """Median time of the run alone, with the globals it printed."""
+    compile_ms, _ = timed([parser, *flags, source], repeat)
+    total_ms, output = timed([parser, *flags, "--run", source], repeat)
+    return max(total_ms - compile_ms, 0.0), globals_of(output)
+
+
+def executed_instructions(parser, source, flags):
+    subprocess.run([parser, *flags, "--profile-lines", source], check=True, capture_output=True)
+    with open(os.path.splitext(source)[0] + "_profile.txt") as report:
+        return int(EXECUTED.search(report.read()).group(1))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--parser", default="./parser")
+    parser.add_argument("--baseline-parser", default=None, help="build to compare against, such as one of an older commit")
+    parser.add_argument("--work", default="bench/interpreter", help="directory for the kernels and their outputs")
+    parser.add_argument("--iterations", type=int, default=200000, help="loop iterations of every kernel")
+    parser.add_argument("--repeat", type=int, default=5, help="runs per kernel, the median is reported")
+    parser.add_argument("-O", dest="optimize", action="store_true", help="run the optimized quadruples")
+    args = parser.parse_args()
+
+    os.makedirs(args.work, exist_ok=True)
+    flags = ["-O"] if args.optimize else []
+    failed = False
+    header = f"{'kernel':<18} {'instructions':>13} {'run ms':>9} {'Minstr/s':>9}"
+    if args.baseline_parser:
+        header += f" {'baseline ms':>12} {'speedup':>8}  output"
+    print(header)
+    for name, source in KERNELS.items():
+        path = os.path.join(args.work, name + ".txt")
+        with open(path, "w", newline="\n") as file:
+            file.write(source.replace("{iterations}", str(args.iterations)).replace("{half}", str(args.iterations // 2)).lstrip())
+        instructions = executed_instructions(args.parser, path, flags)
+        ms, printed = run_ms(args.parser, path, flags, args.repeat)
+        rate = instructions / ms / 1000 if ms > 0 else float("inf")
+        line = f"{name:<18} {instructions:>13} {ms:>9.2f} {rate:>9.1f}"
+        if args.baseline_parser:
+            baseline_ms, baseline_printed = run_ms(args.baseline_parser, path, flags, args.repeat)
+            same = printed == baseline_printed
+            speedup = baseline_ms / ms if ms > 0 else float("inf")
+            line += f" {baseline_ms:>12.2f} {speedup:>7.2f}x  {'same' if same else 'DIFFERENT'}"
+            failed = failed or not same
+        print(line)
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
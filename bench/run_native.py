@@ -0,0 +1,339 @@
+"""Native code benchmark for the C-- compiler.
+
+Translates every program with `parser --emit-c`, builds the C file with
+`gcc -O2`, and compares the native run against a reference interpreter of the
+quadruples. Both must print the same global variables; the report shows the
+run time of each and the speedup of the native build.
+"""
+
+import argparse
+import glob
+import operator
+import os
+import re
+import shutil
+import statistics
+import struct
+import subprocess
+import sys
+import time
+
+
+# Programs whose run time is dominated by executing code rather than by compiling it
+KERNELS = {
+    "fibonacci": """
+function int fibonacci(int n) {
+    if (n < 2) then {
+        return n;
+    };
+    return fibonacci(n - 1) + fibonacci(n - 2);
+};
+int result = fibonacci(22);
+""",
+    "prime_count": """
+int primes = 0;
+int candidate = 2;
+while (candidate < 4000) {
+    bool isPrime = True;
+    int divisor = 2;
+    while (divisor * divisor <= candidate && isPrime) {
+        if (candidate - candidate / divisor * divisor == 0) then {
+            isPrime = False;
+        };
+        divisor = divisor + 1;
+    };
+    if (isPrime) then {
+        primes = primes + 1;
+    };
+    candidate = candidate + 1;
+};
+""",
+    "nested_loops": """
+int i = 0;
+int j = 0;
+int checksum = 0;
+float average = 0.0;
+for (i = 0; i < 300; i = i + 1) {
+    for (j = 0; j < 300; j = j + 1) {
+        checksum = checksum * 31 + i * j - (i + j) / 3;
+    };
+    average = average + 0.5;
+};
+""",
+    "nested_frames": """
+function int walk(int n) {
+    int total = 0;
+    function void visit(int depth) {
+        int weight = depth;
+        function void add(int k) {
+            total = total + k * weight;
+        };
+        add(depth);
+        if (depth < n) then {
+            visit(depth + 1);
+        };
+        add(1);
+    };
+    visit(1);
+    return total;
+};
+int checksum = 0;
+int round = 0;
+while (round < 2000) {
+    checksum = checksum * 7 + walk(round - round / 40 * 40);
+    round = round + 1;
+};
+""",
+}
+
+INT_MIN, INT_RANGE = -(2**31), 2**32
+NUMBER = re.compile(r"^-?\d+(\.\d+)?$")
+COMPARISONS = {
+    "LT": operator.lt, "GT": operator.gt, "LTE": operator.le, "GTE": operator.ge, "EQ": operator.eq, "NEQ": operator.ne,
+    "AND": lambda left, right: bool(left) and bool(right), "OR": lambda left, right: bool(left) or bool(right),
+}
+ARITHMETIC = {"ADD": operator.add, "SUB": operator.sub, "MUL": operator.mul, "DIV": None, "POW": None}
+
+
+def wrap(value):
+    return (value - INT_MIN) % INT_RANGE + INT_MIN
+
+
+def to_float(value):
+    return struct.unpack("f", struct.pack("f", value))[0]
+
+
+def convert(value, kind):
+    """Value stored into a C variable of the given symbol table type."""
+    if kind == "float":
+        return to_float(float(value))
+    if kind in ("integer", "char", "boolean") and isinstance(value, float):
+        return wrap(int(value))
+    return value
+
+
+class QuadInterpreter:
+    """Executes the quadruples with the semantics of the C that --emit-c produces: 32 bit wrapping
+    integers, single precision floats, and arithmetic typed by its left operand."""
+
+    def __init__(self, quadruples_path, symbol_table_path):
+        self.quads = []
+        for line in open(quadruples_path):
+            cells = [cell.strip() for cell in line.strip().strip("|").split("|")]
+            if line.startswith("|") and len(cells) == 5 and cells[0].isdigit():
+                self.quads.append(tuple(cells[1:]))
+        self.labels = {quad[0]: index for index, quad in enumerate(self.quads) if quad[0].endswith(":")}
+        # function every function is nested in, from the jump over its body: JMP skip, entry label, ENTER
+        self.parents, open_ = {}, []
+        for index, (op, arg1, arg2, result) in enumerate(self.quads):
+            if open_ and op == open_[-1][1]:
+                open_.pop()
+            if op.endswith(":") and 0 < index < len(self.quads) - 1 and self.quads[index + 1][0] == "ENTER" and self.quads[index - 1][0] == "JMP":
+                self.parents[op] = open_[-1][0] if open_ else None
+                open_.append((op, self.quads[index - 1][3]))
+
+        self.types, self.functions, self.frames = {}, {}, {}
+        frame = None
+        for line in open(symbol_table_path):
+            match = re.match(r"------ Frame of (\S+) \((L\d+:)\) ------", line)
+            if match:
+                frame = self.frames.setdefault(match.group(2), [])
+                continue
+            if line.startswith("------ "):
+                frame = None
+                continue
+            cells = [cell.strip() for cell in line.strip().strip("|").split("|")]
+            if frame is not None and len(cells) == 2 and cells[0].isdigit():
+                frame.append(cells[1])
+            elif len(cells) == 4 and cells[1] in ("Var", "Arg", "Const"):
+                self.types.setdefault(cells[0], cells[2])
+            elif len(cells) == 4 and cells[1] == "Func":
+                self.functions.setdefault(cells[0], cells[2])
+        self.frameNames = {label: set(slots) for label, slots in self.frames.items()}
+
+    def run(self):
+        quads, labels, types = self.quads, self.labels, self.types
+        globals_, frame, stack, params = {}, None, [], []
+
+        # a frame is (names, values, label, frame of the function it is nested in); a nested function
+        # reaches the variables of the functions around it through that link
+        def scope(name):
+            enclosing = frame
+            while enclosing is not None:
+                if name in enclosing[0]:
+                    return enclosing[1]
+                enclosing = enclosing[3]
+            return globals_
+
+        # literals are decoded once, names are looked up on every use
+        literals = {}
+        for quad in quads:
+            for operand in quad[1:3]:
+                if NUMBER.match(operand):
+                    literals[operand] = to_float(float(operand)) if "." in operand else int(operand)
+                elif operand.startswith('"'):
+                    literals[operand] = operand[1:-1]
+                elif operand.startswith("'"):
+                    literals[operand] = ord(operand[1]) if len(operand) == 3 else 0
+
+        def value(operand):
+            if operand in literals:
+                return literals[operand]
+            return scope(operand).get(operand, 0)
+
+        def store(name, result):
+            scope(name)[name] = convert(result, types.get(name))
+
+        def arithmetic(op, left, right):
+            if op in COMPARISONS:
+                return int(COMPARISONS[op](left, right))
+            is_float = isinstance(left, float) or isinstance(right, float)
+            if op == "POW":
+                if is_float:
+                    return to_float(float(left) ** float(right))
+                if right < 0:
+                    return 1 if left == 1 else (-1 if right % 2 else 1) if left == -1 else 0
+                return wrap(pow(left, right, INT_RANGE))
+            if op == "DIV":
+                if right == 0:
+                    raise ZeroDivisionError("division by zero")
+                result = float(left) / right if is_float else abs(left) // abs(right) * (1 if (left < 0) == (right < 0) else -1)
+            else:
+                result = ARITHMETIC[op](left, right)
+            # the result has the type of the left operand, like the temporaries of the C program
+            if isinstance(left, float):
+                return to_float(result)
+            return wrap(int(result))
+
+        pc = 0
+        while pc < len(quads):
+            op, arg1, arg2, result = quads[pc]
+            pc += 1
+            if op.endswith(":") or op == "ENTER":
+                continue
+            if op == "ASSIGN":
+                store(result, value(arg1))
+            elif op == "NEG":
+                operand = value(arg2)
+                store(result, to_float(-operand) if isinstance(operand, float) else wrap(-operand))
+            elif op in COMPARISONS or op in ARITHMETIC:
+                store(result, arithmetic(op, value(arg1), value(arg2)))
+            elif op == "JMP":
+                pc = labels[result or arg1]
+            elif op in ("JF", "JT"):
+                if bool(value(arg1)) == (op == "JT"):
+                    pc = labels[result]
+            elif op == "SWITCH":
+                index = value(arg1) - value(arg2)
+                table = []
+                while pc < len(quads) and quads[pc][0] == "JTAB":
+                    table.append(quads[pc][3])
+                    pc += 1
+                pc = labels[table[index] if 0 <= index < len(table) else result]
+            elif op == "PARAM":
+                params.append(value(arg1))
+            elif op in ("CALL", "TAILCALL"):
+                # a TAILCALL only saves frames, which the reference does not need to
+                count = int(arg2)
+                slots = self.frames[arg1]
+                callee = {}
+                for slot, argument in zip(slots, params[len(params) - count:]):
+                    callee[slot] = convert(argument, types.get(slot))
+                del params[len(params) - count:]
+                link = frame
+                while link is not None and link[2] != self.parents[arg1]:
+                    link = link[3]
+                stack.append((pc, frame, result))
+                frame, pc = (self.frameNames[arg1], callee, arg1, link), labels[arg1]
+            elif op == "RET":
+                returned = value(arg1) if arg1 else 0
+                pc, frame, target = stack.pop()
+                if target:
+                    store(target, returned)
+            else:
+                raise RuntimeError("unknown operator " + op)
+        return globals_
+
+
+def format_value(result, kind):
+    if kind == "float":
+        return "%g" % result
+    if kind == "char":
+        return chr(result)
+    return str(result)
+
+
+def interpret(quadruples_path, symbol_table_path, names):
+    """Run the quadruples and print the listed globals the way the native program does."""
+    interpreter = QuadInterpreter(quadruples_path, symbol_table_path)
+    values = interpreter.run()
+    lines = []
+    for name in names:
+        kind = interpreter.types.get(name, "integer")
+        lines.append(f"{name} = {format_value(values.get(name, '' if kind == 'string' else 0), kind)}")
+    return "\n".join(lines) + ("\n" if lines else "")
+
+
+def timed(function, repeat):
+    times, output = [], None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        output = function()
+        times.append((time.perf_counter() - start) * 1000)
+    return statistics.median(times), output
+
+
+def benchmark(parser, compiler, program, work, flags, repeat):
+    name = os.path.splitext(os.path.basename(program))[0]
+    source = os.path.join(work, name + ".txt")
+    shutil.copyfile(program, source)
+    subprocess.run([parser, *flags, "--emit-c", source], check=True, stdout=subprocess.DEVNULL)
+    binary = os.path.join(work, name)
+    subprocess.run([compiler, "-O2", "-fwrapv", "-o", binary, os.path.join(work, name + ".c"), "-lm"], check=True)
+
+    native_ms, native = timed(lambda: subprocess.run([binary], check=True, capture_output=True, text=True).stdout, repeat)
+    names = [line.split(" = ", 1)[0] for line in native.splitlines()]
+    base = os.path.join(work, name)
+    try:
+        interpreted_ms, interpreted = timed(lambda: interpret(base + "_quadruples.txt", base + "_symbol_table.txt", names), 1)
+    except ZeroDivisionError:
+        interpreted_ms, interpreted = None, None
+    return name, native_ms, interpreted_ms, native == interpreted
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--parser", default="./parser")
+    parser.add_argument("--cc", default="gcc")
+    parser.add_argument("--corpus", default=None, help="also run the programs of this directory")
+    parser.add_argument("--work", default="bench/native", help="directory for the generated C files and binaries")
+    parser.add_argument("--repeat", type=int, default=5, help="native runs per program, the median is reported")
+    parser.add_argument("-O", dest="optimize", action="store_true", help="optimize the quadruples before translating them")
+    args = parser.parse_args()
+
+    os.makedirs(args.work, exist_ok=True)
+    programs = []
+    for name, source in KERNELS.items():
+        path = os.path.join(args.work, name + ".kernel")
+        with open(path, "w", newline="\n") as file:
+            file.write(source.lstrip())
+        programs.append(path)
+    if args.corpus:
+        programs += sorted(glob.glob(os.path.join(args.corpus, "*.txt")))
+
+    flags = ["-O"] if args.optimize else []
+    failed = False
+    print(f"{'program':<20} {'native ms':>10} {'interpreted ms':>15} {'speedup':>9}  output")
+    for program in programs:
+        name, native_ms, interpreted_ms, same = benchmark(args.parser, args.cc, program, args.work, flags, args.repeat)
+        if interpreted_ms is None:
+            print(f"{name:<20} {native_ms:>10.2f} {'-':>15} {'-':>9}  divides by zero")
+            continue
+        speedup = interpreted_ms / native_ms if native_ms > 0 else float("inf")
+        print(f"{name:<20} {native_ms:>10.2f} {interpreted_ms:>15.2f} {speedup:>8.1f}x  {'same' if same else 'DIFFERENT'}")
+        failed = failed or not same
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
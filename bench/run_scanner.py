@@ -0,0 +1,181 @@
+"""Differential test and benchmark of the fast scanner.
+
+Runs `parser --dump-tokens` on every program with the flex scanner, with
+each `--fast-scan` kernel the processor supports and with `--parallel-lex`
+cutting the input into tiny chunks, and fails when a token, its text, a line
+number or a lexical error differs. The inputs are the test programs, their
+random mutations (stray quotes, comment markers, line breaks, bytes no rule
+accepts) and a few large generated programs made mostly of whitespace,
+comments and long identifiers, which are then compiled with
+`--time-report=json` to report tokens per second of the lexing phase, also
+for `--parallel-lex` with a growing number of threads.
+"""
+
+import argparse
+import glob
+import json
+import os
+import random
+import shutil
+import statistics
+import subprocess
+import sys
+
+KERNELS = ["scalar", "sse2", "avx2"]
+# Chunks of a few bytes, so most chunk boundaries fall inside a token, comment or string
+PARALLEL_CHECKS = [["--parallel-lex=16", "-j3"], ["--parallel-lex=1", "-j8"]]
+REPORT_START = '{\n  "total_ms"'
+# Fragments the mutations insert, chosen to cut tokens and to open comments, strings and chars
+FRAGMENTS = ["/*", "*/", "*", "//", "/", '"', "'", "'x'", "''", "\n", "\t", " ", "\r", "0", "07", "1.", ".5",
+             "=", "==", "!", "!=", "&", "&&", "|", "<=", ">=", "_", "True", "whilex", "\x80", "@", "#", "\\"]
+
+
+def commented_program(rng, scale):
+    """Statements buried in block and line comments and deep indentation."""
+    lines = ["int total = 0;"]
+    for statement in range(400 * scale):
+        indent = " " * rng.randint(4, 40) + "\t" * rng.randint(0, 3)
+        lines.append(indent + "/*")
+        for _ in range(rng.randint(1, 6)):
+            lines.append(indent + " * " + " ".join(rng.choice(["the", "value", "of", "total", "is", "kept"]) for _ in range(12)))
+        lines.append(indent + " */")
+        lines.append(f"{indent}total = total + {statement};   // running sum, updated once per statement" + " " * rng.randint(0, 30))
+        lines.append("")
+    return "\n".join(lines) + "\n"
+
+
+def long_identifiers(rng, scale):
+    """Few statements over variables with very long names."""
+    names = [f"accumulated_value_of_the_{rng.choice(['inner', 'outer', 'middle'])}_loop_number_{i}_" + "x" * rng.randint(20, 80)
+             for i in range(64)]
+    lines = [f"int {name} = {index};" for index, name in enumerate(names)]
+    for _ in range(300 * scale):
+        target, left, right = rng.choice(names), rng.choice(names), rng.choice(names)
+        lines.append(f"        {target} = {left} + {right};")
+    return "\n".join(lines) + "\n"
+
+
+def string_literals(rng, scale):
+    """Long string literals, some of them spanning lines."""
+    lines = []
+    for index in range(500 * scale):
+        words = " ".join(rng.choice(["scan", "the", "string", "to", "its", "closing", "quote"]) for _ in range(rng.randint(10, 40)))
+        if index % 5 == 0:
+            words = words.replace(" the ", "\n", 1)
+        lines.append(f'string text{index} = "{words}";')
+    return "\n".join(lines) + "\n"
+
+
+WORKLOADS = {
+    "commented": commented_program,
+    "long_identifiers": long_identifiers,
+    "string_literals": string_literals,
+}
+
+
+def mutate(rng, source):
+    text = list(source)
+    for _ in range(rng.randint(1, 4)):
+        position = rng.randrange(len(text) + 1)
+        action = rng.random()
+        if action < 0.6:
+            text[position:position] = list(rng.choice(FRAGMENTS))
+        elif action < 0.9 and text:
+            del text[position:position + rng.randint(1, 3)]
+        else:
+            del text[position:]
+    return "".join(text)
+
+
+def dump(parser, path, flags):
+    process = subprocess.run([parser, "--dump-tokens", *flags, path], capture_output=True)
+    return process.returncode, process.stdout, process.stderr
+
+
+def supported_kernels(parser, work):
+    """Kernels requested by name fall back with a warning when the processor lacks them."""
+    empty = os.path.join(work, "empty.txt")
+    open(empty, "w").close()
+    return [kernel for kernel in KERNELS if b"Warning" not in dump(parser, empty, [f"--fast-scan={kernel}"])[2]]
+
+
+def lexing_rate(parser, path, flags, repeat):
+    """Tokens per second of the lexing phase, from the run with the median lexing time."""
+    runs = []
+    for _ in range(repeat):
+        output = subprocess.run([parser, "--time-report=json", *flags, path], capture_output=True, check=True).stdout.decode()
+        if output.rfind(REPORT_START) < 0:
+            raise RuntimeError("no time report in the output, build the parser with make PROFILER=1")
+        report = json.loads(output[output.rfind(REPORT_START):])
+        runs.append((report["phases"]["lex"]["ms"], report["counters"]["tokens"]))
+    milliseconds, tokens = sorted(runs)[repeat // 2]
+    return tokens, tokens / (milliseconds / 1000) if milliseconds > 0 else float("inf")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--parser", default="./parser")
+    parser.add_argument("--tests", default="tests", help="directory of the test programs")
+    parser.add_argument("--corpus", default=None, help="also compare the programs of this directory")
+    parser.add_argument("--work", default="bench/scanner", help="directory for the mutated and generated programs")
+    parser.add_argument("--mutations", type=int, default=40, help="mutated copies of every test program")
+    parser.add_argument("--scale", type=int, default=4, help="size multiplier of the generated programs")
+    parser.add_argument("--repeat", type=int, default=5, help="timed runs per program and scanner, the median is reported")
+    parser.add_argument("--seed", type=int, default=403)
+    args = parser.parse_args()
+
+    shutil.rmtree(args.work, ignore_errors=True)
+    os.makedirs(args.work)
+    rng = random.Random(args.seed)
+    kernels = supported_kernels(args.parser, args.work)
+
+    sources = [path for path in sorted(glob.glob(os.path.join(args.tests, "*.txt")))
+               if not path.endswith(("_error.txt", "_quadruples.txt", "_symbol_table.txt", "_profile.txt", "_interface.txt"))]
+    if args.corpus:
+        sources += sorted(glob.glob(os.path.join(args.corpus, "*.txt")))
+    programs = []
+    for source in sources:
+        text = open(source, newline="").read()
+        name = os.path.splitext(os.path.basename(source))[0]
+        programs.append((os.path.join(args.work, name + ".txt"), text))
+        programs += [(os.path.join(args.work, f"{name}_mutation{index}.txt"), mutate(rng, text)) for index in range(args.mutations)]
+    workloads = []
+    for name, generator in WORKLOADS.items():
+        path = os.path.join(args.work, name + ".txt")
+        programs.append((path, generator(random.Random(f"{args.seed}:{name}"), args.scale)))
+        workloads.append(path)
+
+    differences = 0
+    for path, text in programs:
+        with open(path, "w", newline="") as file:
+            file.write(text)
+        expected = dump(args.parser, path, [])
+        for flags in [[f"--fast-scan={kernel}"] for kernel in kernels] + PARALLEL_CHECKS:
+            if dump(args.parser, path, flags) != expected:
+                print(f"DIFFERENT: {path} with {' '.join(flags)}")
+                differences += 1
+    print(f"compared {len(programs)} programs with the flex scanner, the {', '.join(kernels)} kernels and "
+          f"--parallel-lex: {differences} differences")
+
+    print(f"\n{'program':<18} {'tokens':>8} {'flex tok/s':>12}" + "".join(f" {kernel + ' tok/s':>12} {'speedup':>8}" for kernel in kernels))
+    for path in workloads:
+        tokens, flex_rate = lexing_rate(args.parser, path, [], args.repeat)
+        row = f"{os.path.splitext(os.path.basename(path))[0]:<18} {tokens:>8} {flex_rate:>12.0f}"
+        for kernel in kernels:
+            rate = lexing_rate(args.parser, path, [f"--fast-scan={kernel}"], args.repeat)[1]
+            row += f" {rate:>12.0f} {rate / flex_rate:>7.2f}x"
+        print(row)
+
+    # the default chunks are large, so only the bigger programs are split
+    threads = [count for count in (1, 2, 4, 8, 16) if count <= (os.cpu_count() or 1)]
+    print(f"\n{'program':<18} {'size KB':>8}" + "".join(f" {'-j' + str(count) + ' tok/s':>13}" for count in threads))
+    for path in workloads:
+        row = f"{os.path.splitext(os.path.basename(path))[0]:<18} {os.path.getsize(path) // 1024:>8}"
+        for count in threads:
+            row += f" {lexing_rate(args.parser, path, ['--parallel-lex', f'-j{count}'], args.repeat)[1]:>13.0f}"
+        print(row)
+    sys.exit(1 if differences else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -3,9 +3,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 extern const char *inputFileName;
 
+CompilerOptions compilerOptions = {0, 0, 0, 0, 0, 12, NULL, 0, 0, 0, 0, NULL, NULL, 0, FAST_SCAN_OFF, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
 void printExitMsgToFile(const char *message) {
     const char *outputFileName = getOutputFileName(inputFileName, "_error.txt");
 
@@ -13,6 +16,7 @@ void printExitMsgToFile(const char *message) {
     if (file != NULL) {
         fprintf(file, "%s\n", message);
         fclose(file);
+        PROFILE_COUNT(COUNTER_BYTES_WRITTEN, strlen(message) + 1);
     }
 }
 
@@ -30,7 +34,94 @@ char *getOutputFileName(const char *inputFileName, const char *postfix) {
 void exitOnError(const char *message, int line) {
     static char buffer[1024];
     sprintf(buffer, "Line %d Semantic Error: %s\n", line, message);
+    finishOutputWriter();  // what was parsed before the error is written first, as without --pipeline
     fprintf(stderr, "%s", buffer);
     printExitMsgToFile(buffer);
-    exit(1);
+    exitCompiler(1);
+}
+
+// A --batch child is a fork of the batch process: it leaves the atexit handlers and static destructors to the parent
+void exitCompiler(int status) {
+    if (compilerOptions.batch) {
+        flushQuadrupleStream();
+        fflush(NULL);
+        _exit(status);
+    }
+    exit(status);
+}
+
+int parseCompilerOption(const char *option) {
+    if (strcmp(option, "-O") == 0) {
+        compilerOptions.optimize = 1;
+    } else if (strncmp(option, "-j", 2) == 0 && option[2] != '\0') {
+        compilerOptions.jobs = atoi(option + 2);
+    } else if (strcmp(option, "--pass-timing") == 0) {
+        compilerOptions.passTiming = 1;
+    } else if (strcmp(option, "--stream") == 0) {
+        compilerOptions.stream = 1;
+    } else if (strncmp(option, "--inline-threshold=", 19) == 0 && option[19] != '\0') {
+        compilerOptions.inlineThreshold = atoi(option + 19);
+    } else if (strncmp(option, "--call-graph=", 13) == 0 && option[13] != '\0') {
+        compilerOptions.callGraphPath = option + 13;
+    } else if (strcmp(option, "--emit-c") == 0) {
+        compilerOptions.emitC = 1;
+    } else if (strcmp(option, "--line-numbers") == 0) {
+        compilerOptions.lineNumbers = 1;
+    } else if (strcmp(option, "--run") == 0) {
+        compilerOptions.run = 1;
+    } else if (strcmp(option, "--profile-lines") == 0) {
+        compilerOptions.run = 1;
+        compilerOptions.profileLines = 1;
+    } else if (strcmp(option, "-fprofile-generate") == 0) {
+        compilerOptions.run = 1;
+        compilerOptions.profileGeneratePath = "";
+    } else if (strncmp(option, "-fprofile-generate=", 19) == 0 && option[19] != '\0') {
+        compilerOptions.run = 1;
+        compilerOptions.profileGeneratePath = option + 19;
+    } else if (strcmp(option, "-fprofile-use") == 0) {
+        compilerOptions.profileUsePath = "";
+    } else if (strncmp(option, "-fprofile-use=", 14) == 0 && option[14] != '\0') {
+        compilerOptions.profileUsePath = option + 14;
+    } else if (strcmp(option, "--mem-report") == 0) {
+        compilerOptions.memReport = 1;
+    } else if (strcmp(option, "--fast-scan") == 0) {
+        compilerOptions.fastScan = FAST_SCAN_AUTO;
+    } else if (strcmp(option, "--fast-scan=scalar") == 0) {
+        compilerOptions.fastScan = FAST_SCAN_SCALAR;
+    } else if (strcmp(option, "--fast-scan=sse2") == 0) {
+        compilerOptions.fastScan = FAST_SCAN_SSE2;
+    } else if (strcmp(option, "--fast-scan=avx2") == 0) {
+        compilerOptions.fastScan = FAST_SCAN_AVX2;
+    } else if (strcmp(option, "--parallel-lex") == 0) {
+        compilerOptions.parallelLex = 1;
+    } else if (strncmp(option, "--parallel-lex=", 15) == 0 && option[15] != '\0') {
+        compilerOptions.parallelLex = 1;
+        compilerOptions.parallelLexChunk = atoi(option + 15);
+    } else if (strcmp(option, "--pipeline") == 0) {
+        compilerOptions.pipeline = 1;
+    } else if (strcmp(option, "--emit-interface") == 0) {
+        compilerOptions.emitInterface = 1;
+    } else if (strcmp(option, "--batch") == 0) {
+        compilerOptions.batch = 1;
+        compilerOptions.run = 1;
+    } else if (strncmp(option, "--max-instructions=", 19) == 0 && option[19] != '\0') {
+        compilerOptions.maxInstructions = atoll(option + 19);
+    } else if (strncmp(option, "--timeout=", 10) == 0 && option[10] != '\0') {
+        compilerOptions.timeoutMs = atoi(option + 10);
+    } else if (strcmp(option, "--memoize") == 0) {
+        compilerOptions.run = 1;
+        compilerOptions.memoize = 1024;
+    } else if (strncmp(option, "--memoize=", 10) == 0 && atoi(option + 10) > 0) {
+        compilerOptions.run = 1;
+        compilerOptions.memoize = atoi(option + 10);
+    } else if (strcmp(option, "--dump-tokens") == 0) {
+        compilerOptions.dumpTokens = 1;
+    } else if (strcmp(option, "--time-report") == 0) {
+        compilerOptions.timeReport = 1;
+    } else if (strcmp(option, "--time-report=json") == 0) {
+        compilerOptions.timeReport = 2;
+    } else {
+        return 0;
+    }
+    return 1;
 }
@@ -25,10 +25,122 @@ typedef enum {
 
 typedef struct {
     Type type;
-    const char* name;
+    const char* name;  // text of a variable or literal, NULL for a computed value
     int line;
+    void* node;        // syntax tree computing the value
 } ExprValue;
 
+typedef struct {
+    int optimize;    // -O: run the optimization pipeline on the final quadruples
+    int jobs;        // -j<n>: worker threads for the optimizer, 0 means one per hardware thread
+    int passTiming;  // --pass-timing: print per pass statistics
+    int timeReport;  // --time-report: 1 prints a table, 2 (--time-report=json) prints JSON
+    int stream;      // --stream: write the quadruples of every top level statement as soon as it is parsed
+    int inlineThreshold;  // --inline-threshold=<n>: largest function body (in quadruples) inlined by -O, 0 disables inlining
+    const char* callGraphPath;  // --call-graph=<file>: write the call graph of the final quadruples in DOT format
+    int emitC;                  // --emit-c: translate the final quadruples to a C program next to the input file
+    int lineNumbers;            // --line-numbers: add the source line of every quadruple to _quadruples.txt
+    int run;                    // --run: execute the final quadruples and print the global variables
+    int profileLines;           // --profile-lines: --run counting instructions and time per source line and function
+    const char* profileGeneratePath;  // -fprofile-generate[=<file>]: --run recording how often every jump is taken
+    const char* profileUsePath;       // -fprofile-use[=<file>]: order switch tests and lay out blocks by that record
+    int memReport;                    // --mem-report: print live and peak heap bytes per compiler subsystem
+    int fastScan;                     // --fast-scan[=<kernel>]: lex with the vectorized scanner, a FastScanKernel
+    int dumpTokens;                   // --dump-tokens: print every token with its line and stop before parsing
+    int parallelLex;                  // --parallel-lex[=<bytes>]: scan chunks of the input on -j threads before parsing
+    int parallelLexChunk;             // the <bytes> of --parallel-lex, the smallest chunk worth a thread; 0 for the default
+    int pipeline;                     // --pipeline: lex, parse and write the output files on three threads
+    int emitInterface;                // --emit-interface: compile a module and only write its _interface.txt
+    int batch;                        // --batch: the input lists programs to compile and run, -j of them at a time
+    long long maxInstructions;        // --max-instructions=<n>: runtime error once --run executed that many, 0 for no limit
+    int timeoutMs;                    // --timeout=<ms>: --batch kills a program still running after that long, 0 for none
+    int memoize;                      // --memoize[=<entries>]: --run caching the results of pure functions, 0 when off
+} CompilerOptions;
+
+// Vector kernels of the fast scanner. FAST_SCAN_OFF keeps the flex scanner, FAST_SCAN_AUTO picks the widest
+// one the processor supports.
+typedef enum {
+    FAST_SCAN_OFF,
+    FAST_SCAN_AUTO,
+    FAST_SCAN_SCALAR,
+    FAST_SCAN_SSE2,
+    FAST_SCAN_AVX2
+} FastScanKernel;
+
+extern CompilerOptions compilerOptions;
+
+// Compiler phases measured by --time-report. Phases nest (lexing happens inside parsing),
+// each one is reported with its self time only.
+typedef enum {
+    PHASE_LEX,
+    PHASE_PARSE,
+    PHASE_SEMANTIC,
+    PHASE_IR,
+    PHASE_OPTIMIZE,
+    PHASE_OUTPUT_SYMBOL_TABLE,
+    PHASE_OUTPUT_QUADRUPLES,
+    PHASE_OUTPUT_WARNINGS,
+    PHASE_COUNT
+} ProfilerPhase;
+
+typedef enum {
+    COUNTER_TOKENS,
+    COUNTER_SYMBOL_LOOKUPS,
+    COUNTER_SCOPES_SEARCHED,
+    COUNTER_MAX_SCOPE_DEPTH,
+    COUNTER_QUADS_EMITTED,
+    COUNTER_QUADS_COPIED,  // copied from one list to another: linking a module, merging the optimized units
+    COUNTER_BYTES_WRITTEN,
+    COUNTER_ALLOCATIONS,  // C++ heap allocations (operator new)
+    COUNTER_COUNT
+} ProfilerCounter;
+
+// Owners of heap memory reported by --mem-report. C++ allocations are charged to the subsystem of the
+// phase running when they are made (lexer: lex, parser values: parse, symbols: semantic, IR: ir and
+// optimize, output: the writers), C allocations and the arena blocks are charged where they are made.
+typedef enum {
+    MEMORY_LEXER,
+    MEMORY_PARSER_VALUES,
+    MEMORY_AST,  // the arena holding the syntax tree of a top level statement
+    MEMORY_SYMBOLS,
+    MEMORY_IR,
+    MEMORY_OUTPUT,
+    MEMORY_OTHER,  // outside of any phase: startup, --emit-c, --run
+    MEMORY_SUBSYSTEM_COUNT
+} MemorySubsystem;
+
+// The profiler is only compiled in with -DENABLE_PROFILER, otherwise every hook expands to nothing. Compiled in,
+// a hook only tests profilerEnabled unless --time-report or --mem-report asked for a report.
+// Phases and counters are only recorded on the main thread, calls from other threads are ignored.
+#ifdef ENABLE_PROFILER
+extern int profilerEnabled;
+void startTimeReport(void);
+void profilerBeginPhase(ProfilerPhase phase);
+void profilerEndPhase(ProfilerPhase phase);
+void profilerAddToCounter(ProfilerCounter counter, long long amount);
+void profilerUpdateMaxCounter(ProfilerCounter counter, long long value);
+void printTimeReport(int asJson);
+void startMemoryReport(void);
+void profilerRecordAllocation(MemorySubsystem subsystem, long long bytes);
+void printMemoryReport(void);
+#define PROFILE_BEGIN(phase) do { if (profilerEnabled) profilerBeginPhase(phase); } while (0)
+#define PROFILE_END(phase) do { if (profilerEnabled) profilerEndPhase(phase); } while (0)
+#define PROFILE_COUNT(counter, amount) do { if (profilerEnabled) profilerAddToCounter(counter, amount); } while (0)
+#define PROFILE_MAX(counter, value) do { if (profilerEnabled) profilerUpdateMaxCounter(counter, value); } while (0)
+// A malloc made by C code, which operator new does not see; they are never freed
+#define PROFILE_ALLOCATION(subsystem, bytes) do { if (profilerEnabled) profilerRecordAllocation(subsystem, bytes); } while (0)
+#else
+#define startTimeReport()
+#define PROFILE_BEGIN(phase)
+#define PROFILE_END(phase)
+#define PROFILE_COUNT(counter, amount)
+#define PROFILE_MAX(counter, value)
+#define printTimeReport(asJson) printf("Time report unavailable: build with make PROFILER=1\n")
+#define PROFILE_ALLOCATION(subsystem, bytes)
+#define startMemoryReport()
+#define printMemoryReport() printf("Memory report unavailable: build with make PROFILER=1\n")
+#endif
+
 void enterScope();
 void exitScope(int line);
 void addSymbolToSymbolTable(void* symbol);
@@ -42,56 +154,82 @@ void printSymbolTable(const char* inputFileName);
 void printUnusedSymbols(const char* inputFileName);
 Type getSymbolType(void* symbol);
 void exitOnError(const char* message, int line);
+void exitCompiler(int status);
 void printExitMsgToFile(const char* message);
 void* createArgumentList();
 void addVariableToArgumentList(void* argumentList, void* variable);
 void* createFunction(Type returnType, const char* name, void* argumentList, int line);
 void* createParamList();
-void addParamToParamList(void* paramList, const char* name, Type type);
+void addParamToParamList(void* paramList, void* node, Type type);
 void checkParamListAgainstFunction(void* paramList, void* function, int line);
 void checkVariableIsNotConstant(void* symbol, int line);
 void* getVariableFromSymbolTable(const char* name, int line);
 void setVariableAsInitialized(void* symbol);
+void setVariableAsDeclaredWithoutValue(void* symbol);
 void checkReturnStatementIsValid(Type returnType, int line);
 
 void* createSwitchCaseList();
-void addCaseToSwitchCaseList(void* switchCaseList, Type type, int line);
+void addCaseToSwitchCaseList(void* switchCaseList, Type type, int line, const char* value, void* body);
 void checkSwitchCaseListAgainstType(void* switchCaseList, Type type);
+void checkSwitchCaseListForDuplicates(void* switchCaseList);
 
 void addQuadruple(const char* op, const char* arg1, const char* arg2, const char* result);
-const char* newTemp();
-const char* newLabel();
 void printQuadruples(const char* inputFileName);
+void beginQuadrupleStream(const char* inputFileName);
+void flushStatementQuadruples();
+void flushQuadrupleStream(void);
+void optimizeQuadruples();
+void printPassStatistics();
+void writeCallGraph(const char* path);
+void writeCProgram(const char* inputFileName);
+int runProgram(const char* inputFileName);
+// Compiles and runs every program listed in listFileName, one path per line, in a child process forked for it so
+// that it starts from the untouched compiler state, and writes the results to <list>_batch.txt
+int runBatch(const char* listFileName, int (*compileFile)(const char* fileName));
+// Declares the functions of a module from its cached interface, compiling the module first when the cache is
+// missing or stale, and returns the statement linking its quadruples (NULL when it was imported already)
+void* importModule(const char* name, int line);
+void writeModuleInterface(const char* inputFileName);
 
-void enterQuadManager();
-void* exitQuadManager();
-void mergeQuadManagerToCurrentQuadManager(void* quadManager);
-void mergeQuadManagerToCurrentQuadManagerInFront(void* quadManager);
-void addQuadrupleToCurrentQuadManager(const char* op, const char* arg1, const char* arg2, const char* result);
-const char* generateNewExitLabelFromCurrentQuadManager();
-const char* getExitLabelFromCurrentQuadManager();
-void addQuadrupleToQuadManager(void* quadManager, const char* op, const char* arg1, const char* arg2, const char* result);
-void addQuadrupleToQuadManagerInFront(void* quadManager, const char* op, const char* arg1, const char* arg2, const char* result);
-
-void addCaseExpression(const char* expr);
-const char* getCurrentCaseExpression();
-void removeLastCaseExpression();
+// Semantic values and token text live as long as the syntax tree of the top level statement they belong to
+ExprValue* allocateExprValue(void);
+char* copyParserText(const char* text);
+char* copyLexerText(const char* text);
+// The syntax tree, in the arena of the current top level statement. Nodes are tagged with the line being parsed.
+// createCallNode and createSwitchNode free the list they are given.
+void* createNameNode(const char* name);
+void* createBinaryNode(const char* op, void* left, void* right);
+void* createLogicalNode(const char* op, void* left, void* right);
+void* createNegateNode(void* operand);
+void* createCallNode(void* function, void* paramList);
+void* createAssignNode(const char* variable, void* value);
+void* createIfNode(void* condition, void* body, void* elseBody);
+void* createWhileNode(void* condition, void* body);
+void* createRepeatNode(void* body, void* condition);
+void* createForNode(void* initialization, void* condition, void* step, void* body);
+void* createSwitchNode(void* value, void* switchCaseList);
+void* createFunctionNode(void* function, void* body);
+void* createReturnNode(void* value);
+void* createImportNode(void* module);
+// Statements are added to the innermost open block, closeBlock returns it; at the top level
+// flushStatementQuadruples lowers them
+void openBlock();
+void* closeBlock();
+void addStatementToCurrentBlock(void* statement);
 
 const char* convertFloatNumToChar(float num);
 const char* convertIntNumToChar(int num);
 const char* convertNumToChar(void* num, Type type);
 
-void setFunctionLabel(void* function, const char* label);
-const char* getFunctionLabel(void* function);
-void handleFunctionQuadruples(void* quadManager, void* function);
-void handleFunctionReturnQuadruples();
-void handleFunctionReturnWithExprQuadruples(const char* expr);
-void handleFunctionCallQuadruples(void* function, void* paramList, const char* returnVar);
-void handleForLoopQuadruples(const char* booleanExprVar, void* booleanExprQuadManager, void* assignmentQuadManager, void* scopeQuadManager);
-void handleRepeatUntilQuadruples(const char* booleanExprVar, void* booleanExprQuadManager, void* scopeQuadManager);
-void handleWhileQuadruples(const char* booleanExprVar, void* booleanExprQuadManager, void* scopeQuadManager);
+char* copyTokenText(const char* text);
+int fastScanToken(void);
+int parallelScanToken(void);
+int pipelineScanToken(void);
+// Waits until the --pipeline writer thread wrote everything given to it, nothing to do without --pipeline
+void finishOutputWriter(void);
 
 char* getOutputFileName(const char* inputFileName, const char* postfix);
+int parseCompilerOption(const char* option);
 #ifdef __cplusplus
 }
 #endif
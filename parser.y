@@ -12,6 +12,20 @@
     extern int yydebug;     // for debugging. This variable stores the current debugging level
     #define DEBUG
     const char* inputFileName;
+    const char* compilerPath;  // argv[0], run again to compile the modules that are imported
+
+    // Semantic values are dropped together with the syntax tree once their top level statement is lowered
+    static ExprValue* newExprValue(void) {
+        return allocateExprValue();
+    }
+    static char* copyValueText(const char* text) {
+        return copyParserText(text);
+    }
+    // Char literals keep their quotes, so 'b' is not taken for the variable b ('' is the null char)
+    static char* copyCharText(char character) {
+        char text[4] = {'\'', character, '\'', '\0'};
+        return copyParserText(character != '\0' ? text : "''");
+    }
 %}
 
 // The union is used to define the types of the tokens. Since the datatypes that we will work with are  either int/float, char/string, and boolean, we will use a union to define the types of the tokens   
@@ -22,6 +36,7 @@
     char* string;           // string value
     Type type;              // data type
     void* list;             // list of parameters
+    void* node;             // syntax tree of a statement
     // bool boolean;        // boolean value
     ExprValue *exprValue;   // expression value
 };
@@ -40,163 +55,114 @@
 %token <string> CHARARRAY
 %token STRING
 %token <string> VARIABLE
-%token CONST REPEAT UNTIL FOR SWITCH CASE IF THEN ELSE RETURN WHILE FUNCTION VOID GE LE EQ NE
+%token CONST REPEAT UNTIL FOR SWITCH CASE IF THEN ELSE RETURN WHILE FUNCTION VOID GE LE EQ NE IMPORT
 // %type <floating> expression caseExpression
 
 %nonassoc '='       // non-associative token. This means that the token cannot be used in a chain of tokens like a=b=c, but can be used in a=b
-%left '||'           // left associative token. This means that the token is evaluated from left to right a | b | c -> (a | b) | c
-%left '&&'
+%left '|'           // left associative token. This means that the token is evaluated from left to right a | b | c -> (a | b) | c
+%left '&'
 %left '<' '>' GE LE EQ NE
 %left '+' '-'
 %left '*' '/'
 %right '^'          // right associative token. This means that the token is evaluated from right to left a ^ b ^ c -> a ^ (b ^ c)
 
 %type <type> dataType 
-%type <exprValue> expression functionCall  caseCondition CASE_EXPRESSION BOOLEAN_EXPRESSION
-%type <list> arguments argumentsList parameters parametersList case SCOPE_CLOSE scope FUNCTION_SIGNATURE CLOSE_QUAD_MANAGER
+%type <exprValue> expression functionCall  caseCondition BOOLEAN_EXPRESSION
+%type <list> arguments argumentsList parameters parametersList case FUNCTION_SIGNATURE
+%type <node> statement initialization declaration assignment forLoopInitialization scope SCOPE_CLOSE
 
 %%
 // The grammar rules are defined here. The grammar rules define the structure of the language. They define how the tokens are combined to form statements, expressions, etc.
 
+// left recursive so every statement is reduced as soon as it ends instead of piling up on the stack until the end of the file
 program:
-    statement ';' program                       { debugPrintf("statement\n"); }
+    program statement ';'                       { 
+                                                    debugPrintf("statement\n");
+                                                    addStatementToCurrentBlock($2);
+                                                    flushStatementQuadruples();
+                                                }
     | /* NULL */
-    | ';' program
+    | program ';'
     ;
 
 statement:
-    initialization                                                      { debugPrintf("initialization\n");}
-    | WHILE '(' OPEN_QUAD_MANAGER BOOLEAN_EXPRESSION CLOSE_QUAD_MANAGER ')' scope                                    
+    initialization                                                      { debugPrintf("initialization\n"); $$ = $1; }
+    | WHILE '(' BOOLEAN_EXPRESSION ')' scope                                    
                                                                                         { 
-                                                                                            ExprValue* booleanExpr = $4;
-                                                                                            const char* booleanExprName = booleanExpr->name;
-                                                                                            void* booleanExprQuadManager = $5;
-                                                                                            void* scopeQuadManager = $7;
-                                                                                            handleWhileQuadruples(booleanExprName,booleanExprQuadManager,scopeQuadManager);
+                                                                                            ExprValue* booleanExpr = $3;
+                                                                                            void* scope = $5;
+                                                                                            $$ = createWhileNode(booleanExpr->node, scope);
                                                                                         }
-    | REPEAT scope UNTIL '(' OPEN_QUAD_MANAGER BOOLEAN_EXPRESSION CLOSE_QUAD_MANAGER')' 
+    | REPEAT scope UNTIL '(' BOOLEAN_EXPRESSION ')' 
                                                                                         { 
-                                                                                            ExprValue* booleanExpr = $6;
-                                                                                            const char* booleanExprName = booleanExpr->name;
-                                                                                            void* booleanExprQuadManager = $7;
-                                                                                            void* scopeQuadManager = $2;
-                                                                                            handleRepeatUntilQuadruples(booleanExprName,booleanExprQuadManager,scopeQuadManager);
+                                                                                            ExprValue* booleanExpr = $5;
+                                                                                            void* scope = $2;
+                                                                                            $$ = createRepeatNode(scope, booleanExpr->node);
                                                                                         }
-    | FOR '(' forLoopInitialization ';'OPEN_QUAD_MANAGER BOOLEAN_EXPRESSION CLOSE_QUAD_MANAGER ';' OPEN_QUAD_MANAGER assignment CLOSE_QUAD_MANAGER ')' scope
+    | FOR '(' forLoopInitialization ';' BOOLEAN_EXPRESSION ';' assignment ')' scope
                                                                                                 { 
-                                                                                                    ExprValue* booleanExpr = $6;
-                                                                                                    const char* booleanExprName = booleanExpr->name;
-                                                                                                    void* booleanExprQuadManager = $7;
-                                                                                                    void* assignmentQuadManager = $11;
-                                                                                                    void* scopeQuadManager = $13;
-                                                                                                    handleForLoopQuadruples(booleanExprName,booleanExprQuadManager,assignmentQuadManager,scopeQuadManager);
+                                                                                                    void* initialization = $3;
+                                                                                                    ExprValue* booleanExpr = $5;
+                                                                                                    void* assignment = $7;
+                                                                                                    void* scope = $9;
+                                                                                                    $$ = createForNode(initialization, booleanExpr->node, assignment, scope);
                                                                                                 }
-    | SWITCH '(' CASE_EXPRESSION ')' '{' case '}'                            { 
+    | SWITCH '(' expression ')' '{' case '}'                            { 
                                                                             void* switchCaseList = $6;
                                                                             ExprValue* switchExpression = $3;
                                                                             Type expressionType = switchExpression->type;
                                                                             checkSwitchCaseListAgainstType(switchCaseList,expressionType);
+                                                                            checkSwitchCaseListForDuplicates(switchCaseList);
 
-                                                                            const char* exitLabel = getExitLabelFromCurrentQuadManager();
-                                                                            addQuadrupleToCurrentQuadManager(exitLabel, "", "", "");
-                                                                            removeLastCaseExpression();
-
-                                                                            void* quadManager = exitQuadManager();
-                                                                            mergeQuadManagerToCurrentQuadManager(quadManager);
+                                                                            $$ = createSwitchNode(switchExpression->node,switchCaseList);
                                                                         }
     | scope                                                             { 
                                                                             debugPrintf("scope\n");
-
-                                                                            void* quadManager = $1;
-                                                                            mergeQuadManagerToCurrentQuadManager(quadManager);
+                                                                            $$ = $1;
                                                                         }
     | IF '(' expression ')' THEN scope                                  { 
                                                                             debugPrintf("if\n");
 
-                                                                            const char* label = newLabel();
                                                                             ExprValue* expr = $3;
-                                                                            const char* exprName = expr->name;
-                                                                            addQuadrupleToCurrentQuadManager("JF", exprName, "", label);
-
-                                                                            void* quadManager = $6;
-                                                                            mergeQuadManagerToCurrentQuadManager(quadManager);
-                                                                            
-                                                                            addQuadrupleToCurrentQuadManager(label, "", "", "");
+                                                                            void* scope = $6;
+                                                                            $$ = createIfNode(expr->node, scope, NULL);
                                                                          }
     | IF '(' expression ')'  THEN scope ELSE scope      {
                                                                             debugPrintf("if else\n");
 
-                                                                            const char* elseLabel = newLabel();
                                                                             ExprValue* expr = $3;
-                                                                            const char* exprName = expr->name;
-                                                                            addQuadrupleToCurrentQuadManager("JF", exprName, "", elseLabel);
-
-                                                                            void* scopeMgr1 = $6;
-                                                                            mergeQuadManagerToCurrentQuadManager(scopeMgr1);
-                                                                            
-                                                                            const char* endLabel = newLabel();
-                                                                            addQuadrupleToCurrentQuadManager("JMP", "", "", endLabel);
-
-                                                                            addQuadrupleToCurrentQuadManager(elseLabel, "", "", "");
-
-                                                                            void* scopeMgr2 = $8;
-                                                                            mergeQuadManagerToCurrentQuadManager(scopeMgr2);
-
-                                                                            addQuadrupleToCurrentQuadManager(endLabel, "", "", "");
-
+                                                                            void* scope1 = $6;
+                                                                            void* scope2 = $8;
+                                                                            $$ = createIfNode(expr->node, scope1, scope2);
                                                                         }
     | FUNCTION_SIGNATURE scope                                          {  
                                                                             void* function = $1;
-                                                                            void* quadManager = $2;
-                                                                            const char* skipFunctionLabel = newLabel();
-                                                                            addQuadrupleToCurrentQuadManager("JMP", "", "", skipFunctionLabel);
-                                                                            const char* functionLabel = getFunctionLabel(function);
-
-                                                                            addQuadrupleToCurrentQuadManager(functionLabel, "", "", "");
-                                                                            
-                                                                            handleFunctionQuadruples(quadManager,function);
-                                                                            mergeQuadManagerToCurrentQuadManager(quadManager);
-                                                                            
-                                                                            addQuadrupleToCurrentQuadManager(skipFunctionLabel, "", "", "");
+                                                                            void* scope = $2;
+                                                                            $$ = createFunctionNode(function, scope);
                                                                         }
                                                                         
-    | functionCall                                                      { debugPrintf("function call\n"); }
+    | functionCall                                                      { debugPrintf("function call\n"); $$ = $1->node; }
     | RETURN expression                                                 { 
                                                                             ExprValue* returnValue = $2;
                                                                             Type returnType = returnValue->type;
-                                                                            const char* returnName = returnValue->name;
                                                                             checkReturnStatementIsValid(returnType,yylineno);
-                                                                            handleFunctionReturnWithExprQuadruples(returnName);
+                                                                            $$ = createReturnNode(returnValue->node);
                                                                         }
                                                                         
     | RETURN                                                            { 
                                                                             checkReturnStatementIsValid(VOID_T,yylineno);
-                                                                            handleFunctionReturnQuadruples();
+                                                                            $$ = createReturnNode(NULL);
                                                                         }                                                               
+    | IMPORT CHARARRAY                                                  {
+                                                                            $$ = importModule($2,yylineno);
+                                                                        }
     ;
 
-OPEN_QUAD_MANAGER:
-     /* NULL */                                { enterQuadManager(); }
-    ;
-CLOSE_QUAD_MANAGER:
-     /* NULL */                                { $$ = exitQuadManager(); }
-    ;
-CASE_EXPRESSION:
-    expression                                          { 
-                                                            $$ = $1;
-                                                            const char* caseExpressionVariable = $1->name;
-                                                            enterQuadManager();
-                                                            addCaseExpression(caseExpressionVariable);
-                                                         }
-
 FUNCTION_SIGNATURE:
     FUNCTION dataType VARIABLE '(' arguments ')'       { 
                                                             void* parametersList = $5;
                                                             void* function = createFunction($2,$3,parametersList,yylineno);
                                                             addSymbolToSymbolTable(function);
-
-                                                            const char* functionLabel = newLabel();
-                                                            setFunctionLabel(function,functionLabel);
                                                             
                                                             $$ = function;
                                                         }
@@ -204,22 +170,19 @@ FUNCTION_SIGNATURE:
                                                             void* parametersList = $5;
                                                             void* function = createFunction(VOID_T,$3,parametersList,yylineno);
                                                             addSymbolToSymbolTable(function);
-                                                            
-                                                            const char* functionLabel = newLabel();
-                                                            setFunctionLabel(function,functionLabel);
 
                                                             $$ = function;
                                                         }
     ;
 
 forLoopInitialization:
-    assignment |
-    //NULL
+    assignment          { $$ = $1; }
+    | /* NULL */        { $$ = NULL; }
     ;
 
 initialization:
-    declaration                                 { debugPrintf("declaration\n"); }
-    | assignment                                { debugPrintf("assignment\n"); }
+    declaration                                 { debugPrintf("declaration\n"); $$ = $1; }
+    | assignment                                { debugPrintf("assignment\n"); $$ = $1; }
     ;
 
 scope:
@@ -230,7 +193,7 @@ SCOPE_OPEN:
     '{'                                         { 
                                                     debugPrintf("Scope Open\n"); 
                                                     enterScope();
-                                                    enterQuadManager();
+                                                    openBlock();
                                                 }
     ;
 
@@ -238,19 +201,20 @@ SCOPE_CLOSE:
     '}'                                         { 
                                                     debugPrintf("Scope Close\n");
                                                     exitScope(yylineno);
-                                                    void* quadManager = exitQuadManager();
-                                                    $$ = quadManager;
+                                                    void* block = closeBlock();
+                                                    $$ = block;
                                                 }
     ;
 
 declaration:
     dataType VARIABLE                           {      
                                                         void* variable = createVariable($1,$2, yylineno,0);
+                                                        setVariableAsDeclaredWithoutValue(variable);
                                                         addSymbolToSymbolTable(variable);
+                                                        $$ = NULL;
                                                 }
     | dataType VARIABLE '=' expression          { 
                                                         const char* varName = $2;
-                                                        const char* assignmentName = $4->name;
                                                         Type varType = $1;
                                                         Type assignmentType = $4->type;
                                                         void* variable = createVariable(varType,varName, yylineno,0);
@@ -261,15 +225,14 @@ declaration:
                                                         addSymbolToSymbolTable(variable);
                                                         
                                                         
-                                                        debugPrintf("Variable: %s = %s\n", varName, assignmentName);
+                                                        debugPrintf("Variable: %s\n", varName);
                                                         
 
-                                                        addQuadrupleToCurrentQuadManager("ASSIGN", assignmentName, "", varName);
+                                                        $$ = createAssignNode(varName, $4->node);
                                                 }
     | CONST dataType VARIABLE '=' expression {     
                                                         Type varType = $2;
                                                         const char* varName = $3;
-                                                        const char* assignmentName = $5->name;
                                                         void* variable = createVariable(varType,varName, yylineno,1);
                                                         Type assignmentType = $5->type;
                                                         Type variableType = $2;
@@ -278,9 +241,9 @@ declaration:
                                                         
                                                         setVariableAsInitialized(variable);
                                                         
-                                                        debugPrintf("Variable: %s = %s\n", varName, assignmentName);
+                                                        debugPrintf("Variable: %s\n", varName);
                                                         
-                                                        addQuadrupleToCurrentQuadManager("ASSIGN", assignmentName, "", varName);
+                                                        $$ = createAssignNode(varName, $5->node);
                                                   }
     ;
 
@@ -295,7 +258,6 @@ dataType:
 assignment:
     VARIABLE '=' expression             {
                                             const char* varName = $1;
-                                            const char* valName = $3->name;
                                             void* variable = getSymbolFromSymbolTable(varName,yylineno);
                                             Type assignmentType = $3->type;
                                             Type variableType = getSymbolType(variable);
@@ -306,59 +268,60 @@ assignment:
                                             checkBothParamsAreOfSameType(variableType,assignmentType,yylineno);
                                             
                                             debugPrintf("Assignment\n");
-                                            debugPrintf("Variable: %s = %s\n", varName, valName);
+                                            debugPrintf("Variable: %s\n", varName);
                                             
-                                            addQuadrupleToCurrentQuadManager("ASSIGN", valName, "", varName);
+                                            $$ = createAssignNode(varName, $3->node);
                                         }
                                        
     ;
 
 expression:
     VARIABLE                    { 
-                                    const char* val = strdup($1);
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    const char* val = copyValueText($1);
+                                    ExprValue* returnValue = newExprValue();
                                     void* variable = getVariableFromSymbolTable(val,yylineno);
                                     returnValue->type = getSymbolType(variable);
                                     
                                     returnValue->name = val;
+                                    returnValue->node = createNameNode(val);
                                     $$ = returnValue;
                                 }
     | INTEGER                   { 
-                                    const char* val = strdup(convertIntNumToChar($1));
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    const char* val = convertIntNumToChar($1);
+                                    ExprValue* returnValue = newExprValue();
                                     returnValue->type = INTEGER_T;
-                                    int* valInt = (int*)malloc(sizeof(int));
-                                    *valInt = $1;
                                     
                                     returnValue->name = val;
+                                    returnValue->node = createNameNode(val);
                                     $$ = returnValue;
 
                                 }
     | FLOATING                  {             
-                                    const char* val = strdup(convertFloatNumToChar($1));
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    const char* val = convertFloatNumToChar($1);
+                                    ExprValue* returnValue = newExprValue();
                                     returnValue->type = FLOAT_T;
                                    
                                     returnValue->name = val;
+                                    returnValue->node = createNameNode(val);
                                     $$ = returnValue;
 
                                 }
     | BOOLEAN                   { 
-                                    const char* val = strdup(convertIntNumToChar($1));
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    const char* val = convertIntNumToChar($1);
+                                    ExprValue* returnValue = newExprValue();
                                     returnValue->type = BOOLEAN_T;
                                     
                                     returnValue->name = val;
+                                    returnValue->node = createNameNode(val);
                                     $$ = returnValue;
                                 }
     | CHARACTER                 { 
-                                    char* val = malloc(sizeof(char)*2);
-                                    val[0] = $1;
-                                    val[1] = '\0';
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    const char* val = copyCharText($1);
+                                    ExprValue* returnValue = newExprValue();
                                     
                                     returnValue->type = CHAR_T;
                                     returnValue->name = val;
+                                    returnValue->node = createNameNode(val);
                                     $$ = returnValue;
 
                                     
@@ -366,12 +329,13 @@ expression:
                                    
                                 }
     | CHARARRAY                 {
-                                    const char* val = strdup($1);
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    const char* val = copyValueText($1);
+                                    ExprValue* returnValue = newExprValue();
                                     
                                     returnValue->type = STRING_T;
                                     
                                     returnValue->name = val;
+                                    returnValue->node = createNameNode(val);
                                     $$ = returnValue;
 
                                     
@@ -379,323 +343,189 @@ expression:
                                 }
     | functionCall              { $$ = $1; }
     | expression '+' expression {
-                                    ExprValue* expr1 = $1;
-                                    ExprValue* expr2 = $3;
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("ADD", expr1Name, expr2Name, tempVar);
 
                                     returnValue->type = expr1Type;
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-
-                                     
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("ADD", $1->node, $3->node);
+                                    $$ = returnValue;
                                 }
     | expression '-' expression {
-                                    ExprValue* expr1 = $1;
-                                    ExprValue* expr2 = $3;
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("SUB", expr1Name, expr2Name, tempVar);
 
                                     returnValue->type = expr1Type;
-                                    
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                    
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("SUB", $1->node, $3->node);
+                                    $$ = returnValue;
                                 }
     | expression '*' expression {
-                                    ExprValue* expr1 = $1;
-                                    ExprValue* expr2 = $3;
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("MUL", expr1Name, expr2Name, tempVar);
 
                                     returnValue->type = expr1Type;
-                                   
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-
-                                    
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("MUL", $1->node, $3->node);
+                                    $$ = returnValue;
                                 }
     | expression '/' expression {
-                                    ExprValue* expr1 = $1;
-                                    ExprValue* expr2 = $3;
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("DIV", expr1Name, expr2Name, tempVar);
 
                                     returnValue->type = expr1Type;
-                              
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-
-                                     
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("DIV", $1->node, $3->node);
+                                    $$ = returnValue;
                                 }
     | expression '^' expression {
-                                     ExprValue* expr1 = $1;
-                                    ExprValue* expr2 = $3;
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("POW", expr1Name, expr2Name, tempVar);
 
                                     returnValue->type = expr1Type;
-                                  
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-
-                                    
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("POW", $1->node, $3->node);
+                                    $$ = returnValue;
                                 }
     | '-' expression             {
-                                    const char* tempVar = newTemp();
-                                    const char* exprName = $2->name;
                                     Type exprType = $2->type;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
                                     
                                     checkParamIsNumber(exprType,yylineno);
 
                                     returnValue->type = exprType;
-                                    
-
-                                    returnValue->name = tempVar;
-                                    addQuadrupleToCurrentQuadManager("NEG", "", exprName, tempVar);
+                                    returnValue->name = NULL;
+                                    returnValue->node = createNegateNode($2->node);
                                     $$ = returnValue;
-     
-                                    debugPrintf("Name of expression: %s\n", exprName);
-                                    debugPrintf("Name of result: %s\n", tempVar);
-                                   
-                                    
                                  }
     | '(' expression ')'        { $$ = $2; }
     | BOOLEAN_EXPRESSION        { $$ = $1; }
+    ;
 
 BOOLEAN_EXPRESSION:
-    expression '||' expression {
+    expression '|' expression   {
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
+
                                     checkBothParamsAreBoolean(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("OR", expr1Name, expr2Name, tempVar);
-                                    returnValue->type = BOOLEAN_T;
-                                    
-                                    
-                                    
 
-                                    returnValue->name = tempVar;
+                                    returnValue->type = BOOLEAN_T;
+                                    returnValue->name = NULL;
+                                    returnValue->node = createLogicalNode("OR", $1->node, $3->node);
                                     $$ = returnValue;
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                    
-                                 }
-    | expression '&&' expression {
+                                }
+    | expression '&' expression {
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
+
                                     checkBothParamsAreBoolean(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("AND", expr1Name, expr2Name, tempVar);
 
                                     returnValue->type = BOOLEAN_T;
-                                    returnValue->name = tempVar;
+                                    returnValue->name = NULL;
+                                    returnValue->node = createLogicalNode("AND", $1->node, $3->node);
                                     $$ = returnValue;
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                    
-                                 }
-    | expression '<' expression  {
+                                }
+    | expression '<' expression {
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("LT", expr1Name, expr2Name, tempVar);
-                                                  
+
                                     returnValue->type = BOOLEAN_T;
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                    
-                                 }
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("LT", $1->node, $3->node);
+                                    $$ = returnValue;
+                                }
     | expression '>' expression {
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("GT", expr1Name, expr2Name, tempVar);
 
                                     returnValue->type = BOOLEAN_T;
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-  
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                    
-                                 }
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("GT", $1->node, $3->node);
+                                    $$ = returnValue;
+                                }
     | expression GE expression  {
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("GTE", expr1Name, expr2Name, tempVar);
 
                                     returnValue->type = BOOLEAN_T;
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                    
-                                 }
-    | expression LE expression    {
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("GTE", $1->node, $3->node);
+                                    $$ = returnValue;
+                                }
+    | expression LE expression  {
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreNumbers(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("LTE", expr1Name, expr2Name, tempVar);
-                                    
-                                
 
                                     returnValue->type = BOOLEAN_T;
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                    
-                                 }
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("LTE", $1->node, $3->node);
+                                    $$ = returnValue;
+                                }
     | expression EQ expression  {
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreOfSameType(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("EQ", expr1Name, expr2Name, tempVar);
-                                                         
-                                    returnValue->type = BOOLEAN_T;
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
 
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                    
-                                 }
+                                    returnValue->type = BOOLEAN_T;
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("EQ", $1->node, $3->node);
+                                    $$ = returnValue;
+                                }
     | expression NE expression  {
                                     Type expr1Type = $1->type;
                                     Type expr2Type = $3->type;
-                                    const char* tempVar = newTemp();
-                                    const char* expr1Name = $1->name;
-                                    const char* expr2Name = $3->name;
-                                    ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                    ExprValue* returnValue = newExprValue();
 
                                     checkBothParamsAreOfSameType(expr1Type,expr2Type,yylineno);
-                                    addQuadrupleToCurrentQuadManager("NEQ", expr1Name, expr2Name, tempVar);
-    
 
                                     returnValue->type = BOOLEAN_T;
-                                    returnValue->name = tempVar;
-                                    $$ = returnValue;  
-
-                                    
-                                    debugPrintf("Name of first expression: %s\n", expr1Name);
-                                    debugPrintf("Name of second expression: %s\n", expr2Name);
-                                 }
-    
-    
+                                    returnValue->name = NULL;
+                                    returnValue->node = createBinaryNode("NEQ", $1->node, $3->node);
+                                    $$ = returnValue;
+                                }
     ;
-
 functionCall:
     VARIABLE '(' parameters ')'     {
-                                        const char* functionName = strdup($1);
+                                        const char* functionName = copyValueText($1);
                                         void* function = getSymbolFromSymbolTable(functionName,yylineno);
                                         void* parametersList = $3;
                                         checkParamListAgainstFunction(parametersList,function,yylineno);
-                                        ExprValue *returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                        ExprValue *returnValue = newExprValue();
                                         
                                         returnValue->type = getSymbolType(function);
-                                        returnValue->name = newTemp();
-
-                                        handleFunctionCallQuadruples(function,parametersList,returnValue->name);
+                                        returnValue->name = NULL;
+                                        returnValue->node = createCallNode(function,parametersList);
                                         
                                         $$ = returnValue;
                                     }
@@ -716,10 +546,10 @@ argumentsList:
                                                     addVariableToArgumentList(argumentList,variable);
                                                     $$ = argumentList;
                                                 }
-    | dataType VARIABLE ',' argumentsList       {
-                                                    void* variable = createVariable($1,$2, yylineno,0);
-                                                    addVariableToArgumentList($4,variable);
-                                                    $$ = $4;
+    | argumentsList ',' dataType VARIABLE       {
+                                                    void* variable = createVariable($3,$4, yylineno,0);
+                                                    addVariableToArgumentList($1,variable);
+                                                    $$ = $1;
                                                 }
     ;
 
@@ -729,18 +559,18 @@ parameters:
     ;
 
 parametersList:
-    expression ',' parametersList           {   void* paramList = $3; 
-                                                Type paramType = $1->type;
-                                                const char* paramName = $1->name;
-                                                addParamToParamList(paramList,paramName,paramType);
+    parametersList ',' expression           {   void* paramList = $1; 
+                                                Type paramType = $3->type;
+                                                void* paramNode = $3->node;
+                                                addParamToParamList(paramList,paramNode,paramType);
                                                 $$ = paramList;
                                             }
 
     | expression                        {   
                                             void* paramList = createParamList(); 
                                             Type paramType = $1->type;
-                                            const char* paramName = $1->name;
-                                            addParamToParamList(paramList,paramName,paramType);
+                                            void* paramNode = $1->node;
+                                            addParamToParamList(paramList,paramNode,paramType);
                                             $$ = paramList; 
                                         }
                                             
@@ -752,53 +582,25 @@ case:
                                                 void* caseList = createSwitchCaseList();
                                                 Type caseType = caseValue->type;
                                                 int caseLine = caseValue->line;
-                                                addCaseToSwitchCaseList(caseList,caseType,caseLine);
+                                                void* scope = $4;
+                                                addCaseToSwitchCaseList(caseList,caseType,caseLine,caseValue->name,scope);
                                                 $$ = caseList;
-
-                                                void* quadManager = $4;
-                                                const char* exitLabel = generateNewExitLabelFromCurrentQuadManager();
-                                                const char* label = newLabel();
-                                                const char* caseExpression = getCurrentCaseExpression();
-                                                
-                                                const char* tempVar = newTemp();
-                                                addQuadrupleToQuadManagerInFront(quadManager,"JF", tempVar, "", label);
-                                                addQuadrupleToQuadManagerInFront(quadManager,"EQ", caseExpression, caseValue->name, tempVar);
-
-                                                addQuadrupleToQuadManager(quadManager,"JMP", "", "", exitLabel);
-                                                addQuadrupleToQuadManager(quadManager,label, "", "", "");
-
-                                                mergeQuadManagerToCurrentQuadManagerInFront(quadManager);
                                             }
-    | CASE caseCondition ':' scope case     {
-                                                ExprValue* caseValue = $2;
-                                                void* caseList = $5;
+    | case CASE caseCondition ':' scope     {
+                                                ExprValue* caseValue = $3;
+                                                void* caseList = $1;
                                                 Type caseType = caseValue->type;
                                                 int caseLine = caseValue->line;
-                                                addCaseToSwitchCaseList(caseList,caseType,caseLine);
+                                                void* scope = $5;
+                                                addCaseToSwitchCaseList(caseList,caseType,caseLine,caseValue->name,scope);
                                                 $$ = caseList;
-
-                                                void* quadManager = $4;
-                                                const char* exitLabel = getExitLabelFromCurrentQuadManager();
-                                                const char* label = newLabel();
-                                                const char* caseExpression = getCurrentCaseExpression();
-                                                
-                                                const char* tempVar = newTemp();
-                                                addQuadrupleToQuadManagerInFront(quadManager,"JF", tempVar, "", label);
-                                                addQuadrupleToQuadManagerInFront(quadManager,"EQ", caseExpression, caseValue->name, tempVar);
-
-                                                addQuadrupleToQuadManager(quadManager,"JMP", "", "", exitLabel);
-                                                addQuadrupleToQuadManager(quadManager,label, "", "", "");
-                                                
-                                                mergeQuadManagerToCurrentQuadManagerInFront(quadManager);
                                             }
     ;
 
 caseCondition:
     CHARACTER                       {   
-                                        char* val = malloc(sizeof(char)*2);
-                                        val[0] = $1;
-                                        val[1] = '\0';
-                                        ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                        const char* val = copyCharText($1);
+                                        ExprValue* returnValue = newExprValue();
                                         returnValue->line = yylineno;
                                         returnValue->type = CHAR_T;
                                         ;
@@ -806,8 +608,8 @@ caseCondition:
                                         $$ = returnValue;
                                     }
     | INTEGER                       {
-                                        const char* val = strdup(convertIntNumToChar($1));
-                                        ExprValue* returnValue = (ExprValue*)malloc(sizeof(ExprValue));
+                                        const char* val = convertIntNumToChar($1);
+                                        ExprValue* returnValue = newExprValue();
                                         returnValue->line = yylineno;
                                         returnValue->type = INTEGER_T;
                                         returnValue->name = val;
@@ -820,38 +622,124 @@ caseCondition:
 void yyerror(char *s) {
     static char buffer[1024];
     sprintf(buffer, "Error: %s at line %d, near '%s'\n", s, yylineno, yytext);
+    finishOutputWriter();  // what was parsed before the error is written first, as without --pipeline
     fprintf(stderr, "%s", buffer);
     printExitMsgToFile(buffer);
-    exit(1);
+    exitCompiler(1);
 }
 
-// pass argument in command line
-// example: ./parser.exe input.txt
-int main(int argc, char **argv) {
-    yydebug = 0;
-    // yydebug = 1;
+// Compiles one input file with the options of the command line, returns the exit status of the compiler
+static int compileFile(const char* fileName) {
+    inputFileName = fileName;
 
-    if(argc != 2) {
-        debugPrintf("Usage: %s <input file>\n", argv[0]);
-        return 1;
+    // without a file name the profile is named after the input
+    if(compilerOptions.profileGeneratePath && !compilerOptions.profileGeneratePath[0]) {
+        compilerOptions.profileGeneratePath = getOutputFileName(inputFileName, "_branch_profile.txt");
+    }
+    if(compilerOptions.profileUsePath && !compilerOptions.profileUsePath[0]) {
+        compilerOptions.profileUsePath = getOutputFileName(inputFileName, "_branch_profile.txt");
     }
 
+    if(compilerOptions.timeReport) {
+        startTimeReport();
+    }
+    if(compilerOptions.memReport) {
+        startMemoryReport();
+    }
     // Open the input file
-    inputFileName = argv[1];
     yyin = fopen(inputFileName, "r");
     if(yyin == NULL) {
-        debugPrintf("Error: Unable to open input file %s\n", argv[1]);
+        debugPrintf("Error: Unable to open input file %s\n", inputFileName);
         return 1;
     }
     
-    // Call the parser
-    printf("Compiling input file: %s\n", inputFileName);
+    // the token stream alone, which is what the flex and the fast scanner are compared on
+    if(compilerOptions.dumpTokens) {
+        int token;
+        while((token = yylex()) != 0) {
+            printf("%d %s %s\n", yylineno, yytname[YYTRANSLATE(token)], yytext);
+        }
+        printf("%d end of input\n", yylineno);
+        fclose(yyin);
+        return 0;
+    }
+
+    // Call the parser; a module compiled for an import leaves the output of the importing compilation alone
+    if(!compilerOptions.emitInterface) {
+        printf("Compiling input file: %s\n", inputFileName);
+    }
+    if(compilerOptions.stream) {
+        beginQuadrupleStream(inputFileName);
+    }
+    PROFILE_BEGIN(PHASE_PARSE);
     yyparse();
+    PROFILE_END(PHASE_PARSE);
+    if(compilerOptions.emitInterface) {
+        writeModuleInterface(inputFileName);
+        fclose(yyin);
+        return 0;
+    }
+    // in streaming mode every statement was already optimized when it was flushed
+    if(compilerOptions.optimize && !compilerOptions.stream) {
+        optimizeQuadruples();
+    }
+    if(compilerOptions.optimize && compilerOptions.passTiming) {
+        printPassStatistics();
+    }
+    // the quadruples of a streamed program are gone by now
+    if(compilerOptions.callGraphPath && !compilerOptions.stream) {
+        writeCallGraph(compilerOptions.callGraphPath);
+    }
+    if(compilerOptions.emitC && !compilerOptions.stream) {
+        writeCProgram(inputFileName);
+    }
     printSymbolTable(inputFileName);
     printQuadruples(inputFileName);
     printUnusedSymbols(inputFileName);
+    finishOutputWriter();
+    if(compilerOptions.timeReport) {
+        printTimeReport(compilerOptions.timeReport == 2);
+    }
+    if(compilerOptions.memReport) {
+        printMemoryReport();
+    }
+    int exitCode = 0;
+    if(compilerOptions.run && !compilerOptions.stream) {
+        exitCode = runProgram(inputFileName);
+    }
     
     // Close the input file
     fclose(yyin);
-    return 0;
+    return exitCode;
+}
+
+// pass argument in command line
+// example: ./parser.exe [-O] [-j<threads>] [--pass-timing] [--time-report[=json]] [--call-graph=calls.dot] input.txt
+int main(int argc, char **argv) {
+    yydebug = 0;
+    // yydebug = 1;
+
+    inputFileName = NULL;
+    compilerPath = argv[0];
+    for(int i = 1; i < argc; i++) {
+        if(argv[i][0] == '-') {
+            if(!parseCompilerOption(argv[i])) {
+                printf("Unknown option %s\n", argv[i]);
+                return 1;
+            }
+        } else {
+            inputFileName = argv[i];
+        }
+    }
+
+    if(inputFileName == NULL) {
+        debugPrintf("Usage: %s [options] <input file>\n", argv[0]);
+        return 1;
+    }
+
+    // the input file lists the programs, each one is compiled by a child process of this one
+    if(compilerOptions.batch) {
+        return runBatch(inputFileName, compileFile);
+    }
+    return compileFile(inputFileName);
 }
\ No newline at end of file